@@ -26,6 +26,7 @@ set(FREERTOS_KERNEL_PATH ${FREERTOS_KERNEL_PATH} CACHE PATH "Path to the FreeRTO
 add_library(FreeRTOS-Kernel STATIC
     ${FREERTOS_KERNEL_PATH}/list.c
     ${FREERTOS_KERNEL_PATH}/queue.c
+    ${FREERTOS_KERNEL_PATH}/stream_buffer.c
     ${FREERTOS_KERNEL_PATH}/tasks.c
     ${FREERTOS_KERNEL_PATH}/timers.c
     ${FREERTOS_KERNEL_PATH}/portable/MemMang/heap_3.c
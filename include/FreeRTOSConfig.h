@@ -69,11 +69,7 @@
 #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
 
 /* Memory allocation related definitions. */
-#if !PICO_NO_HARDWARE
 #define configSUPPORT_STATIC_ALLOCATION         1
-#else
-#define configSUPPORT_STATIC_ALLOCATION         0
-#endif
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
 #define configTOTAL_HEAP_SIZE                   (128*1024)
 #define configAPPLICATION_ALLOCATED_HEAP        0
@@ -0,0 +1,147 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Selection between redundant radio links
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <array>
+#include <pico/stdlib.h>
+
+#include "channels.h"
+#include "receiver.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief Picks the healthiest of N receivers, frame by frame
+     *
+     * A link is healthy when it is in sync, the receiver reports neither frame
+     * lost nor failsafe, and its last control frame is no older than the max
+     * age. Frame age is what notices a dead link first, long before the
+     * receiver gives up on sync.
+     *
+     * Of the healthy links the one with the best RSSI is used, but the current
+     * link is kept until another beats it by the hysteresis, so two links with
+     * about the same signal don't make the output flip between them. Without a
+     * healthy link, a link that is still in sync and not in failsafe is
+     * preferred, and otherwise the current link is kept.
+     *
+     * Call select() for every new frame, from any link.
+     */
+    template<size_t N>
+    class LinkArbiter {
+        public:
+            using links_type = std::array<Channels, N>;
+            using receivers_type = std::array<const Receiver*, N>;
+
+            static constexpr int64_t DEFAULT_MAX_AGE_US { 50000 }; // A few missed frames, well within the receiver SYNC_TIMEOUT
+            static constexpr uint DEFAULT_RSSI_HYSTERESIS { 10 };
+
+            LinkArbiter(int64_t max_age_us=DEFAULT_MAX_AGE_US, uint rssi_hysteresis=DEFAULT_RSSI_HYSTERESIS) :
+                m_max_age_us { max_age_us },
+                m_rssi_hysteresis { rssi_hysteresis },
+                m_current { 0 },
+                m_switches { 0 },
+                m_switch_time { nil_time }
+            {
+                static_assert(N>0, "No links");
+            }
+
+            /**
+             * @brief Index of the link to use, given a snapshot of each link
+             */
+            size_t select(const links_type &links, absolute_time_t now)
+            {
+                size_t best = (m_current+1) % N;
+                for (size_t n=2; n<N; ++n) {
+                    size_t i = (m_current+n) % N;
+                    if (better(links[i], links[best], now)) {
+                        best = i;
+                    }
+                }
+
+                if (best!=m_current && replaces(links[best], links[m_current], now)) {
+                    m_current = best;
+                    m_switches++;
+                    m_switch_time = now;
+                }
+                m_channels = links[m_current];
+                return m_current;
+            }
+
+            size_t select(const receivers_type &receivers, absolute_time_t now)
+            {
+                links_type links;
+                for (size_t i=0; i<N; ++i) {
+                    links[i] = receivers[i]->channels();
+                }
+                return select(links, now);
+            }
+
+            size_t current() const { return m_current; }
+            const Channels &channels() const { return m_channels; } // Of the current link, as of the last select()
+
+            bool healthy(const Channels &link, absolute_time_t now) const
+            {
+                return link.sync() && !link.flags().frameLost() && !link.flags().failsafe() &&
+                    !is_nil_time(link.time()) && absolute_time_diff_us(link.time(), now)<=m_max_age_us;
+            }
+
+            // Stats
+            uint switches() const { return m_switches; }
+            absolute_time_t switch_time() const { return m_switch_time; }
+
+        private:
+            const int64_t m_max_age_us;
+            const uint m_rssi_hysteresis;
+
+            size_t m_current;
+            Channels m_channels;
+
+            uint m_switches;
+            absolute_time_t m_switch_time;
+
+            /**
+             * @brief 2 healthy, 1 in sync and not in failsafe, 0 neither
+             */
+            uint health(const Channels &link, absolute_time_t now) const
+            {
+                if (healthy(link, now)) {
+                    return 2;
+                }
+                return link.sync() && !link.flags().failsafe() ? 1 : 0;
+            }
+
+            /**
+             * @brief Ranking of the candidates, the current link is not one of them
+             */
+            bool better(const Channels &a, const Channels &b, absolute_time_t now) const
+            {
+                if (health(a, now)!=health(b, now)) {
+                    return health(a, now)>health(b, now);
+                }
+                if (a.rssi()!=b.rssi()) {
+                    return a.rssi()>b.rssi();
+                }
+                return absolute_time_diff_us(b.time(), a.time())>0;
+            }
+
+            /**
+             * @brief Should candidate take over from the current link
+             */
+            bool replaces(const Channels &candidate, const Channels &current, absolute_time_t now) const
+            {
+                uint candidate_health = health(candidate, now);
+                uint current_health = health(current, now);
+                if (candidate_health!=current_health) {
+                    return candidate_health>current_health;
+                }
+                return candidate_health==2 && candidate.rssi()>current.rssi()+m_rssi_hysteresis;
+            }
+    };
+
+}
@@ -9,6 +9,8 @@
 #pragma once
 
 #include <array>
+#include <algorithm>
+#include <stdint.h>
 #include <pico/stdlib.h>
 
 namespace FBus2 {
@@ -25,10 +27,17 @@ namespace FBus2 {
             static constexpr uint SERVO_MIN { 500 };
             static constexpr uint SERVO_MAX { 2500 };
 
+            // Fixed point, so the RP2040 doesn't need soft float or a division
+            using q15_type = int16_t;    // -1.0..1.0 as -32768..32767, like asFloat()
+            using uq16_type = uint16_t;  // 0.0..1.0 as 0..65535, like asPercent()
+            using servo_table_type = std::array<uint16_t, CHANNEL_RANGE+1>;
+
             static const ChannelValue CENTER;
             static const ChannelValue MIN;
             static const ChannelValue MAX;
 
+            static const servo_table_type SERVO_PULSE_TABLE; // Pulse for each value in CHANNEL_MIN..CHANNEL_MAX
+
             constexpr ChannelValue() : m_value { CHANNEL_CENTER } {}
             constexpr ChannelValue(raw_type value) : m_value { value } { }
             constexpr ChannelValue(const ChannelValue &other) : m_value { other.m_value } { }
@@ -44,19 +53,50 @@ namespace FBus2 {
 
             constexpr raw_type raw() const { return m_value; }
             
-            uint  asServoPulse() const           { return SERVO_MIN+static_cast<uint>(m_value-CHANNEL_MIN)*(SERVO_MAX-SERVO_MIN)/(CHANNEL_MAX-CHANNEL_MIN); }
+            uint  asServoPulse() const           { return SERVO_PULSE_TABLE[clamped()-CHANNEL_MIN]; }
             float asPercent() const              { return static_cast<float>(m_value-CHANNEL_MIN)/CHANNEL_RANGE; }
             float asFloat() const                { return static_cast<float>((2.0f*(static_cast<int32_t>(m_value)-CHANNEL_CENTER)))/CHANNEL_RANGE; }
             uint  asButton(uint positions) const { auto range = CHANNEL_RANGE/(positions-1); return (m_value-CHANNEL_MIN+range/2) / range; }
             bool  asToggle() const               { return asButton(2); }
 
+            // Fixed point versions of asFloat() and asPercent(), clamped to the channel range
+            q15_type  asQ15() const
+            {
+                int32_t q = (static_cast<int32_t>(clamped()-CHANNEL_CENTER)*Q15_SCALE+(1<<(Q15_SHIFT-1))) >> Q15_SHIFT;
+                return static_cast<q15_type>(std::clamp<int32_t>(q, INT16_MIN, INT16_MAX));
+            }
+            uq16_type asUQ16() const
+            {
+                return static_cast<uq16_type>((static_cast<uint32_t>(clamped()-CHANNEL_MIN)*UQ16_SCALE+(1u<<(UQ16_SHIFT-1))) >> UQ16_SHIFT);
+            }
+
+            static constexpr servo_table_type make_servo_table()
+            {
+                servo_table_type table {};
+                for (uint i=0; i<table.size(); ++i) {
+                    table[i] = static_cast<uint16_t>(SERVO_MIN+i*(SERVO_MAX-SERVO_MIN)/CHANNEL_RANGE);
+                }
+                return table;
+            }
+
         private:
+            // x/CHANNEL_RANGE as a multiply and a shift, with the most bits that can't overflow
+            static constexpr uint Q15_SHIFT { 14 };
+            static constexpr int32_t Q15_SCALE { static_cast<int32_t>(((2ll << (15+Q15_SHIFT))+CHANNEL_RANGE/2)/CHANNEL_RANGE) };
+            static constexpr uint UQ16_SHIFT { 15 };
+            static constexpr uint32_t UQ16_SCALE { static_cast<uint32_t>((65535ull*(1ull << UQ16_SHIFT)+CHANNEL_RANGE/2)/CHANNEL_RANGE) };
+            static_assert(static_cast<int64_t>(CHANNEL_MAX-CHANNEL_CENTER)*Q15_SCALE+(1<<Q15_SHIFT) <= INT32_MAX, "Q15 overflow");
+            static_assert(static_cast<uint64_t>(CHANNEL_RANGE)*UQ16_SCALE+(1u<<UQ16_SHIFT) <= UINT32_MAX, "UQ16 overflow");
+
             raw_type m_value;
+
+            constexpr raw_type clamped() const { return std::clamp(m_value, CHANNEL_MIN, CHANNEL_MAX); }
     };
 
     constexpr ChannelValue ChannelValue::CENTER { ChannelValue::CHANNEL_CENTER };
     constexpr ChannelValue ChannelValue::MIN    { ChannelValue::CHANNEL_MIN };
     constexpr ChannelValue ChannelValue::MAX    { ChannelValue::CHANNEL_MAX };
+    inline constexpr ChannelValue::servo_table_type ChannelValue::SERVO_PULSE_TABLE { ChannelValue::make_servo_table() };
 
 
     class Flags {
@@ -83,6 +123,8 @@ namespace FBus2 {
             bool operator!=(const Flags &other) { return m_value!=other.m_value; }
             bool operator!=(const value_type value) { return m_value!=value; }
 
+            constexpr value_type value() const { return m_value; }
+
             inline bool ch17() const { return m_value & CH17_MASK; }
             inline bool ch18() const { return m_value & CH18_MASK; }
             inline bool frameLost() const { return m_value & FRAME_LOST_MASK; }
@@ -104,10 +146,11 @@ namespace FBus2 {
             static constexpr size_t MAX_CHANNELS { 24 };
             static constexpr size_t INITIAL_COUNT { 16 };
 
-            Channels() : m_sync { false }, m_seq{ 0 }, m_rssi { 0 }, m_count { INITIAL_COUNT } { }
+            Channels() : m_sync { false }, m_seq{ 0 }, m_time { nil_time }, m_rssi { 0 }, m_count { INITIAL_COUNT } { }
 
             bool sync() const { return m_sync; }
             uint seq() const { return m_seq; }
+            absolute_time_t time() const { return m_time; } // When the frame was received
 
             const flag_type &flags() const { return m_flags; }
             const rssi_type &rssi() const  { return m_rssi; }
@@ -123,6 +166,7 @@ namespace FBus2 {
             void set_rssi(uint8_t rssi) { m_rssi = rssi; }
             void set_sync(bool sync) { m_sync = sync; }
             void set_seq(uint seq) { m_seq = seq; }
+            void set_time(absolute_time_t time) { m_time = time; }
 
             const_iterator begin() const noexcept { return m_data.begin(); }
             const_iterator end() const noexcept { return m_data.begin()+m_count; }
@@ -132,6 +176,7 @@ namespace FBus2 {
 
             bool      m_sync;
             uint      m_seq;
+            absolute_time_t m_time;
             flag_type m_flags;
             rssi_type m_rssi;
 
@@ -141,5 +186,96 @@ namespace FBus2 {
 
 
 
+    /**
+     * @brief What changed since the last delivered frame
+     *
+     * Bit n for channel n, and LINK for sync or flags.
+     */
+    class ChangeMask {
+        public:
+            using value_type = uint32_t;
+
+            static constexpr value_type LINK { 1u<<31 };
+            static constexpr value_type ALL  { ~0u };
+
+            static constexpr value_type channel_bit(size_t n) { return 1u<<n; }
+
+            constexpr ChangeMask() : m_value { 0 } {}
+            constexpr ChangeMask(value_type value) : m_value { value } {}
+
+            constexpr value_type value() const { return m_value; }
+            constexpr bool none() const { return m_value==0; }
+            constexpr bool any() const { return m_value!=0; }
+            constexpr bool any(value_type mask) const { return (m_value & mask)!=0; }
+            constexpr bool channel(size_t n) const { return any(channel_bit(n)); }
+            constexpr bool link() const { return any(LINK); }
+
+        private:
+            value_type m_value;
+    };
+
+
+    /**
+     * @brief Per channel deadband change detection
+     *
+     * A channel is changed when it has moved more than its deadband from the
+     * value it had when it was last reported as changed, so jitter at rest is
+     * filtered, but a slow drift is still reported once it adds up.
+     */
+    class ChangeTracker {
+        public:
+            using raw_type = ChannelValue::raw_type;
+
+            static constexpr raw_type DEFAULT_DEADBAND { 2 };
+
+            static_assert(Channels::MAX_CHANNELS<31, "Channel bits must not overlap the LINK bit");
+
+            ChangeTracker() 
+            { 
+                m_deadband.fill(DEFAULT_DEADBAND);
+                reset(); 
+            }
+
+            void set_deadband(size_t n, raw_type deadband) { m_deadband[n] = deadband; }
+            void reset() { m_valid = false; }  // Report everything as changed next time
+
+            ChangeMask update(const Channels &channels)
+            {
+                if (!m_valid || channels.count()!=m_count) {
+                    m_valid = true;
+                    m_count = channels.count();
+                    for (size_t n=0; n<m_count; ++n) {
+                        m_reference[n] = channels[n].raw();
+                    }
+                    m_sync = channels.sync();
+                    m_flags = channels.flags().value();
+                    return ChangeMask::ALL;
+                }
+
+                ChangeMask::value_type mask = 0;
+                for (size_t n=0; n<m_count; ++n) {
+                    raw_type value = channels[n].raw();
+                    raw_type diff = value>m_reference[n] ? value-m_reference[n] : m_reference[n]-value;
+                    if (diff>m_deadband[n]) {
+                        m_reference[n] = value;
+                        mask |= ChangeMask::channel_bit(n);
+                    }
+                }
+                if (channels.sync()!=m_sync || channels.flags().value()!=m_flags) {
+                    m_sync = channels.sync();
+                    m_flags = channels.flags().value();
+                    mask |= ChangeMask::LINK;
+                }
+                return mask;
+            }
+
+        private:
+            std::array<raw_type, Channels::MAX_CHANNELS> m_reference;
+            std::array<raw_type, Channels::MAX_CHANNELS> m_deadband;
+            size_t m_count;
+            bool m_sync;
+            Flags::value_type m_flags;
+            bool m_valid;
+    };
 
 };
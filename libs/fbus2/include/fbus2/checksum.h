@@ -0,0 +1,91 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Running FBus2 checksum of received data
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <pico/stdlib.h>
+
+namespace FBus2 {
+
+    /**
+     * @brief Running sum of every received byte, kept by the rx ISR
+     *
+     * For each received byte the sum of all bytes up to and including it is
+     * stored, indexed by the byte's position in the stream. The checksum of any
+     * range still in the buffers is then the difference of two stored sums, so
+     * validating a frame is O(1) no matter its size.
+     *
+     * The ISR calls prepare() before handing the byte on, and commit() once it
+     * has been accepted. The sum for a position is written before the byte can be
+     * seen by the receiver task, and a byte that is dropped is never counted.
+     *
+     * SIZE must be larger than the number of bytes that can be buffered between
+     * the ISR and the frame being validated. Sums are 16 bit, which is exact
+     * for ranges up to 257 bytes.
+     */
+    template<size_t SIZE>
+    class ChecksumTracker {
+        public:
+            using pos_type = uint32_t;
+            using sum_type = uint16_t;
+
+            ChecksumTracker()
+            {
+                static_assert((SIZE & MASK)==0u, "Tracker size must be 2^n");
+                reset();
+            }
+
+            void reset()
+            {
+                m_pos = 0;
+                m_sum = 0;
+                m_sums[0] = 0;
+            }
+
+            // ISR side
+            inline void prepare(uint8_t b) { m_sums[(m_pos+1)&MASK] = m_sum+b; }
+            inline void commit()           { m_pos++; m_sum = m_sums[m_pos&MASK]; }
+            inline void push(uint8_t b)    { prepare(b); commit(); }
+
+            inline void prepare(const uint8_t *data, size_t len)
+            {
+                sum_type sum = m_sum;
+                for (size_t i=0; i<len; ++i) {
+                    sum += data[i];
+                    m_sums[(m_pos+1+i)&MASK] = sum;
+                }
+            }
+            inline void commit(size_t len) { m_pos += len; m_sum = m_sums[m_pos&MASK]; }
+
+            pos_type pos() const { return m_pos; }
+
+            // Receiver side
+            /**
+             * @brief Checksum of len bytes starting at stream position begin
+             */
+            uint8_t checksum(pos_type begin, size_t len) const
+            {
+                return fold(static_cast<sum_type>(m_sums[(begin+len)&MASK]-m_sums[begin&MASK]));
+            }
+
+            static constexpr uint8_t fold(sum_type sum)
+            {
+                sum = (sum & 0xFF) + (sum >> 8);
+                sum = (sum & 0xFF) + (sum >> 8);
+                return 0xFF - sum;
+            }
+
+        private:
+            static constexpr size_t MASK { SIZE-1 };
+
+            sum_type m_sums[SIZE];
+            volatile pos_type m_pos;
+            sum_type m_sum;
+    };
+
+}
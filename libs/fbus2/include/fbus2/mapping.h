@@ -12,72 +12,94 @@
 #include <pico/stdlib.h>
 
 #include "channels.h"
+#include "mapping_table.h"
 
 namespace FBus2 {
 
-    enum class Toggle : uint {
-        P0 = 0,
-        P1 = 1,
-        P2 = 2,
-    };
-
-
-    class TaranisX9DPlus {
+    /**
+     * @brief Channel layout of the Taranis X9D Plus
+     *
+     * A toggle switch and 3x 3 way switches are mixed into each of channel 8
+     * and 9, by setting scale of 32, 1, 4, 16, effectively mapping them into
+     * a bitfield. By trial and error (and spreadsheets) I have worked out a
+     * formula that maps the values to a 7 bit value with 2 bits per 3 way
+     * switch and one bit for the toggle.
+     */
+    namespace TaranisX9DPlusLayout {
+        enum Field : size_t {
+            LEFT_X, LEFT_Y, RIGHT_X, RIGHT_Y,
+            S1, S2, SLIDER_L, SLIDER_R,
+            SA, SB, SE, SF,
+            SC, SD, SG, SH,
+            SI,
+            FIELDS
+        };
+
+        inline constexpr MappingTable<FIELDS> TABLE { 
+            {
+                MappingField::axis(0),
+                MappingField::axis(1),
+                MappingField::axis(2),
+                MappingField::axis(3),
+
+                MappingField::axis(4),
+                MappingField::axis(5),
+                MappingField::axis(6),
+                MappingField::axis(7),
+
+                MappingField::packed(8, 0, 2, static_cast<uint16_t>(Toggle::P1)),
+                MappingField::packed(8, 2, 2),
+                MappingField::packed(8, 4, 2),
+                MappingField::packed(8, 6, 1),
+
+                MappingField::packed(9, 0, 2),
+                MappingField::packed(9, 2, 2),
+                MappingField::packed(9, 4, 2),
+                MappingField::packed(9, 6, 1),
+
+                MappingField::button(10, 2),
+            },
+            { 471, 98, 16, 10 }  // base, divisor, offset, scale
+        };
+    }
+
+
+    class TaranisX9DPlus : public TableMapping<TaranisX9DPlusLayout::TABLE> {
         public:
-            TaranisX9DPlus();
+            using Field = TaranisX9DPlusLayout::Field;
+
+            // Channels of each control group, for ChangeMask
+            static constexpr ChangeMask::value_type STICKS   { channel_bit(Field::LEFT_X)|channel_bit(Field::LEFT_Y)|channel_bit(Field::RIGHT_X)|channel_bit(Field::RIGHT_Y) };
+            static constexpr ChangeMask::value_type DIALS    { channel_bit(Field::S1)|channel_bit(Field::S2) };
+            static constexpr ChangeMask::value_type SLIDERS  { channel_bit(Field::SLIDER_L)|channel_bit(Field::SLIDER_R) };
+            static constexpr ChangeMask::value_type SWITCHES { channel_bit(Field::SA)|channel_bit(Field::SC)|channel_bit(Field::SI) };  // sa, sb, se, sf | sc, sd, sg, sh | si
 
             // Axis
-            ChannelValue left_x() const { return m_left_x; }
-            ChannelValue left_y() const { return m_left_y; }
-            ChannelValue right_x() const { return m_right_x; }
-            ChannelValue right_y() const { return m_right_y; }
+            ChannelValue left_x() const { return axis(Field::LEFT_X); }
+            ChannelValue left_y() const { return axis(Field::LEFT_Y); }
+            ChannelValue right_x() const { return axis(Field::RIGHT_X); }
+            ChannelValue right_y() const { return axis(Field::RIGHT_Y); }
 
             // Dials and sliders
-            ChannelValue s1() const { return m_s1; }// Left front dial
-            ChannelValue s2() const { return m_s2; }// Right front dial
-            ChannelValue slider_l() const { return m_slider_l; } // Left side slider
-            ChannelValue slider_r() const { return m_slider_r; } // Right side slider
+            ChannelValue s1() const { return axis(Field::S1); }// Left front dial
+            ChannelValue s2() const { return axis(Field::S2); }// Right front dial
+            ChannelValue slider_l() const { return axis(Field::SLIDER_L); } // Left side slider
+            ChannelValue slider_r() const { return axis(Field::SLIDER_R); } // Right side slider
 
             // Buttons
-            Toggle sa() const { return m_sa; }; // 3 way toggle (left front L)
-            Toggle sb() const { return m_sb; }; // 3 way toggle (left front R)
-            Toggle sc() const { return m_sc; }; // 3 way toggle (right front L)
-            Toggle sd() const { return m_sd; }; // 3 way toggle (right front R)
-            Toggle se() const { return m_se; }; // 3 way toggle (left top front) 
-            bool   sf() const { return m_sf; }; // 2 way toggle (left top rear) 
-            Toggle sg() const { return m_sg; }; // 3 way toggle (right top front) 
-            bool   sh() const { return m_sh; }; // 2 way toggle (right top rear), momentary
-            bool   si() const { return m_si; }; // top button, momentary
-
-            void set(const Channels &channels);
-            void set_lost_sync(Channels &channels);
+            Toggle sa() const { return toggle(Field::SA); }; // 3 way toggle (left front L)
+            Toggle sb() const { return toggle(Field::SB); }; // 3 way toggle (left front R)
+            Toggle sc() const { return toggle(Field::SC); }; // 3 way toggle (right front L)
+            Toggle sd() const { return toggle(Field::SD); }; // 3 way toggle (right front R)
+            Toggle se() const { return toggle(Field::SE); }; // 3 way toggle (left top front) 
+            bool   sf() const { return flag(Field::SF); }; // 2 way toggle (left top rear) 
+            Toggle sg() const { return toggle(Field::SG); }; // 3 way toggle (right top front) 
+            bool   sh() const { return flag(Field::SH); }; // 2 way toggle (right top rear), momentary
+            bool   si() const { return flag(Field::SI); }; // top button, momentary
 
             #ifndef NDEBUG
             void print() const;
             #endif
-
-        private:
-            ChannelValue m_left_x;
-            ChannelValue m_left_y;
-            ChannelValue m_right_x;
-            ChannelValue m_right_y;
-
-            ChannelValue m_s1;
-            ChannelValue m_s2;
-            ChannelValue m_slider_l;
-            ChannelValue m_slider_r;
-
-            Toggle m_sa;
-            Toggle m_sb;
-            Toggle m_sc;
-            Toggle m_sd;
-            Toggle m_se;
-            bool   m_sf;
-            Toggle m_sg;
-            bool   m_sh;
-            bool   m_si;
-
-
     };
 
 }
@@ -0,0 +1,180 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Declarative transmitter channel mapping
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <pico/stdlib.h>
+
+#include "channels.h"
+
+namespace FBus2 {
+
+    enum class Toggle : uint {
+        P0 = 0,
+        P1 = 1,
+        P2 = 2,
+    };
+
+
+    /**
+     * @brief One control of the transmitter, and where it is in the channels
+     *
+     *   AXIS    The channel value as is (sticks, dials, sliders)
+     *   BUTTON  A switch with positions evenly spread over the channel range
+     *   PACKED  A bit field of a channel that carries several switches, mixed
+     *           on the transmitter with different weights, see PackedSwitches
+     */
+    struct MappingField {
+        enum class Type : uint8_t {
+            AXIS,
+            BUTTON,
+            PACKED
+        };
+
+        Type type;
+        uint8_t channel;
+        uint8_t positions;  // BUTTON
+        uint8_t shift;      // PACKED
+        uint8_t bits;       // PACKED
+        uint16_t initial;   // Value before the first frame
+
+        static constexpr MappingField axis(uint8_t channel)
+        {
+            return { Type::AXIS, channel, 0, 0, 0, ChannelValue::CHANNEL_CENTER };
+        }
+        static constexpr MappingField button(uint8_t channel, uint8_t positions, uint16_t initial=0)
+        {
+            return { Type::BUTTON, channel, positions, 0, 0, initial };
+        }
+        static constexpr MappingField packed(uint8_t channel, uint8_t shift, uint8_t bits, uint16_t initial=0)
+        {
+            return { Type::PACKED, channel, 0, shift, bits, initial };
+        }
+    };
+
+
+    /**
+     * @brief Turns a channel carrying several mixed switches back into a bit field
+     *
+     * bits = ((max(raw, CHANNEL_MIN)-base)*scale+offset)/divisor
+     */
+    struct PackedSwitches {
+        uint base;
+        uint divisor;
+        uint offset;
+        uint scale;
+
+        constexpr uint decode(ChannelValue::raw_type raw) const
+        {
+            return ((std::max(ChannelValue::CHANNEL_MIN, raw)-base)*scale+offset)/divisor;
+        }
+    };
+
+
+    /**
+     * @brief Layout of a transmitter, FIELDS controls
+     */
+    template<size_t FIELDS>
+    struct MappingTable {
+        std::array<MappingField, FIELDS> fields;
+        PackedSwitches packed;
+
+        static constexpr size_t size() { return FIELDS; }
+    };
+
+
+    /**
+     * @brief Decodes channels into the controls of TABLE
+     *
+     * TABLE is a constexpr MappingTable, every field is decoded with its
+     * parameters as constants, so set() is straight-line code, and fields
+     * packed in the same channel share the decode.
+     */
+    template<const auto &TABLE>
+    class TableMapping {
+        public:
+            using value_type = uint16_t;
+
+            static constexpr size_t FIELDS { TABLE.size() };
+
+            TableMapping()
+            {
+                for (size_t i=0; i<FIELDS; ++i) {
+                    m_values[i] = TABLE.fields[i].initial;
+                }
+            }
+
+            void set(const Channels &channels) { decode(channels, std::make_index_sequence<FIELDS>()); }
+
+            value_type value(size_t field) const { return m_values[field]; }
+            ChannelValue axis(size_t field) const { return m_values[field]; }
+            Toggle toggle(size_t field) const { return static_cast<Toggle>(m_values[field]); }
+            bool flag(size_t field) const { return m_values[field]; }
+
+            /**
+             * @brief The channel a field is decoded from, as a ChangeMask bit
+             */
+            static constexpr ChangeMask::value_type channel_bit(size_t field) { return ChangeMask::channel_bit(TABLE.fields[field].channel); }
+
+        private:
+            std::array<value_type, FIELDS> m_values;
+
+            // Channels that carry packed switches, decoded once per frame
+            static constexpr ChangeMask::value_type packed_channels()
+            {
+                ChangeMask::value_type mask = 0;
+                for (const auto &field : TABLE.fields) {
+                    if (field.type==MappingField::Type::PACKED) {
+                        mask |= ChangeMask::channel_bit(field.channel);
+                    }
+                }
+                return mask;
+            }
+
+            static constexpr ChangeMask::value_type PACKED_CHANNELS { packed_channels() };
+
+            using packed_type = std::array<uint, Channels::MAX_CHANNELS>;
+
+            template<size_t... I>
+            void decode(const Channels &channels, std::index_sequence<I...>)
+            {
+                // Into locals first, so the stores can't alias the channels
+                packed_type packed;
+                decode_packed(channels, packed, std::make_index_sequence<Channels::MAX_CHANNELS>());
+                std::array<value_type, FIELDS> values { decode_field<I>(channels, packed)... };
+                m_values = values;
+            }
+
+            template<size_t... N>
+            static void decode_packed(const Channels &channels, packed_type &packed, std::index_sequence<N...>)
+            {
+                ((PACKED_CHANNELS & ChangeMask::channel_bit(N) ? (packed[N] = TABLE.packed.decode(channels[N].raw())) : 0), ...);
+            }
+
+            template<size_t I>
+            static value_type decode_field(const Channels &channels, const packed_type &packed)
+            {
+                constexpr MappingField field { TABLE.fields[I] };
+                if constexpr (field.type==MappingField::Type::AXIS) {
+                    return channels[field.channel].raw();
+                }
+                else if constexpr (field.type==MappingField::Type::BUTTON) {
+                    static_assert(field.positions>=2, "A button needs at least two positions");
+                    return static_cast<value_type>(channels[field.channel].asButton(field.positions));
+                }
+                else {
+                    static_assert(field.bits>0 && field.shift+field.bits<=16, "Packed field out of range");
+                    return static_cast<value_type>((packed[field.channel] >> field.shift) & ((1u<<field.bits)-1));
+                }
+            }
+    };
+
+}
@@ -0,0 +1,57 @@
+/**
+ * @author Peter Christoffersen
+ * @brief FrSky FBus2 protocol engine
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include "receiver.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief FBus2, control frames of 8, 16 or 24 channels, followed by a
+     * downlink poll and an uplink slot for telemetry
+     *
+     * Polls for any of the receiver's sensor ids are answered.
+     */
+    class FBus2Protocol {
+        public:
+            enum class State {
+                SYNCING,
+                READ_CONTROL,
+                READ_DOWNLINK,
+                WRITE_UPLINK,
+                READ_UPLINK
+            };
+
+            static constexpr LineConfig LINE { 460800 };
+
+            FBus2Protocol() : m_state { State::SYNCING }, m_uplink_id { Receiver::RECEIVER_ID } {}
+
+            State state() const { return m_state; }
+
+            void init(Receiver &rx) { begin_sync(rx); }
+            bool step(Receiver &rx);
+
+        private:
+            State m_state;
+            uint8_t m_uplink_id;  // Sensor id of the uplink to write
+
+            void begin_sync(Receiver &rx);
+            void begin_read_control()  { m_state = State::READ_CONTROL; }
+            void begin_read_downlink() { m_state = State::READ_DOWNLINK; }
+            void begin_write_uplink(uint8_t id) { m_state = State::WRITE_UPLINK; m_uplink_id = id; }
+            void begin_read_uplink()   { m_state = State::READ_UPLINK; }
+
+            bool do_sync(Receiver &rx);
+            bool do_read_control(Receiver &rx);
+            bool do_read_downlink(Receiver &rx);
+            bool do_write_uplink(Receiver &rx);
+            bool do_read_uplink(Receiver &rx);
+    };
+
+}
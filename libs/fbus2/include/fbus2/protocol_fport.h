@@ -0,0 +1,59 @@
+/**
+ * @author Peter Christoffersen
+ * @brief FrSky FPort protocol engine
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include "receiver.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief FPort, byte stuffed frames between delimiters, control frames
+     * of 16 channels, and telemetry polls answered in the uplink
+     *
+     * Frames are unstuffed from the receive window into a small frame buffer,
+     * and parsed from there. Every downlink poll for data is answered with
+     * telemetry from get_next_telemetry(), there is no sensor id on FPort,
+     * so it is asked for the first of the receiver's sensor ids.
+     */
+    class FPortProtocol {
+        public:
+            enum class State {
+                SYNCING,
+                READ_FRAME,
+                WRITE_UPLINK
+            };
+
+            static constexpr LineConfig LINE { 115200, LineConfig::Parity::NONE, 1, true };
+            static constexpr size_t MAX_FRAME_SIZE { 27 }; // Unstuffed control frame
+            static constexpr size_t MAX_STUFFED_SIZE { 2+2*MAX_FRAME_SIZE }; // With delimiters, every byte escaped
+
+            FPortProtocol() : m_state { State::SYNCING }, m_synced { false }, m_frame_size { 0 } {}
+
+            State state() const { return m_state; }
+
+            void init(Receiver &rx) { begin_sync(rx); }
+            bool step(Receiver &rx);
+
+        private:
+            State m_state;
+            bool m_synced; // A valid frame since begin_sync()
+
+            uint8_t m_frame[MAX_FRAME_SIZE];
+            size_t m_frame_size;
+
+            void begin_sync(Receiver &rx);
+
+            bool do_sync(Receiver &rx);
+            bool do_read_frame(Receiver &rx);
+            bool do_write_uplink(Receiver &rx);
+
+            void process_frame(Receiver &rx, absolute_time_t rx_time);
+    };
+
+}
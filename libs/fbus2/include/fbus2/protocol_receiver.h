@@ -0,0 +1,55 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Radio receiver running an RC protocol
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <utility>
+
+#include "receiver.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief A receiver transport (ReceiverUART, ReceiverPIO, ReceiverHostBase) running Protocol
+     *
+     * The protocol is a policy, so every protocol shares the ISR, stream
+     * buffer and task plumbing of the transport, and publishes the same
+     * Channels. A protocol provides:
+     *
+     *   State                   Its state machine states
+     *   LINE                    Default LineConfig
+     *   State state() const
+     *   void init(Receiver &rx) Reset to syncing
+     *   bool step(Receiver &rx) Run the state machine once, false when out of data
+     *
+     * Constructor arguments are passed on to the transport.
+     */
+    template<typename Protocol, typename Transport>
+    class ProtocolReceiver : public Transport {
+        public:
+            using protocol_type = Protocol;
+            using State = typename Protocol::State;
+
+            template<typename... Args>
+            ProtocolReceiver(Args&&... args) :
+                Transport { std::forward<Args>(args)... }
+            {
+            }
+
+            State state() const { return m_protocol.state(); }
+            const Protocol &protocol() const { return m_protocol; }
+
+        protected:
+            virtual void protocol_init() override { m_protocol.init(*this); }
+            virtual bool step() override { return m_protocol.step(*this); }
+
+        private:
+            Protocol m_protocol;
+    };
+
+}
@@ -0,0 +1,46 @@
+/**
+ * @author Peter Christoffersen
+ * @brief SBUS protocol engine
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include "receiver.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief SBUS, 16 channels and the flags in a fixed 25 byte frame, no telemetry
+     *
+     * SBUS has no RSSI, so the published RSSI is always 0. Needs an inverted
+     * 8E2 line, that only the UART receiver can do.
+     */
+    class SBusProtocol {
+        public:
+            enum class State {
+                SYNCING,
+                READ_FRAME
+            };
+
+            static constexpr LineConfig LINE { 100000, LineConfig::Parity::EVEN, 2, true };
+
+            SBusProtocol() : m_state { State::SYNCING } {}
+
+            State state() const { return m_state; }
+
+            void init(Receiver &rx) { begin_sync(rx); }
+            bool step(Receiver &rx);
+
+        private:
+            State m_state;
+
+            void begin_sync(Receiver &rx);
+
+            bool do_sync(Receiver &rx);
+            bool do_read_frame(Receiver &rx);
+    };
+
+}
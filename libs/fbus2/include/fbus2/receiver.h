@@ -9,6 +9,7 @@
 #pragma once
 
 #include <array>
+#include <initializer_list>
 #include <functional>
 #include <atomic>
 #include <stdio.h>
@@ -22,39 +23,146 @@
 #include "telemetry.h"
 #include "mapping.h"
 #include "ringbuffer.h"
+#include "checksum.h"
+#include "rxtime.h"
+#include "seqlock.h"
+#include "stats.h"
+#include "recorder.h"
+#include "shaping.h"
 
 namespace FBus2 {
 
+    /**
+     * @brief Serial line format, 8 data bits
+     */
+    struct LineConfig {
+        enum class Parity : uint8_t {
+            NONE,
+            EVEN,
+            ODD
+        };
+
+        uint baudrate;
+        Parity parity;
+        uint stop_bits;
+        bool inverted;
+
+        constexpr LineConfig(uint baudrate, Parity parity=Parity::NONE, uint stop_bits=1, bool inverted=false) :
+            baudrate { baudrate },
+            parity { parity },
+            stop_bits { stop_bits },
+            inverted { inverted }
+        {
+        }
+
+        constexpr uint bits_per_char() const { return 1+8+(parity==Parity::NONE ? 0 : 1)+stop_bits; }
+        constexpr bool is_8n1() const { return parity==Parity::NONE && stop_bits==1 && !inverted; }
+    };
+
+
+    /**
+     * @brief The receiver pipeline, shared by all the RC protocols
+     * 
+     * Bytes go from the rx ISR (or DMA) through the stream buffer into the 
+     * receive window of the receiver task, which runs the protocol, and 
+     * published channels are passed on to the lower task. The protocol itself
+     * is a policy, see ProtocolReceiver, and the hardware is provided by the
+     * subclasses.
+     */
     class Receiver {
         public:
             static constexpr uint8_t RECEIVER_ID  { 0x67 };
             static constexpr size_t MAX_CHANNELS { 24 };
+            static constexpr size_t MAX_SENSOR_IDS { 4 };
+
+            /**
+             * @brief Sensor id n (0-27) as polled on the wire, with its check bits
+             */
+            static constexpr uint8_t physical_id(uint n)
+            {
+                uint b = n & 0x1F;
+                uint bit5 = (b ^ (b>>1) ^ (b>>2)) & 1;
+                uint bit6 = ((b>>2) ^ (b>>3) ^ (b>>4)) & 1;
+                uint bit7 = (b ^ (b>>2) ^ (b>>4)) & 1;
+                return static_cast<uint8_t>(b | bit5<<5 | bit6<<6 | bit7<<7);
+            }
             using channels_type = Channels;
 
-            Receiver(uint baudrate, UBaseType_t task_priority, UBaseType_t lower_task_priority);
+            Receiver(const LineConfig &line, UBaseType_t task_priority, UBaseType_t lower_task_priority);
             Receiver(const Receiver&) = delete; // No copy constructor
             Receiver(Receiver&&) = delete; // No move constructor
+            virtual ~Receiver();
 
             void init();
             void start();
 
-            void lock() const { xSemaphoreTake(m_mutex, portMAX_DELAY); }
-            void unlock() const { xSemaphoreGive(m_mutex); }
-
-            bool connected() const            { return !m_channels.flags().frameLost(); }
-            channels_type            channels() const { return m_channels; }
-            channels_type::flag_type flags() const { return m_channels.flags(); }
-            channels_type::rssi_type rssi() const  { return m_channels.rssi(); } 
-            bool                     sync() const  { return m_channels.sync(); } 
-            size_t channel_count() const      { return m_channels.count(); } 
+            // Snapshots of the latest published channels, safe to call from any task
+            bool connected() const            { return failsafe_remaining_us(channels())>0; } // In sync, and within the failsafe timeout
+            channels_type            channels() const { return m_channels_published.load(); }
+            channels_type::flag_type flags() const { return channels().flags(); }
+            channels_type::rssi_type rssi() const  { return channels().rssi(); } 
+            bool                     sync() const  { return channels().sync(); } 
+            size_t channel_count() const      { return channels().count(); } 
 
             uint n_control_packets() const   { return m_control_packets; }
             uint n_telemetry_sent() const    { return m_telemetry_sent; }
             uint n_telemetry_skipped() const { return m_telemetry_skipped; }
+            uint n_failsafes() const         { return m_failsafes; }
+
+            // Time from the last received byte to the uplink decision
+            int64_t uplink_latency_us() const     { return m_uplink_latency_us; }
+            int64_t max_uplink_latency_us() const { return m_uplink_latency_max_us; }
+
+            /**
+             * @brief Longest time without a valid frame before on_data() gets a frame lost, set before start()
+             * 
+             * The lower task waits for this deadline along with the next frame,
+             * so it fires when the line goes silent too, and not only once the
+             * protocol gets bytes to find it has lost sync.
+             */
+            void set_failsafe_timeout(int64_t timeout_us) { m_failsafe_us = timeout_us; }
+            int64_t failsafe_timeout() const { return m_failsafe_us; }
+
+            /**
+             * @brief Jitter allowed on channel n before it is reported as changed, set before start()
+             */
+            void set_deadband(size_t n, ChannelValue::raw_type deadband) { m_changes.set_deadband(n, deadband); }
+
+            /**
+             * @brief Sensor ids to answer downlink polls on, set before start()
+             *
+             * Every id is polled in its own slot of the poll cycle, so each one
+             * adds an uplink slot. get_next_telemetry() is called with the id
+             * that was polled. Only RECEIVER_ID by default.
+             */
+            void set_sensor_ids(const uint8_t *ids, size_t count);
+            void set_sensor_ids(std::initializer_list<uint8_t> ids) { set_sensor_ids(ids.begin(), ids.size()); }
+            size_t sensor_id_count() const { return m_sensor_id_count; }
+            uint8_t sensor_id(size_t n) const { return m_sensor_ids[n]; }
+            bool answers(uint8_t id) const;
+
+            /**
+             * @brief Shape the channels in the lower task, before change detection and on_data(), set before start()
+             * 
+             * channels() still gives the channels as received.
+             */
+            void set_shaper(ChannelShaper *shaper) { m_shaper = shaper; }
+
+            // Timing and error statistics, empty when compiled out with FBUS2_STATS=0
+            const ReceiverStats &stats() const { return m_stats; }
+            void reset_stats() { m_stats.reset(); }
+
+            /**
+             * @brief Record the raw received stream, set before init()
+             * 
+             * @param freeze_on_lost_sync Freeze the recording when sync has been lost for SYNC_TIMEOUT, to keep the incident
+             */
+            void set_recorder(Recorder *recorder, bool freeze_on_lost_sync=true) { m_recorder = recorder; m_freeze_recorder = freeze_on_lost_sync; }
+            Recorder *recorder() const { return m_recorder; }
 
 
             #ifndef NDEBUG
-            void print_stats();
+            virtual void print_stats();
             #endif
 
         protected:
@@ -63,36 +171,49 @@ namespace FBus2 {
             static constexpr uint ISR_CORE { 1u };
 
             static constexpr size_t RX_BUFFER_SIZE { 128u };
-            static constexpr size_t TX_BUFFER_SIZE { 32u };
-            static constexpr size_t RX_SCRATCH_SIZE { 64u };
+            static constexpr size_t TX_BUFFER_SIZE { 32u }; // What a transport must take in one tx_send(), the largest uplink fully stuffed
+            static constexpr size_t RX_WINDOW_SIZE { 64u };
+            static constexpr size_t RX_SUMS_SIZE { 256u };
 
             static constexpr size_t BUFFER_MAX_WAIT_CHARS = 32u;
             static constexpr int64_t SYNC_TIMEOUT = 100000; // 100ms
-
-            using rx_buffer_type = RingBuffer<uint8_t, RX_BUFFER_SIZE>;
-            using tx_buffer_type = RingBuffer<uint8_t, TX_BUFFER_SIZE>;
-
-            enum class State {
-                SYNCING,
-                READ_CONTROL,
-                READ_DOWNLINK,
-                WRITE_UPLINK,
-                READ_UPLINK
-            };
-
-            virtual void on_data(const channels_type &channels) = 0;
+            static constexpr int64_t FAILSAFE_TIMEOUT = SYNC_TIMEOUT;
+
+            using rx_window_type = RingBuffer<uint8_t, RX_WINDOW_SIZE>;
+            using rx_sums_type = ChecksumTracker<RX_SUMS_SIZE>;
+            using rx_times_type = RxTimeTracker<RX_SUMS_SIZE>;
+
+            // Protocol engines drive the pipeline, see ProtocolReceiver
+            friend class FBus2Protocol;
+            friend class SBusProtocol;
+            friend class FPortProtocol;
+
+            /**
+             * @brief New channels, from the lower task
+             * 
+             * @param changes What changed since the last call, frames may have been skipped in between
+             */
+            virtual void on_data(const channels_type &channels, ChangeMask changes) = 0;
             
             virtual void hardware_init() = 0;
             virtual void task_init() = 0;
-            virtual Telemetry get_next_telemetry() 
+            virtual void protocol_init() = 0;
+            virtual Telemetry get_next_telemetry(uint8_t sensor_id) 
             {
                 return Telemetry::null();
             }
 
+            /**
+             * @brief Current time, as seen by the receiver task
+             * 
+             * The ISRs stamp received data with get_absolute_time() directly, 
+             * this is for the task side, so the host can run it on a virtual clock.
+             */
+            virtual absolute_time_t now() const { return get_absolute_time(); }
 
-            static Receiver *m_instance;
 
             // Config
+            const LineConfig m_line;
             const uint m_baudrate;
             const UBaseType_t m_task_priority;
             const UBaseType_t m_lower_task_priority;
@@ -107,50 +228,115 @@ namespace FBus2 {
             TaskHandle_t m_task_lower;
 
             // Buffers
-            uint8_t m_rx_scratch[RX_SCRATCH_SIZE];
-            uint8_t m_rx_scratch_size;
+            rx_window_type m_rx_window;
+            rx_sums_type m_rx_sums;
+            rx_times_type m_rx_times;
+            rx_sums_type::pos_type m_rx_pos; // Stream position of the window head
 
             uint8_t m_rx_buffer_data[RX_BUFFER_SIZE];
             StaticStreamBuffer_t m_rx_buffer_buf;
             StreamBufferHandle_t m_rx_buffer;
-            
-            uint8_t m_tx_buffer_data[TX_BUFFER_SIZE];
-            StaticStreamBuffer_t m_tx_buffer_buf;
-            StreamBufferHandle_t m_tx_buffer;
+
+            TickType_t m_rx_timeout;
 
 
-            State m_state;
             absolute_time_t m_last_rx_time;
             absolute_time_t m_sync_begin_time;
 
             // Current data
-            StaticSemaphore_t m_mutex_buf;
-            mutable SemaphoreHandle_t m_mutex;
-            channels_type m_channels;
+            channels_type m_channels; // Only touched by the receiver task
+            SeqLock<channels_type> m_channels_published;
+            ChangeTracker m_changes; // Only touched by the lower task
 
             // Stats
             uint m_control_packets;
             uint m_telemetry_sent;
             uint m_telemetry_skipped;
-
+            uint m_failsafes;
+            std::array<uint8_t, MAX_SENSOR_IDS> m_sensor_ids;
+            size_t m_sensor_id_count;
+            int64_t m_uplink_latency_us;
+            int64_t m_uplink_latency_max_us;
+            ReceiverStats m_stats;
+
+            Recorder *m_recorder;
+            bool m_freeze_recorder;
+            ChannelShaper *m_shaper; // Only used by the lower task
+            int64_t m_failsafe_us;
+
+            void init_receiver();
+            void notify_lower() { if (m_task_lower) xTaskNotifyGive(m_task_lower); }
+            void deliver(channels_type &channels);
+            static void mark_lost(channels_type &channels);
+            absolute_time_t last_rx_time() const;
+
+            // Failsafe deadline, of the lower task
+            int64_t failsafe_remaining_us(const channels_type &channels) const;
+            TickType_t failsafe_wait(const channels_type &channels) const;
+            bool check_failsafe(channels_type &channels);
+
+            // Protocol side of the pipeline
+            void begin_sync();
+            void sync_found() { m_stats.sync_found(now()); }
+            void check_sync_timeout();
             void lost_sync();
+            void publish_channels(absolute_time_t rx_time);
+            bool uplink_in_time(int64_t max_delay_us);
+            void send_uplink(const uint8_t *buf, size_t sz) { tx_send(buf, sz); m_telemetry_sent++; }
+
+            bool rx_window_recv(size_t bytes);
+            void rx_window_pop(size_t bytes) { m_rx_window.pop(bytes); m_rx_pos += bytes; }
+            uint8_t rx_checksum(size_t off, size_t len) const { return m_rx_sums.checksum(m_rx_pos+off, len); }
+            absolute_time_t rx_time(size_t off) const { return m_rx_times.time(m_rx_pos+off, last_rx_time()); }
+
+            /**
+             * @brief Pass a received byte on to the receiver task, from the rx ISR
+             * 
+             * @param rx_time When the byte was received
+             * @return false if the rx buffer is full, and the byte was dropped
+             */
+            inline bool rx_isr_push(uint8_t ch, absolute_time_t rx_time)
+            {
+                if (m_recorder) {
+                    m_recorder->record(&ch, 1, rx_time);
+                }
+                m_rx_sums.prepare(ch);
+                m_rx_times.prepare(1, rx_time);
+                if (xStreamBufferSendFromISR(m_rx_buffer, &ch, 1, nullptr)!=sizeof(ch)) {
+                    return false;
+                }
+                m_rx_sums.commit();
+                m_rx_times.commit(1);
+                return true;
+            }
 
-            void rx_scratch_recv(size_t bytes);
-            void rx_scratch_pop(size_t bytes);
+            /**
+             * @brief Pass a chunk of received data on to the receiver task, from the rx ISR
+             * 
+             * @param rx_time When the last byte of the chunk was received
+             * @return size_t Number of bytes accepted, the rest were dropped
+             */
+            inline size_t rx_isr_push(const uint8_t *data, size_t len, absolute_time_t rx_time)
+            {
+                if (m_recorder) {
+                    m_recorder->record(data, len, rx_time);
+                }
+                m_rx_sums.prepare(data, len);
+                m_rx_times.prepare(len, rx_time);
+                auto sent = xStreamBufferSendFromISR(m_rx_buffer, data, len, nullptr);
+                m_rx_sums.commit(sent);
+                m_rx_times.commit(sent);
+                return sent;
+            }
             virtual void tx_send(const uint8_t *buf, size_t sz) = 0;
 
-            inline void begin_sync();
-            inline void begin_read_control();
-            inline void begin_read_downlink();
-            inline void begin_write_uplink();
-            inline void begin_read_uplink();
-
-            void do_sync();
-            void do_read_control();
-            void do_read_downlink();
-            void do_write_uplink();
-            void do_read_uplink();
-
+            /**
+             * @brief Run the protocol state machine once
+             * 
+             * @return false if it ran out of received data (only possible with
+             *         a finite m_rx_timeout), it will pick up where it left off next time
+             */
+            virtual bool step() = 0;
             void run();
             void run_lower();
 
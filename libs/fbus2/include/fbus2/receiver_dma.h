@@ -0,0 +1,119 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Radio receiver DMA data path
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include "receiver.h"
+#include <pico/time.h>
+#include <hardware/structs/systick.h>
+
+namespace FBus2 {
+
+    /**
+     * @brief Receiver base for the hardware receivers, with DMA rx and tx
+     *
+     * The rx side drains a FIFO into a ring with DMA, and hands the data over
+     * to the receiver task in chunks. The tx side clocks a whole frame out
+     * from a DMA buffer, without any interrupts.
+     *
+     * Also keeps the rx ISR load statistics for print_stats(), in both modes.
+     */
+    class ReceiverDMA : public Receiver {
+        public:
+            /**
+             * @brief How received data gets from the hardware to the receiver task
+             *
+             * IRQ: The rx interrupt drains the FIFO
+             * DMA: DMA drains the FIFO into a ring, and chunks are handed over
+             *      when a ping-pong half completes, or the line goes idle
+             */
+            enum class RxMode {
+                IRQ,
+                DMA
+            };
+
+            ReceiverDMA(const LineConfig &line, UBaseType_t task_priority, UBaseType_t lower_task_priority, RxMode rx_mode);
+            ReceiverDMA(const ReceiverDMA&) = delete; // No copy constructor
+            ReceiverDMA(ReceiverDMA&&) = delete; // No move constructor
+            virtual ~ReceiverDMA();
+
+            #ifndef NDEBUG
+            virtual void print_stats() override;
+            #endif
+
+        protected:
+            const RxMode m_rx_mode;
+
+            // Rx ISR load, only what the rx buffer accepted is counted as pushed
+            uint m_isr_calls;
+            uint m_isr_pushes;
+            uint m_isr_bytes;
+            uint64_t m_isr_cycles;
+            absolute_time_t m_isr_stats_begin;
+
+            void init_dma_rx(const volatile void *src, uint dreq);
+            void init_dma_tx(volatile void *dst, uint dreq);
+            void dma_tx_send(const uint8_t *buf, size_t sz);
+
+            void isr_stats_begin();
+
+            /**
+             * @brief Cycle counter for measuring ISR load
+             *
+             * Uses the SysTick current value, which counts down at the system clock and
+             * wraps at the FreeRTOS tick.
+             */
+            static inline uint32_t isr_cycles_begin()
+            {
+                return systick_hw->cvr;
+            }
+
+            inline void isr_cycles_end(uint32_t begin)
+            {
+                uint32_t now = systick_hw->cvr;
+                uint32_t cycles = begin>=now ? begin-now : begin+systick_hw->rvr+1-now;
+                m_isr_cycles += cycles;
+                m_isr_calls++;
+            }
+
+        private:
+            static constexpr uint   DMA_RING_BITS { 8u };
+            static constexpr size_t DMA_RING_SIZE { 1u<<DMA_RING_BITS };
+            static constexpr size_t DMA_RING_MASK { DMA_RING_SIZE-1u };
+            static constexpr size_t DMA_CHUNK_SIZE { 8u };          // Smaller than any frame, so each frame completes at least one chunk
+            static constexpr uint   DMA_IDLE_TIMEOUT_CHARS { 3u };  // Hand over a partial chunk after this many idle characters
+            static constexpr uint   DMA_IRQ_PRIORITY { 0u };
+            static constexpr size_t DMA_TX_SIZE { 16u };            // Room for an uplink frame
+            static constexpr size_t MAX_DMA_RECEIVERS { 4u };
+            static constexpr uint   DMA_IRQ_COUNT { 2u };
+
+            // The DMA interrupts are shared by all receivers in DMA mode
+            static ReceiverDMA *m_dma_instances[MAX_DMA_RECEIVERS];
+            static bool m_dma_irq_installed[DMA_IRQ_COUNT];
+
+            // DMA rx
+            alignas(DMA_RING_SIZE) uint8_t m_dma_ring[DMA_RING_SIZE];
+            int m_dma_rx[2];
+            uint m_dma_active;
+            size_t m_dma_read;
+            uint m_dma_irq_index;
+            int64_t m_dma_idle_us;
+            alarm_id_t m_dma_idle_alarm;
+
+            // DMA tx
+            uint8_t m_dma_tx_buf[DMA_TX_SIZE];
+            int m_dma_tx;
+
+            inline size_t dma_write_pos() const;
+            inline void dma_rx_handover(absolute_time_t rx_time);
+            inline void dma_rx_handler();
+            template<uint IRQ_INDEX> static void dma_irq_dispatch();
+            inline int64_t dma_idle_handler();
+    };
+
+}
@@ -0,0 +1,95 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Radio receiver fed from memory, for host tests
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ * Runs the receiver state machine without hardware or a running scheduler. 
+ * Data is pushed into the rx stream buffer as the ISR would, and the state 
+ * machine is stepped until it runs out of data.
+ */
+#pragma once
+
+#include <vector>
+#include "receiver.h"
+#include "protocol_receiver.h"
+#include "protocol_fbus2.h"
+
+namespace FBus2 {
+
+    class ReceiverHostBase : public Receiver {
+        public:
+            using tx_data_type = std::vector<uint8_t>;
+
+            ReceiverHostBase(const LineConfig &line=FBus2Protocol::LINE);
+            ReceiverHostBase(const ReceiverHostBase&) = delete; // No copy constructor
+            ReceiverHostBase(ReceiverHostBase&&) = delete; // No move constructor
+
+            void init();
+
+            size_t feed(const uint8_t *data, size_t len) { return feed(data, len, nil_time); }
+            size_t feed(const uint8_t *data, size_t len, absolute_time_t rx_time);
+            template<typename buffer_type>
+            size_t feed(const buffer_type &buffer) { return feed(buffer.data(), buffer.size()); }
+
+            size_t replay(RecordReader log);
+
+            size_t push(const uint8_t *data, size_t len, absolute_time_t rx_time);
+
+            size_t poll();
+
+            // The failsafe deadline of the lower task, see Receiver::set_failsafe_timeout()
+            TickType_t failsafe_wait() const { return Receiver::failsafe_wait(m_lower_channels); }
+            bool poll_failsafe() { return check_failsafe(m_lower_channels); }
+
+            size_t rx_pending() const { return m_rx_window.size()+xStreamBufferBytesAvailable(m_rx_buffer); }
+            uint n_steps() const { return m_steps; }
+            uint n_data() const { return m_data_count; }
+            uint n_changed() const { return m_changed_count; }  // Deliveries with a change
+            ChangeMask last_changes() const { return m_last_changes; }
+            const channels_type &delivered() const { return m_delivered; }  // As passed to on_data(), after shaping
+
+            const tx_data_type &tx_data() const { return m_tx_data; }
+            void clear_tx_data() { m_tx_data.clear(); }
+
+            void set_telemetry(const Telemetry &telemetry) { m_telemetry = telemetry; }
+            uint8_t last_telemetry_id() const { return m_telemetry_id; }  // Sensor id of the last telemetry asked for
+
+        protected:
+            virtual void on_data(const channels_type &channels, ChangeMask changes) override 
+            { 
+                m_data_count++; 
+                m_changed_count += changes.any();
+                m_last_changes = changes;
+                m_delivered = channels;
+            }
+
+            virtual void hardware_init() override {}
+            virtual void task_init() override {}
+            virtual Telemetry get_next_telemetry(uint8_t sensor_id) override 
+            { 
+                m_telemetry_id = sensor_id;
+                return m_telemetry; 
+            }
+
+            virtual void tx_send(const uint8_t *buf, size_t sz) override;
+
+        private:
+            uint m_steps;
+            uint m_data_count;
+            uint m_changed_count;
+            ChangeMask m_last_changes;
+            channels_type m_delivered;
+            channels_type m_lower_channels; // As kept by the lower task
+            Telemetry m_telemetry;
+            uint8_t m_telemetry_id { 0 };
+            tx_data_type m_tx_data;
+    };
+
+    template<typename Protocol>
+    using ProtocolReceiverHost = ProtocolReceiver<Protocol, ReceiverHostBase>;
+
+    using ReceiverHost = ProtocolReceiverHost<FBus2Protocol>;
+
+}
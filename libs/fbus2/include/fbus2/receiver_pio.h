@@ -8,12 +8,12 @@
  */
 #pragma once
 
-#include "receiver.h"
+#include "receiver_dma.h"
 #include <hardware/pio.h>
 
 namespace FBus2 {
 
-    class ReceiverPIO : public Receiver {
+    class ReceiverPIO : public ReceiverDMA {
         private:
 
 
@@ -21,11 +21,19 @@ namespace FBus2 {
             static constexpr size_t MAX_CHANNELS { 24 };
             using channels_type = Channels;
 
-            ReceiverPIO(PIO pio, uint baudrate, uint pin, UBaseType_t task_priority, UBaseType_t lower_task_priority);
+            ReceiverPIO(PIO pio, const LineConfig &line, uint pin, UBaseType_t task_priority, UBaseType_t lower_task_priority, RxMode rx_mode=RxMode::IRQ);
             ReceiverPIO(const ReceiverPIO&) = delete; // No copy constructor
             ReceiverPIO(ReceiverPIO&&) = delete; // No move constructor
+            virtual ~ReceiverPIO();
 
         private:
+            static constexpr size_t RX_FIFO_SIZE { 8u }; // Joined rx FIFO
+
+            // Shared by the receivers on each PIO
+            static ReceiverPIO *m_instances[NUM_PIOS][NUM_PIO_STATE_MACHINES]; // For dispatching the PIO interrupts, by rx state machine
+            static int m_rx_offset[NUM_PIOS];
+            static int m_tx_offset[NUM_PIOS];
+
             // Config
             const uint m_pin;
             PIO m_pio;
@@ -36,11 +44,11 @@ namespace FBus2 {
             virtual void hardware_init() override;
             virtual void task_init() override;
 
-            inline void irq_set_tx_enable(bool enable);
             virtual void tx_send(const uint8_t *buf, size_t sz) override;
 
             void init_isr();
             inline void isr_handler();
+            template<uint PIO_INDEX> static void isr_dispatch();
     };
 
 }
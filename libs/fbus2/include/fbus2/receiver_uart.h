@@ -8,12 +8,12 @@
  */
 #pragma once
 
-#include "receiver.h"
+#include "receiver_dma.h"
 #include <hardware/uart.h>
 
 namespace FBus2 {
 
-    class ReceiverUART : public Receiver {
+    class ReceiverUART : public ReceiverDMA {
         private:
 
 
@@ -21,16 +21,24 @@ namespace FBus2 {
             static constexpr size_t MAX_CHANNELS { 24 };
             using channels_type = Channels;
 
-            ReceiverUART(uart_inst_t *uart, uint baudrate, uint tx_pin, uint rx_pin, UBaseType_t task_priority, UBaseType_t lower_task_priority);
+            ReceiverUART(uart_inst_t *uart, const LineConfig &line, uint tx_pin, uint rx_pin, UBaseType_t task_priority, UBaseType_t lower_task_priority, RxMode rx_mode=RxMode::IRQ);
             ReceiverUART(const ReceiverUART&) = delete; // No copy constructor
             ReceiverUART(ReceiverUART&&) = delete; // No move constructor
+            virtual ~ReceiverUART();
 
         private:
+            static ReceiverUART *m_instances[NUM_UARTS]; // For dispatching the UART interrupts, by UART index
+
             // Config
             const uint m_tx_pin;
             const uint m_rx_pin;
             uart_inst_t *m_uart;
 
+            // Uplinks are written to the FIFO by the tx interrupt
+            uint8_t m_tx_buffer_data[TX_BUFFER_SIZE];
+            StaticStreamBuffer_t m_tx_buffer_buf;
+            StreamBufferHandle_t m_tx_buffer;
+
             virtual void hardware_init() override;
             virtual void task_init() override;
 
@@ -39,6 +47,7 @@ namespace FBus2 {
 
             void init_isr();
             inline void isr_handler();
+            template<uint UART_INDEX> static void isr_dispatch();
     };
 
 }
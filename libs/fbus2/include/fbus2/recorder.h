@@ -0,0 +1,407 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Raw radio byte stream recording
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include <pico/critical_section.h>
+
+namespace FBus2 {
+
+    /**
+     * @brief Binary log format of the recorder
+     *
+     * Little endian. A 20 byte header, followed by the entries, oldest first:
+     *
+     *   header: "FB2R" | version u8 | 0 u8 | 0 u16 | baudrate u32 | start us u64
+     *   entry:  dt varint | len u8 | data[len]
+     *
+     * dt is the time since the previous entry in us (LEB128, at most 5 bytes),
+     * and ignored for the first entry, which was received at start.
+     */
+    namespace RecordFormat {
+        static constexpr uint8_t MAGIC[4] { 'F', 'B', '2', 'R' };
+        static constexpr uint8_t VERSION { 1 };
+        static constexpr size_t HEADER_SIZE { 20 };
+        static constexpr size_t MAX_DT_SIZE { 5 };
+        static constexpr size_t MAX_DATA { 255 };
+        static constexpr size_t MAX_ENTRY { MAX_DT_SIZE+1+MAX_DATA };
+    }
+
+
+    /**
+     * @brief Records the raw received byte stream, with timestamps, into a RAM ring
+     *
+     * Recording is done from the rx ISR, so it is just a copy into the ring,
+     * and the oldest entries are dropped to make room. Chunks that arrive
+     * within merge_us of the start of the last entry are added to it, so a
+     * byte at a time from the UART interrupt doesn't cost a header per byte.
+     * Replay times are then off by up to merge_us.
+     *
+     * The ring can be frozen, to keep the data around an incident until it
+     * has been dumped. Anything received while frozen is counted, but not
+     * recorded.
+     */
+    class Recorder {
+        public:
+            static constexpr int64_t DEFAULT_MERGE_US { 50 }; // About 2 characters at 460800 baud
+
+            Recorder(uint8_t *buffer, size_t size, uint baudrate, int64_t merge_us=DEFAULT_MERGE_US) :
+                m_buffer { buffer },
+                m_capacity { size },
+                m_baudrate { baudrate },
+                m_merge_us { merge_us },
+                m_frozen { false }
+            {
+                critical_section_init(&m_lock);
+                clear();
+            }
+            Recorder(const Recorder&) = delete; // No copy constructor
+            Recorder(Recorder&&) = delete; // No move constructor
+
+            /**
+             * @brief Record a received chunk, called from the rx ISR
+             */
+            void record(const uint8_t *data, size_t len, absolute_time_t time)
+            {
+                critical_section_enter_blocking(&m_lock);
+                if (m_frozen) {
+                    m_missed += len;
+                }
+                else {
+                    while (len) {
+                        size_t chunk = std::min(len, RecordFormat::MAX_DATA);
+                        append(data, chunk, time);
+                        data += chunk;
+                        len -= chunk;
+                    }
+                }
+                critical_section_exit(&m_lock);
+            }
+
+            void freeze()
+            {
+                critical_section_enter_blocking(&m_lock);
+                m_frozen = true;
+                critical_section_exit(&m_lock);
+            }
+
+            void resume() { m_frozen = false; }
+            bool frozen() const { return m_frozen; }
+
+            void clear()
+            {
+                critical_section_enter_blocking(&m_lock);
+                m_head = 0;
+                m_used = 0;
+                m_entries = 0;
+                m_head_time = nil_time;
+                m_last_time = nil_time;
+                m_last_len_pos = 0;
+                m_recorded = 0;
+                m_overwritten = 0;
+                m_missed = 0;
+                critical_section_exit(&m_lock);
+            }
+
+            size_t capacity() const { return m_capacity; }
+            size_t size() const { return RecordFormat::HEADER_SIZE+m_used; } // Of a dump
+            uint entries() const { return m_entries; }
+
+            // Stats, in bytes of received data
+            uint recorded() const    { return m_recorded; }
+            uint overwritten() const { return m_overwritten; }
+            uint missed() const      { return m_missed; }  // While frozen
+
+            /**
+             * @brief Write the log, in RecordFormat, recording is paused while writing
+             *
+             * @param write Called with consecutive pieces of the log, write(const uint8_t *data, size_t len)
+             * @return size_t Bytes written
+             */
+            template<typename write_type>
+            size_t dump(write_type &&write)
+            {
+                bool was_frozen = m_frozen;
+                freeze();
+
+                uint8_t header[RecordFormat::HEADER_SIZE] {};
+                memcpy(header, RecordFormat::MAGIC, sizeof(RecordFormat::MAGIC));
+                header[4] = RecordFormat::VERSION;
+                put_le(&header[8], m_baudrate, 4);
+                put_le(&header[12], to_us_since_boot(m_head_time), 8);
+                write(header, sizeof(header));
+
+                size_t first = std::min(m_used, m_capacity-m_head);
+                if (first) {
+                    write(&m_buffer[m_head], first);
+                }
+                if (m_used>first) {
+                    write(m_buffer, m_used-first);
+                }
+
+                if (!was_frozen) {
+                    resume();
+                }
+                return size();
+            }
+
+            /**
+             * @brief Dump the log as hex on stdout, to be picked out of the console output
+             *
+             * Lines of "fbus2-log: <hex>", ending with "fbus2-log: end".
+             * tools/fbus2_log.py turns them back into a binary log.
+             */
+            void print_hex()
+            {
+                constexpr size_t LINE { 32 };
+                uint8_t line[LINE];
+                size_t fill = 0;
+                auto flush = [&]() {
+                    printf("fbus2-log: ");
+                    for (size_t i=0; i<fill; ++i) {
+                        printf("%02x", line[i]);
+                    }
+                    printf("\n");
+                    fill = 0;
+                };
+                dump([&](const uint8_t *data, size_t len) {
+                    for (size_t i=0; i<len; ++i) {
+                        line[fill++] = data[i];
+                        if (fill==LINE) {
+                            flush();
+                        }
+                    }
+                });
+                if (fill) {
+                    flush();
+                }
+                printf("fbus2-log: end\n");
+            }
+
+        private:
+            mutable critical_section_t m_lock;
+
+            uint8_t *m_buffer;
+            const size_t m_capacity;
+            const uint m_baudrate;
+            const int64_t m_merge_us;
+
+            volatile bool m_frozen;
+
+            size_t m_head;
+            size_t m_used;
+            uint m_entries;
+            absolute_time_t m_head_time;  // Of the oldest entry
+            absolute_time_t m_last_time;  // Of the newest entry
+            size_t m_last_len_pos;
+
+            uint m_recorded;
+            uint m_overwritten;
+            uint m_missed;
+
+            size_t pos(size_t offset) const { return (m_head+offset) % m_capacity; }
+            uint8_t at(size_t offset) const { return m_buffer[pos(offset)]; }
+
+            static void put_le(uint8_t *dst, uint64_t value, size_t bytes)
+            {
+                for (size_t i=0; i<bytes; ++i) {
+                    dst[i] = (value >> (8*i)) & 0xFF;
+                }
+            }
+
+            void append(const uint8_t *data, size_t len, absolute_time_t time)
+            {
+                int64_t dt = m_entries ? absolute_time_diff_us(m_last_time, time) : 0;
+                if (m_entries && dt<=m_merge_us && m_buffer[m_last_len_pos]+len<=RecordFormat::MAX_DATA) {
+                    make_room(len);
+                    if (m_entries) {
+                        put(data, len);
+                        m_buffer[m_last_len_pos] += len;
+                        m_recorded += len;
+                        return;
+                    }
+                    // The ring only had room for one entry, and it was dropped
+                }
+
+                uint8_t header[RecordFormat::MAX_DT_SIZE+1];
+                size_t header_len = 0;
+                uint32_t value = static_cast<uint32_t>(std::clamp<int64_t>(dt, 0, UINT32_MAX));
+                do {
+                    uint8_t byte = value & 0x7F;
+                    value >>= 7;
+                    header[header_len++] = byte | (value ? 0x80 : 0x00);
+                } while (value);
+                header[header_len++] = static_cast<uint8_t>(len);
+
+                make_room(header_len+len);
+                if (m_entries==0) {
+                    m_head_time = time;
+                }
+                m_last_len_pos = pos(m_used+header_len-1);
+                put(header, header_len);
+                put(data, len);
+                m_last_time = time;
+                m_entries++;
+                m_recorded += len;
+            }
+
+            void put(const uint8_t *data, size_t len)
+            {
+                for (size_t i=0; i<len; ++i) {
+                    m_buffer[pos(m_used++)] = data[i];
+                }
+            }
+
+            /**
+             * @brief Read the entry header at offset
+             *
+             * @return size_t Size of the whole entry
+             */
+            size_t entry_at(size_t offset, uint32_t &dt, size_t &len) const
+            {
+                dt = 0;
+                size_t n = 0;
+                uint8_t byte;
+                do {
+                    byte = at(offset+n);
+                    dt |= static_cast<uint32_t>(byte & 0x7F) << (7*n);
+                    n++;
+                } while (byte & 0x80);
+                len = at(offset+n);
+                return n+1+len;
+            }
+
+            /**
+             * @brief Drop the oldest entries until there is room for len bytes
+             */
+            void make_room(size_t len)
+            {
+                while (m_entries && m_capacity-m_used<len) {
+                    uint32_t dt;
+                    size_t data_len;
+                    size_t size = entry_at(0, dt, data_len);
+                    m_head = pos(size);
+                    m_used -= size;
+                    m_entries--;
+                    m_overwritten += data_len;
+                    if (m_entries) {
+                        // The next entry's time is relative to the dropped one
+                        entry_at(0, dt, data_len);
+                        m_head_time = delayed_by_us(m_head_time, dt);
+                    }
+                }
+            }
+    };
+
+
+    /**
+     * @brief Recorder with its own ring of SIZE bytes
+     */
+    template<size_t SIZE>
+    class StaticRecorder : public Recorder {
+        public:
+            static_assert(SIZE>=2*RecordFormat::MAX_ENTRY, "Recorder ring must hold a couple of entries");
+
+            StaticRecorder(uint baudrate, int64_t merge_us=DEFAULT_MERGE_US) :
+                Recorder { m_data, SIZE, baudrate, merge_us }
+            {
+            }
+
+        private:
+            uint8_t m_data[SIZE];
+    };
+
+
+    /**
+     * @brief Reads the entries of a log in RecordFormat
+     */
+    class RecordReader {
+        public:
+            struct Entry {
+                absolute_time_t time;
+                const uint8_t *data;
+                size_t len;
+            };
+
+            RecordReader(const uint8_t *log, size_t len) :
+                m_log { log },
+                m_len { len },
+                m_pos { RecordFormat::HEADER_SIZE },
+                m_time { nil_time }
+            {
+            }
+
+            bool valid() const
+            {
+                return m_len>=RecordFormat::HEADER_SIZE &&
+                    memcmp(m_log, RecordFormat::MAGIC, sizeof(RecordFormat::MAGIC))==0 &&
+                    m_log[4]==RecordFormat::VERSION;
+            }
+
+            uint baudrate() const { return static_cast<uint>(get_le(&m_log[8], 4)); }
+            absolute_time_t start() const { return from_us_since_boot(get_le(&m_log[12], 8)); }
+
+            /**
+             * @brief Next entry
+             *
+             * @return false at the end of the log, or if the rest is truncated
+             */
+            bool next(Entry &entry)
+            {
+                uint32_t dt = 0;
+                size_t n = 0;
+                while (true) {
+                    if (m_pos+n>=m_len || n>=RecordFormat::MAX_DT_SIZE) {
+                        return false;
+                    }
+                    uint8_t byte = m_log[m_pos+n];
+                    dt |= static_cast<uint32_t>(byte & 0x7F) << (7*n);
+                    n++;
+                    if ((byte & 0x80)==0) {
+                        break;
+                    }
+                }
+                if (m_pos+n>=m_len || m_pos+n+1+m_log[m_pos+n]>m_len) {
+                    return false;
+                }
+
+                m_time = is_nil_time(m_time) ? start() : delayed_by_us(m_time, dt);
+                entry.time = m_time;
+                entry.len = m_log[m_pos+n];
+                entry.data = &m_log[m_pos+n+1];
+                m_pos += n+1+entry.len;
+                return true;
+            }
+
+            void rewind()
+            {
+                m_pos = RecordFormat::HEADER_SIZE;
+                m_time = nil_time;
+            }
+
+        private:
+            const uint8_t *m_log;
+            const size_t m_len;
+            size_t m_pos;
+            absolute_time_t m_time;
+
+            static uint64_t get_le(const uint8_t *src, size_t bytes)
+            {
+                uint64_t value = 0;
+                for (size_t i=0; i<bytes; ++i) {
+                    value |= static_cast<uint64_t>(src[i]) << (8*i);
+                }
+                return value;
+            }
+    };
+
+}
@@ -1,24 +1,54 @@
 /**
  * @author Peter Christoffersen
- * @brief Simple ringbuffer
+ * @brief Single producer, single consumer ringbuffer
  * @date 2022-07-24
- * 
+ *
  * @copyright Copyright (c) 2022
- * 
+ *
  */
 
 #pragma once
 
+#include <atomic>
+#include <algorithm>
 #include <pico/stdlib.h>
-#include <pico/critical_section.h>
 
 namespace FBus2 {
 
+    /**
+     * @brief Lock free ringbuffer, for one producer and one consumer
+     *
+     * The producer and the consumer can be an ISR and a task, or on different
+     * cores. Each side only writes its own index, and publishes it with a
+     * release store once the data is written or read, so there is no lock,
+     * and only loads and stores of the indexes, which are single instructions
+     * on the M0+. The indexes run freely and are masked on access, so all SIZE
+     * elements can be used.
+     *
+     * Producer:  push(), write_span() + commit(), space()
+     * Consumer:  pop(), read_span(), view(), operator[], copy(), clear()
+     * Either:    size(), empty(), which are exact for the calling side only
+     */
     template<typename T, size_t SIZE>
     class RingBuffer {
         public:
             using value_type = T;
 
+            /**
+             * @brief Read-only view of the buffered data from the current head
+             *
+             * Indexes straight into the buffer, so it is for the consumer, and
+             * only on data that is already in the buffer.
+             */
+            class View {
+                public:
+                    const value_type &operator[](size_t pos) const { return m_data[(m_head+pos)&MASK]; }
+                private:
+                    friend class RingBuffer;
+                    View(const value_type *data, size_t head) : m_data { data }, m_head { head } {}
+                    const value_type *m_data;
+                    size_t m_head;
+            };
 
             RingBuffer() :
                 m_head { 0 },
@@ -26,98 +56,143 @@ namespace FBus2 {
             {
                 static_assert(SIZE>2, "Buffer size must be larger than 2");
                 static_assert((SIZE & MASK)==0u, "Buffer size must be 2^n");
-                critical_section_init(&m_lock);
             }
+            RingBuffer(const RingBuffer&) = delete; // No copy constructor
+            RingBuffer(RingBuffer&&) = delete; // No move constructor
 
-            void push(value_type v) 
+            static constexpr size_t capacity() { return SIZE; }
+
+            size_t size() const { return m_tail.load(std::memory_order_acquire)-m_head.load(std::memory_order_acquire); }
+            bool empty() const  { return size()==0; }
+
+
+            // Producer
+
+            bool push(value_type v)
             {
-                if (size()+1>=SIZE) {
+                size_t tail = m_tail.load(std::memory_order_relaxed);
+                if (tail-m_head.load(std::memory_order_acquire)>=SIZE) {
                     // Buffer full
-                    return;
+                    return false;
                 }
-                m_data[m_tail] = v;
-                m_tail = (m_tail+1)&MASK;
+                m_data[tail&MASK] = v;
+                m_tail.store(tail+1, std::memory_order_release);
+                return true;
             }
 
-            void push(value_type *data, size_t len)
+            /**
+             * @brief Push as much of data as there is room for, in at most two copies
+             *
+             * @return size_t Number of elements pushed
+             */
+            size_t push(const value_type *data, size_t len)
             {
-                for (size_t i=0; i<len; ++i) {
-                    push(data[i]);
-                }
+                size_t tail = m_tail.load(std::memory_order_relaxed);
+                len = std::min(len, SIZE-(tail-m_head.load(std::memory_order_acquire)));
+                size_t first = std::min(len, SIZE-(tail&MASK));
+                std::copy(data, data+first, &m_data[tail&MASK]);
+                std::copy(data+first, data+len, &m_data[0]);
+                m_tail.store(tail+len, std::memory_order_release);
+                return len;
+            }
+
+            /**
+             * @brief Get the contiguous free space at the tail of the buffer
+             *
+             * Data can be written directly to the returned pointer, and then
+             * made visible to the consumer with commit().
+             *
+             * @param ptr Set to the first free element
+             * @return size_t Number of elements that can be written at ptr
+             */
+            size_t write_span(value_type *&ptr)
+            {
+                size_t tail = m_tail.load(std::memory_order_relaxed);
+                ptr = &m_data[tail&MASK];
+                return std::min(SIZE-(tail-m_head.load(std::memory_order_acquire)), SIZE-(tail&MASK));
+            }
+
+            void commit(size_t len)
+            {
+                size_t tail = m_tail.load(std::memory_order_relaxed);
+                assert(tail+len-m_head.load(std::memory_order_acquire)<=SIZE);
+                m_tail.store(tail+len, std::memory_order_release);
             }
 
-            value_type pop() 
+            size_t space() const { return SIZE-size(); }
+
+
+            // Consumer
+
+            value_type pop()
             {
                 assert(!empty());
-                size_t h = m_head;
-                pop(1);
-                return m_data[h];
+                size_t head = m_head.load(std::memory_order_relaxed);
+                value_type v = m_data[head&MASK];
+                m_head.store(head+1, std::memory_order_release);
+                return v;
             }
 
+            /**
+             * @brief Drop len elements, there must be at least len in the buffer
+             */
             void pop(size_t len)
             {
                 assert(size()>=len);
-                if (m_head==m_tail) {
-                    return;
-                }
-                if (len>size()) {
-                    m_head = m_tail;
-                    return;
-                }
-                m_head = (m_head+len)&MASK;
+                size_t head = m_head.load(std::memory_order_relaxed);
+                m_head.store(head+len, std::memory_order_release);
             }
-            void pop_blocking(size_t len) 
-            { 
-                critical_section_enter_blocking(&m_lock);
-                pop(len); 
-                critical_section_exit(&m_lock);
+
+            /**
+             * @brief Pop up to len elements into dst, in at most two copies
+             *
+             * @return size_t Number of elements popped
+             */
+            size_t pop(value_type *dst, size_t len)
+            {
+                size_t head = m_head.load(std::memory_order_relaxed);
+                len = std::min(len, m_tail.load(std::memory_order_acquire)-head);
+                size_t first = std::min(len, SIZE-(head&MASK));
+                std::copy(&m_data[head&MASK], &m_data[head&MASK]+first, dst);
+                std::copy(&m_data[0], &m_data[len-first], dst+first);
+                m_head.store(head+len, std::memory_order_release);
+                return len;
             }
 
+            /**
+             * @brief Get the contiguous data at the head of the buffer, without popping it
+             *
+             * @param ptr Set to the first element
+             * @return size_t Number of elements that can be read at ptr, pop() them when done
+             */
+            size_t read_span(const value_type *&ptr) const
+            {
+                size_t head = m_head.load(std::memory_order_relaxed);
+                ptr = &m_data[head&MASK];
+                return std::min(m_tail.load(std::memory_order_acquire)-head, SIZE-(head&MASK));
+            }
 
-            void clear() { m_head = m_tail; }
+            void clear() { m_head.store(m_tail.load(std::memory_order_acquire), std::memory_order_release); }
 
-            size_t size() const          { return (m_tail-m_head) & MASK; }
-            size_t size_blocking() const 
-            { 
-                critical_section_enter_blocking(&m_lock);
-                auto sz = size(); 
-                critical_section_exit(&m_lock);
-                return sz;
-            }
-            bool empty() const           { return m_tail == m_head; }
-            bool empty_blocking() const  
-            { 
-                critical_section_enter_blocking(&m_lock);
-                bool res = empty(); 
-                critical_section_exit(&m_lock);
-                return res;
-            }
+            const value_type &operator[](size_t pos) const { assert(pos<size()); return m_data[(m_head.load(std::memory_order_relaxed)+pos)&MASK]; }
+
+            View view() const { return View { m_data, m_head.load(std::memory_order_relaxed) }; }
 
-            volatile value_type &head() { return m_data[m_head]; }
-            volatile value_type &operator[](size_t pos)             { assert(pos<size()); return m_data[(m_head+pos)&MASK]; }
-            const volatile value_type &operator[](size_t pos) const { assert(pos<size()); return m_data[(m_head+pos)&MASK]; }
-            
-            void copy(value_type *dst, size_t len, size_t off)
+            void copy(value_type *dst, size_t len, size_t off) const
             {
                 assert(off+len <= size());
-                for (size_t i=0; i<len; i++) {
-                    dst[i] = m_data[(m_head+off+i)&MASK];
-                }
+                size_t pos = (m_head.load(std::memory_order_relaxed)+off)&MASK;
+                size_t first = std::min(len, SIZE-pos);
+                std::copy(&m_data[pos], &m_data[pos]+first, dst);
+                std::copy(&m_data[0], &m_data[len-first], dst+first);
             }
 
-
-            critical_section_t &lock() { return m_lock; }
-            void enter_blocking()      { critical_section_enter_blocking(&m_lock); }
-            void exit()                { critical_section_exit(&m_lock); }
-
         private:
             static constexpr size_t MASK { SIZE-1 };
 
-            mutable critical_section_t m_lock;
-
-            volatile value_type m_data[SIZE];
-            volatile size_t m_head;
-            volatile size_t m_tail;
+            value_type m_data[SIZE];
+            std::atomic<size_t> m_head; // Written by the consumer
+            std::atomic<size_t> m_tail; // Written by the producer
     };
 
 }
@@ -0,0 +1,78 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Receive time of each byte in the rx buffers
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <pico/stdlib.h>
+
+namespace FBus2 {
+
+    /**
+     * @brief Time the rx ISR received each byte, indexed by stream position
+     *
+     * Works like ChecksumTracker: the ISR calls prepare() before handing the
+     * bytes on, and commit() once they have been accepted, so the time of a
+     * byte is written before the receiver task can see it. Bytes handed over
+     * together share the time of the hand over.
+     *
+     * Times are the low 32 bits of the microsecond clock, which is 4 bytes per
+     * position and wraps after 71 minutes. The full time is rebuilt relative to
+     * a later time, e.g. the last time the ISR ran. SIZE must be larger than
+     * the number of bytes that can be buffered between the ISR and the frame
+     * being parsed.
+     */
+    template<size_t SIZE>
+    class RxTimeTracker {
+        public:
+            using pos_type = uint32_t;
+            using time_type = uint32_t;
+
+            RxTimeTracker()
+            {
+                static_assert((SIZE & MASK)==0u, "Tracker size must be 2^n");
+                reset();
+            }
+
+            void reset()
+            {
+                m_pos = 0;
+            }
+
+            // ISR side
+            inline void prepare(size_t len, absolute_time_t rx_time)
+            {
+                time_type t = static_cast<time_type>(to_us_since_boot(rx_time));
+                for (size_t i=0; i<len; ++i) {
+                    m_times[(m_pos+i)&MASK] = t;
+                }
+            }
+            inline void commit(size_t len) { m_pos += len; }
+            inline void push(size_t len, absolute_time_t rx_time) { prepare(len, rx_time); commit(len); }
+
+            pos_type pos() const { return m_pos; }
+
+            // Receiver side
+            /**
+             * @brief Receive time of the byte at stream position pos
+             *
+             * @param latest A time at or after the byte was received
+             */
+            absolute_time_t time(pos_type pos, absolute_time_t latest) const
+            {
+                time_type age = static_cast<time_type>(to_us_since_boot(latest))-m_times[pos&MASK];
+                return from_us_since_boot(to_us_since_boot(latest)-age);
+            }
+
+        private:
+            static constexpr size_t MASK { SIZE-1 };
+
+            time_type m_times[SIZE];
+            volatile pos_type m_pos;
+    };
+
+}
@@ -0,0 +1,79 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Single writer publication of a value
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <pico/stdlib.h>
+
+namespace FBus2 {
+
+    /**
+     * @brief Double buffered seqlock, for a single writer and any number of readers
+     *
+     * The writer fills the slot readers are not pointed at, and then publishes
+     * it, so it never waits for a reader. A reader copies the published slot,
+     * and only has to retry if the writer came back around to that slot while
+     * it was copying, which takes two more stores.
+     *
+     * T is copied while the writer may be writing it, so it must be a plain
+     * value type, where a torn copy is harmless once it has been discarded.
+     */
+    template<typename T>
+    class SeqLock {
+        public:
+            using value_type = T;
+            using seq_type = uint32_t;
+
+            SeqLock() : m_slots {}, m_begun { 0 }, m_published { 0 } {}
+            SeqLock(const SeqLock&) = delete; // No copy constructor
+            SeqLock(SeqLock&&) = delete; // No move constructor
+
+            // Writer side
+            void store(const value_type &value)
+            {
+                seq_type seq = m_begun.load(std::memory_order_relaxed)+1;
+                m_begun.store(seq, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+
+                m_slots[seq & 1u] = value;
+
+                m_published.store(seq, std::memory_order_release);
+            }
+
+            // Reader side
+            /**
+             * @brief Copy the latest published value
+             *
+             * @return false if the writer overwrote it during the copy, and value must be discarded
+             */
+            bool try_load(value_type &value) const
+            {
+                seq_type seq = m_published.load(std::memory_order_acquire);
+                value = m_slots[seq & 1u];
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return m_begun.load(std::memory_order_relaxed)-seq<2u;
+            }
+
+            value_type load() const
+            {
+                value_type value;
+                while (!try_load(value)) {
+                }
+                return value;
+            }
+
+            seq_type seq() const { return m_published.load(std::memory_order_acquire); }
+
+        private:
+            value_type m_slots[2];
+            std::atomic<seq_type> m_begun;
+            std::atomic<seq_type> m_published;
+    };
+
+}
@@ -0,0 +1,261 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Fixed point stick shaping, deadband, expo, rate limit and low-pass
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <algorithm>
+#include <pico/stdlib.h>
+
+#include "channels.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief Filter stages, and a chain of them, on centered channel values
+     *
+     * Values are integers in channel units around ChannelValue::CHANNEL_CENTER,
+     * so full deflection is +-HALF_RANGE, the same scale as asFloat(). Every
+     * parameter is a template argument, so a chain is inlined into a handful
+     * of integer operations, and tables are built at compile time.
+     *
+     * A stage provides:
+     *
+     *   value_type operator()(value_type x)  Filter the next value
+     *   void reset(value_type x)             Restart as if x had been steady
+     */
+    namespace Shaping {
+        using value_type = int32_t;
+
+        static constexpr value_type HALF_RANGE { ChannelValue::CHANNEL_RANGE/2 };
+
+
+        /**
+         * @brief Zero within +-WIDTH of center, and rescaled outside it so full deflection is kept
+         */
+        template<value_type WIDTH>
+        class Deadband {
+            public:
+                static_assert(WIDTH>=0 && WIDTH<HALF_RANGE, "Deadband must leave some travel");
+
+                value_type operator()(value_type x) const
+                {
+                    if (x>WIDTH) {
+                        return (x-WIDTH)*HALF_RANGE/(HALF_RANGE-WIDTH);
+                    }
+                    if (x<-WIDTH) {
+                        return (x+WIDTH)*HALF_RANGE/(HALF_RANGE-WIDTH);
+                    }
+                    return 0;
+                }
+
+                void reset(value_type) {}
+        };
+
+
+        /**
+         * @brief Expo curve, y = (1-e)x + e x^3, e = PERCENT/100, from a table of POINTS
+         *
+         * The table covers 0..HALF_RANGE, and is interpolated linearly, the
+         * curve is mirrored for negative values. Values beyond full deflection
+         * are clamped.
+         */
+        template<uint PERCENT, size_t POINTS=33>
+        class Expo {
+            public:
+                static_assert(PERCENT<=100, "Expo is 0-100%");
+                static_assert(POINTS>=2, "Expo table needs its end points");
+
+                using table_type = std::array<value_type, POINTS>;
+
+                // The exact curve
+                static constexpr value_type curve(value_type x)
+                {
+                    constexpr int64_t H2 { static_cast<int64_t>(HALF_RANGE)*HALF_RANGE };
+                    int64_t num = static_cast<int64_t>(x)*(100-PERCENT)*H2+static_cast<int64_t>(PERCENT)*x*x*x;
+                    int64_t den = 100*H2;
+                    return static_cast<value_type>((num+den/2)/den);
+                }
+
+                /**
+                 * @brief Point i of the table, at x = i*HALF_RANGE/(POINTS-1), which needn't be a whole number
+                 */
+                static constexpr value_type point(size_t i)
+                {
+                    constexpr int64_t K { POINTS-1 };
+                    const int64_t n = static_cast<int64_t>(i);
+                    int64_t num = n*HALF_RANGE*((100-PERCENT)*K*K+PERCENT*n*n);
+                    int64_t den = 100*K*K*K;
+                    return static_cast<value_type>((num+den/2)/den);
+                }
+
+                static constexpr table_type make_table()
+                {
+                    table_type table {};
+                    for (size_t i=0; i<POINTS; ++i) {
+                        table[i] = point(i);
+                    }
+                    return table;
+                }
+
+                static constexpr table_type TABLE { make_table() };
+
+                value_type operator()(value_type x) const
+                {
+                    value_type mag = std::min(x<0 ? -x : x, HALF_RANGE);
+                    value_type pos = mag*static_cast<value_type>(POINTS-1);
+                    size_t i = static_cast<size_t>(pos/HALF_RANGE);
+                    value_type frac = pos%HALF_RANGE;
+                    value_type y = TABLE[i];
+                    if (frac) {
+                        y += ((TABLE[i+1]-TABLE[i])*frac+HALF_RANGE/2)/HALF_RANGE;
+                    }
+                    return x<0 ? -y : y;
+                }
+
+                void reset(value_type) {}
+        };
+
+
+        /**
+         * @brief Move at most MAX_STEP per frame
+         */
+        template<value_type MAX_STEP>
+        class RateLimit {
+            public:
+                static_assert(MAX_STEP>0, "Rate limit must allow movement");
+
+                value_type operator()(value_type x)
+                {
+                    m_last = std::clamp(x, m_last-MAX_STEP, m_last+MAX_STEP);
+                    return m_last;
+                }
+
+                void reset(value_type x) { m_last = x; }
+
+            private:
+                value_type m_last { 0 };
+        };
+
+
+        /**
+         * @brief One-pole low-pass, y += (x-y)/2^SHIFT per frame
+         *
+         * The state keeps SHIFT fraction bits, so the output settles on x
+         * exactly instead of stalling short of it.
+         */
+        template<uint SHIFT>
+        class LowPass {
+            public:
+                static_assert(SHIFT>0 && SHIFT<16, "Low-pass shift out of range");
+
+                value_type operator()(value_type x)
+                {
+                    m_acc += x-(m_acc>>SHIFT);
+                    return m_acc>>SHIFT;
+                }
+
+                void reset(value_type x) { m_acc = x*(1<<SHIFT); }
+
+            private:
+                value_type m_acc { 0 };
+        };
+
+
+        /**
+         * @brief Stages applied in order
+         */
+        template<typename... Stages>
+        class Chain {
+            public:
+                value_type operator()(value_type x)
+                {
+                    std::apply([&x](auto&... stage) { ((x = stage(x)), ...); }, m_stages);
+                    return x;
+                }
+
+                void reset(value_type x)
+                {
+                    std::apply([&x](auto&... stage) { ((stage.reset(x), x = stage(x)), ...); }, m_stages);
+                }
+
+            private:
+                std::tuple<Stages...> m_stages;
+        };
+    }
+
+
+    /**
+     * @brief Shapes the channels of a frame, before they are delivered, see Receiver::set_shaper()
+     */
+    class ChannelShaper {
+        public:
+            virtual ~ChannelShaper() = default;
+
+            virtual void shape(Channels &channels) = 0;
+            virtual void reset() = 0;
+    };
+
+
+    /**
+     * @brief The same chain of Stages on every channel in MASK (ChangeMask channel bits)
+     *
+     * Every channel has its own filter state. The state is restarted from the
+     * first frame after sync is (re)gained, so a stick isn't slewed in from
+     * where it was before the dropout. Frames without sync are passed as is.
+     */
+    template<ChangeMask::value_type MASK, typename... Stages>
+    class ChannelFilter : public ChannelShaper {
+        public:
+            using chain_type = Shaping::Chain<Stages...>;
+
+            static_assert(MASK!=0 && (MASK & ChangeMask::LINK)==0, "Filter needs some channels, and only channels");
+
+            static constexpr size_t channels_in(ChangeMask::value_type mask)
+            {
+                size_t n = 0;
+                while (mask) {
+                    mask >>= 1;
+                    n++;
+                }
+                return n;
+            }
+
+            static constexpr size_t CHANNELS { channels_in(MASK) };
+
+            static_assert(CHANNELS<=Channels::MAX_CHANNELS, "Filter channels out of range");
+
+            virtual void shape(Channels &channels) override
+            {
+                if (!channels.sync()) {
+                    m_valid = false;
+                    return;
+                }
+                const size_t count = std::min(CHANNELS, channels.count());
+                for (size_t n=0; n<count; ++n) {
+                    if ((MASK & ChangeMask::channel_bit(n))==0) continue;
+
+                    Shaping::value_type x = static_cast<Shaping::value_type>(channels[n].raw())-ChannelValue::CHANNEL_CENTER;
+                    if (!m_valid) {
+                        m_chains[n].reset(x);
+                    }
+                    Shaping::value_type y = m_chains[n](x)+ChannelValue::CHANNEL_CENTER;
+                    channels.set_channel(n, static_cast<ChannelValue::raw_type>(std::clamp<Shaping::value_type>(y, ChannelValue::CHANNEL_MIN, ChannelValue::CHANNEL_MAX)));
+                }
+                m_valid = true;
+            }
+
+            virtual void reset() override { m_valid = false; }
+
+        private:
+            std::array<chain_type, CHANNELS> m_chains;
+            bool m_valid { false };
+    };
+
+}
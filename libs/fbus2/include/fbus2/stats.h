@@ -0,0 +1,255 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Radio receiver timing and error statistics
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <stdio.h>
+#include <inttypes.h>
+#include <pico/stdlib.h>
+
+// Set to 0 to compile the receiver statistics out
+#ifndef FBUS2_STATS
+#define FBUS2_STATS 1
+#endif
+
+namespace FBus2 {
+
+    /**
+     * @brief Count, min, max and mean of a series of values
+     */
+    class Summary {
+        public:
+            Summary() { reset(); }
+
+            void add(int64_t value)
+            {
+                m_count++;
+                m_sum += value;
+                m_min = std::min(m_min, value);
+                m_max = std::max(m_max, value);
+            }
+
+            void reset()
+            {
+                m_count = 0;
+                m_sum = 0;
+                m_min = INT64_MAX;
+                m_max = INT64_MIN;
+            }
+
+            uint count() const   { return m_count; }
+            int64_t min() const  { return m_count ? m_min : 0; }
+            int64_t max() const  { return m_count ? m_max : 0; }
+            int64_t mean() const { return m_count ? m_sum/m_count : 0; }
+            int64_t sum() const  { return m_sum; }
+
+        private:
+            uint m_count;
+            int64_t m_sum;
+            int64_t m_min;
+            int64_t m_max;
+    };
+
+
+    /**
+     * @brief Histogram with BINS bins of WIDTH, the last bin also counts everything above
+     */
+    template<size_t BINS, int64_t WIDTH>
+    class Histogram {
+        public:
+            static constexpr size_t SIZE { BINS };
+            static constexpr int64_t BIN_WIDTH { WIDTH };
+
+            Histogram() { reset(); }
+
+            void add(int64_t value)
+            {
+                size_t bin = value<0 ? 0 : std::min(static_cast<size_t>(value/WIDTH), BINS-1);
+                m_bins[bin]++;
+            }
+
+            void reset() { m_bins.fill(0); }
+
+            uint operator[](size_t n) const { return m_bins[n]; }
+            uint total() const
+            {
+                uint total = 0;
+                for (auto n : m_bins) {
+                    total += n;
+                }
+                return total;
+            }
+
+        private:
+            std::array<uint, BINS> m_bins;
+    };
+
+
+    enum class FrameType {
+        CONTROL,
+        DOWNLINK,
+        UPLINK,
+        COUNT
+    };
+
+
+    #if FBUS2_STATS
+
+    /**
+     * @brief Receiver timing and error statistics
+     *
+     * Recorded by the receiver task only. Reads from other tasks are not
+     * synchronized, so a value may be one frame behind.
+     */
+    class ReceiverStats {
+        public:
+            static constexpr bool ENABLED { true };
+            using jitter_type = Histogram<16, 100>;  // us
+
+            ReceiverStats() : m_last_control { nil_time }, m_last_interval { -1 }, m_sync_begin { nil_time } { reset(); }
+
+            // Recording
+            /**
+             * @brief A valid control frame has been parsed
+             *
+             * @param rx_time Time the ISR received the last byte of the frame
+             */
+            void control_frame(absolute_time_t rx_time, absolute_time_t now)
+            {
+                if (!is_nil_time(m_last_control)) {
+                    int64_t interval = absolute_time_diff_us(m_last_control, rx_time);
+                    m_interval.add(interval);
+                    if (m_last_interval>=0) {
+                        m_jitter.add(std::abs(interval-m_last_interval));
+                    }
+                    m_last_interval = interval;
+                }
+                m_last_control = rx_time;
+                m_parse_latency.add(absolute_time_diff_us(rx_time, now));
+            }
+
+            void crc_failure(FrameType type) { m_crc_failures[static_cast<size_t>(type)]++; }
+
+            void sync_begin(absolute_time_t now)
+            {
+                m_sync_begin = now;
+                m_sync_wakeups_begin = m_rx_wakeups;
+                m_last_interval = -1; // Don't count the gap as jitter
+                m_last_control = nil_time;
+            }
+
+            void sync_found(absolute_time_t now)
+            {
+                if (!is_nil_time(m_sync_begin)) {
+                    m_sync.add(absolute_time_diff_us(m_sync_begin, now));
+                    m_sync_wakeups.add(m_rx_wakeups-m_sync_wakeups_begin);
+                    m_sync_begin = nil_time;
+                }
+            }
+
+            void rx_wakeup() { m_rx_wakeups++; }  // Data received from the stream buffer
+            void rx_pending(size_t bytes) { m_rx_high_water = std::max(m_rx_high_water, bytes); }
+
+            void uplink_latency(int64_t us) { m_uplink_latency.add(us); }
+
+            // Query
+            const Summary &interval() const          { return m_interval; }
+            const jitter_type &jitter() const        { return m_jitter; }
+            const Summary &parse_latency() const     { return m_parse_latency; }
+            uint crc_failures(FrameType type) const  { return m_crc_failures[static_cast<size_t>(type)]; }
+            const Summary &sync() const              { return m_sync; }   // Count and duration of (re)syncs
+            const Summary &sync_wakeups() const      { return m_sync_wakeups; }
+            uint rx_wakeups() const                  { return m_rx_wakeups; }
+            size_t rx_high_water() const             { return m_rx_high_water; }
+            const Summary &uplink_latency() const    { return m_uplink_latency; }
+
+            void reset()
+            {
+                m_interval.reset();
+                m_jitter.reset();
+                m_parse_latency.reset();
+                m_crc_failures.fill(0);
+                m_sync.reset();
+                m_sync_wakeups.reset();
+                m_rx_wakeups = 0;
+                m_sync_wakeups_begin = 0;
+                m_rx_high_water = 0;
+                m_uplink_latency.reset();
+            }
+
+            void print() const
+            {
+                printf("Receiver stats:\n");
+                printf("  interval      n=%u  min=%" PRId64 "  mean=%" PRId64 "  max=%" PRId64 " us\n", m_interval.count(), m_interval.min(), m_interval.mean(), m_interval.max());
+                printf("  jitter        ");
+                for (size_t i=0; i<jitter_type::SIZE; ++i) {
+                    printf("%u ", m_jitter[i]);
+                }
+                printf(" (%" PRId64 " us bins)\n", jitter_type::BIN_WIDTH);
+                printf("  isr to parse  n=%u  min=%" PRId64 "  mean=%" PRId64 "  max=%" PRId64 " us\n", m_parse_latency.count(), m_parse_latency.min(), m_parse_latency.mean(), m_parse_latency.max());
+                printf("  crc failures  control=%u  downlink=%u  uplink=%u\n", crc_failures(FrameType::CONTROL), crc_failures(FrameType::DOWNLINK), crc_failures(FrameType::UPLINK));
+                printf("  syncs         n=%u  mean=%" PRId64 "  max=%" PRId64 " us  wakeups mean=%" PRId64 "  max=%" PRId64 "\n", m_sync.count(), m_sync.mean(), m_sync.max(), m_sync_wakeups.mean(), m_sync_wakeups.max());
+                printf("  rx wakeups    %u\n", m_rx_wakeups);
+                printf("  rx high water %zu bytes\n", m_rx_high_water);
+                printf("  uplink        n=%u  min=%" PRId64 "  mean=%" PRId64 "  max=%" PRId64 " us\n", m_uplink_latency.count(), m_uplink_latency.min(), m_uplink_latency.mean(), m_uplink_latency.max());
+            }
+
+        private:
+            Summary m_interval;
+            jitter_type m_jitter;
+            Summary m_parse_latency;
+            std::array<uint, static_cast<size_t>(FrameType::COUNT)> m_crc_failures;
+            Summary m_sync;
+            Summary m_sync_wakeups;
+            uint m_rx_wakeups;
+            size_t m_rx_high_water;
+            Summary m_uplink_latency;
+
+            absolute_time_t m_last_control;
+            int64_t m_last_interval;
+            absolute_time_t m_sync_begin;
+            uint m_sync_wakeups_begin;
+    };
+
+    #else
+
+    /**
+     * @brief Receiver statistics compiled out, everything is a no-op
+     */
+    class ReceiverStats {
+        public:
+            static constexpr bool ENABLED { false };
+            using jitter_type = Histogram<1, 1>;
+
+            void control_frame(absolute_time_t rx_time, absolute_time_t now) {}
+            void crc_failure(FrameType type) {}
+            void sync_begin(absolute_time_t now) {}
+            void sync_found(absolute_time_t now) {}
+            void rx_wakeup() {}
+            void rx_pending(size_t bytes) {}
+            void uplink_latency(int64_t us) {}
+
+            Summary interval() const                 { return {}; }
+            jitter_type jitter() const               { return {}; }
+            Summary parse_latency() const            { return {}; }
+            uint crc_failures(FrameType type) const  { return 0; }
+            Summary sync() const                     { return {}; }
+            Summary sync_wakeups() const             { return {}; }
+            uint rx_wakeups() const                  { return 0; }
+            size_t rx_high_water() const             { return 0; }
+            Summary uplink_latency() const           { return {}; }
+
+            void reset() {}
+            void print() const {}
+    };
+
+    #endif
+
+}
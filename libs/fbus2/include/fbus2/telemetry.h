@@ -9,6 +9,7 @@
 #pragma once
 
 #include <string.h>
+#include <assert.h>
 #include <stdio.h>
 #include <pico/stdlib.h>
 
@@ -213,6 +214,19 @@ namespace FBus2 {
         }
 
 
+        static Telemetry cells_mv(uint8_t battery_id, uint8_t offset, uint8_t n_cells, uint32_t mv0, uint32_t mv1)
+        {
+            uint16_t app_id = FRDID_CELLS_FIRST_ID+offset;
+            uint32_t cv1 = mv0/2;
+            uint32_t cv2 = mv1/2;
+            uint32_t data = (cv1 & 0x0fff) << 20 | (cv2 & 0x0fff) << 8 | n_cells << 4 | battery_id;
+            return {
+                .app_id = app_id,
+                .data   = data,
+            };
+        }
+
+
         static Telemetry a3(uint8_t offset, float voltage)
         {
             return {
@@ -230,6 +244,23 @@ namespace FBus2 {
         }
 
 
+        static Telemetry a3_mv(uint8_t offset, uint32_t mv)
+        {
+            return {
+                .app_id = static_cast<app_id_type>(FRDID_A3_FIRST_ID+offset),
+                .data   = static_cast<data_type>((mv+5)/10),
+            };
+        }
+
+        static Telemetry a4_mv(uint8_t offset, uint32_t mv)
+        {
+            return {
+                .app_id = static_cast<app_id_type>(FRDID_A4_FIRST_ID+offset),
+                .data   = static_cast<data_type>((mv+5)/10),
+            };
+        }
+
+
         static Telemetry current(uint8_t offset, float current_ma)
         {
             return {
@@ -238,6 +269,14 @@ namespace FBus2 {
             };
         }
 
+        static Telemetry current_ma(uint8_t offset, uint32_t ma)
+        {
+            return {
+                .app_id = static_cast<app_id_type>(FRDID_CURR_FIRST_ID+offset),
+                .data   = static_cast<data_type>(ma*10),
+            };
+        }
+
         static Telemetry rpm(uint8_t offset, float rpm)
         {
             int32_t val = 10.0f*rpm + 0.5f;
@@ -247,6 +286,27 @@ namespace FBus2 {
             };
         }
 
+        /**
+         * @brief RPM from encoder counts over a period, as rpm(offset, counts*60e6/(counts_per_rev*period_us))
+         *
+         * Sends 0 rpm if counts_per_rev or period_us is 0.
+         */
+        static Telemetry rpm_counts(uint8_t offset, int32_t counts, uint32_t counts_per_rev, uint32_t period_us)
+        {
+            assert(counts_per_rev>0 && period_us>0);
+            if (counts_per_rev==0 || period_us==0) {
+                return rpm(offset, 0.0f);
+            }
+            // 10*rpm+0.5, truncated like the float version
+            int64_t num = static_cast<int64_t>(counts)*600000000ll;
+            int64_t den = static_cast<int64_t>(counts_per_rev)*period_us;
+            int32_t val = static_cast<int32_t>((2*num+den)/(2*den));
+            return {
+                .app_id = static_cast<app_id_type>(FRDID_RPM_FIRST_ID+offset),
+                .data   = (data_type)val,
+            };
+        }
+
         static Telemetry sbec(uint8_t offset, float voltage, float current) 
         {
             return {
@@ -264,6 +324,16 @@ namespace FBus2 {
                 .data   = (data_type)val,
             };
         }
+        /**
+         * @brief DIY value in hundredths (centidegrees), as diy(off, centi/100.0f)
+         */
+        static Telemetry diy_centi(uint16_t off , int32_t centi)
+        {
+            return {
+                .app_id = static_cast<app_id_type>(FRDID_DIY_FIRST_ID+off),
+                .data   = (data_type)((centi+5)/10),
+            };
+        }
         static Telemetry diy(uint16_t off , int32_t data)
         {
             return {
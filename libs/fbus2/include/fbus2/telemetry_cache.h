@@ -0,0 +1,58 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Pre-encoded telemetry values, ready for the uplink
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <pico/stdlib.h>
+
+#include "telemetry.h"
+#include "seqlock.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief Latest encoded telemetry word for each value
+     *
+     * Producers (the sensor tasks) encode their values when they have new data,
+     * and store them here. The uplink path only copies the stored word, without
+     * taking any locks or doing any math, so it is done well within the reply
+     * window.
+     *
+     * Each value must only be stored from one task.
+     */
+    template<size_t N>
+    class TelemetryCache {
+        public:
+            TelemetryCache() = default;
+            TelemetryCache(const TelemetryCache&) = delete; // No copy constructor
+            TelemetryCache(TelemetryCache&&) = delete; // No move constructor
+
+            // Producer side
+            void store(size_t n, const Telemetry &telemetry) { m_values[n].store(telemetry); }
+
+            // Uplink side
+            /**
+             * @brief Latest value stored, null if nothing has been stored yet
+             */
+            Telemetry load(size_t n) const
+            {
+                if (m_values[n].seq()==0) {
+                    return Telemetry::null();
+                }
+                return m_values[n].load();
+            }
+
+            uint updates(size_t n) const { return m_values[n].seq(); }
+
+            static constexpr size_t size() { return N; }
+
+        private:
+            SeqLock<Telemetry> m_values[N];
+    };
+
+}
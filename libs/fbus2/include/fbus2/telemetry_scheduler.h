@@ -0,0 +1,162 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Uplink slot scheduling of telemetry values
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <pico/stdlib.h>
+
+namespace FBus2 {
+
+    /**
+     * @brief Target update rate and priority of one telemetry value
+     */
+    struct TelemetryRate {
+        const char *name;
+        uint rate_mhz;  // Target updates per 1000s
+        uint priority;  // Higher wins when several values are due
+
+        static constexpr uint hz(float rate) { return static_cast<uint>(rate*1000.0f); }
+    };
+
+
+    /**
+     * @brief Picks the telemetry value to send in each uplink slot
+     *
+     * Every value earns credit at its target rate, and sending it costs one
+     * update worth of credit (deficit round robin). In each slot:
+     *
+     *  1. Of the values that are due (a full update of credit), the one with
+     *     the highest priority is sent, then the one furthest behind, then the
+     *     next in round robin order.
+     *  2. If nothing is due, the value that will be due first is sent early, so
+     *     no slot is wasted. Every value is credited as if time had skipped
+     *     ahead to that point, so spare slots are shared in proportion to the
+     *     target rates.
+     *
+     * Credit is capped, so a value that could not be sent for a while gets one
+     * catch up update, and not a burst of stale ones.
+     *
+     * Time is passed in by the caller, so it can be run off the uplink slots.
+     */
+    template<size_t N>
+    class TelemetryScheduler {
+        public:
+            using config_type = std::array<TelemetryRate, N>;
+
+            static constexpr int64_t UPDATE { 1000000000ll }; // One update of credit, rate in mHz times time in us
+            static constexpr int64_t CREDIT_MAX { 2*UPDATE };
+
+            constexpr TelemetryScheduler(const config_type &config) :
+                m_config { config },
+                m_credit {},
+                m_count {},
+                m_next { 0 },
+                m_last_us { -1 },
+                m_stats_begin_us { -1 }
+            {
+                static_assert(N>0, "Nothing to schedule");
+            }
+
+            /**
+             * @brief Index of the value to send in this slot
+             */
+            size_t next(int64_t now_us)
+            {
+                if (m_last_us<0) {
+                    m_last_us = now_us;
+                    m_stats_begin_us = now_us;
+                    m_credit.fill(UPDATE); // Send everything once at start
+                }
+                int64_t dt = now_us-m_last_us;
+                m_last_us = now_us;
+
+                add_credit(dt);
+
+                size_t best = m_next;
+                for (size_t n=1; n<N; ++n) {
+                    size_t i = (m_next+n) % N;
+                    if (better(i, best)) {
+                        best = i;
+                    }
+                }
+
+                if (!due(best) && m_config[best].rate_mhz>0) {
+                    // Spare slot, skip ahead to when the first value is due
+                    int64_t rate = m_config[best].rate_mhz;
+                    add_credit((UPDATE-m_credit[best]+rate-1)/rate);
+                }
+
+                m_credit[best] -= UPDATE;
+                m_count[best]++;
+                m_next = (best+1) % N;
+                return best;
+            }
+
+            static constexpr size_t size() { return N; }
+            const TelemetryRate &config(size_t n) const { return m_config[n]; }
+
+            // Stats
+            uint count(size_t n) const { return m_count[n]; }
+
+            /**
+             * @brief Achieved updates per 1000s since the stats were last reset
+             */
+            uint achieved_mhz(size_t n, int64_t now_us) const
+            {
+                int64_t elapsed = now_us-m_stats_begin_us;
+                if (m_stats_begin_us<0 || elapsed<=0) {
+                    return 0;
+                }
+                return static_cast<uint>(static_cast<int64_t>(m_count[n])*UPDATE/elapsed);
+            }
+
+            void reset_stats(int64_t now_us)
+            {
+                m_count.fill(0);
+                m_stats_begin_us = now_us;
+            }
+
+        private:
+            const config_type m_config;
+            std::array<int64_t, N> m_credit;
+            std::array<uint, N> m_count;
+            size_t m_next;
+            int64_t m_last_us;
+            int64_t m_stats_begin_us;
+
+            bool due(size_t i) const { return m_credit[i]>=UPDATE; }
+
+            void add_credit(int64_t dt)
+            {
+                for (size_t i=0; i<N; ++i) {
+                    m_credit[i] = std::min(m_credit[i]+static_cast<int64_t>(m_config[i].rate_mhz)*dt, CREDIT_MAX);
+                }
+            }
+
+            /**
+             * @brief Should a be sent before b, b is earlier in the round robin order
+             */
+            bool better(size_t a, size_t b) const
+            {
+                if (due(a)!=due(b)) {
+                    return due(a);
+                }
+                if (due(a)) {
+                    if (m_config[a].priority!=m_config[b].priority) {
+                        return m_config[a].priority>m_config[b].priority;
+                    }
+                    return m_credit[a]>m_credit[b];
+                }
+                // Neither is due, the one that will be due first, (UPDATE-credit)/rate compared without dividing
+                return (UPDATE-m_credit[a])*m_config[b].rate_mhz < (UPDATE-m_credit[b])*m_config[a].rate_mhz;
+            }
+    };
+
+}
@@ -0,0 +1,73 @@
+/**
+ * @author Peter Christoffersen
+ * @brief FrSky FPort protocol definitions
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ * https://github.com/betaflight/betaflight/wiki/The-FrSky-FPort-Protocol
+ * 
+ * 115200 baud, 8N1, inverted.
+ * 
+ */
+#pragma once
+
+#include "protocol.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief Frame, byte stuffed between delimiters
+     * 
+     * 0x7E|<LEN>|<TYPE>|<PAYLOAD>|<CRC>|0x7E
+     * 
+     * LEN: Size of TYPE and PAYLOAD
+     * CRC: FrSky checksum of LEN, TYPE and PAYLOAD, as fbus_checksum()
+     * 
+     * 0x7E and 0x7D in LEN..CRC are sent as 0x7D followed by the byte xor 0x20.
+     * The uplink from the flight controller goes out without delimiters, 
+     * between the downlink and the next control frame.
+     */
+    static constexpr uint8_t FPORT_DELIMITER  = 0x7E;
+    static constexpr uint8_t FPORT_ESCAPE     = 0x7D;
+    static constexpr uint8_t FPORT_ESCAPE_XOR = 0x20;
+
+    static constexpr uint8_t FPORT_TYPE_CONTROL  = 0x00;
+    static constexpr uint8_t FPORT_TYPE_DOWNLINK = 0x01;
+    static constexpr uint8_t FPORT_TYPE_UPLINK   = 0x81;
+
+    // Offsets in the unstuffed frame, from LEN
+    static constexpr size_t FPORT_LEN_OFFSET     = 0u;
+    static constexpr size_t FPORT_TYPE_OFFSET    = 1u;
+    static constexpr size_t FPORT_PAYLOAD_OFFSET = 2u;
+
+    static constexpr size_t fport_frame_size(uint8_t len) { return len+2u; } // Unstuffed, with LEN and CRC
+
+    template <typename buffer_type> 
+    static inline uint8_t fport_crc(const buffer_type &buffer) 
+    { 
+        return buffer[fport_frame_size(buffer[FPORT_LEN_OFFSET])-1];
+    }
+
+    // Control frame, SBUS channel data, flags and RSSI
+    static constexpr uint8_t FPORT_CONTROL_LEN           = 0x19;
+    static constexpr size_t  FPORT_CONTROL_CHANNEL_COUNT = 16u;
+    static constexpr size_t  FPORT_CONTROL_FLAGS_OFFSET  = 24u;
+    static constexpr size_t  FPORT_CONTROL_RSSI_OFFSET   = 25u;
+    static constexpr uint8_t FPORT_CONTROL_FLAGS_MASK    = 0x0F;
+
+    // Downlink, a sensor poll, and uplink, the response. Same payload as FBus2 downlink and uplink, without the id
+    static constexpr uint8_t FPORT_DOWNLINK_LEN     = 0x08;
+    static constexpr uint8_t FPORT_UPLINK_LEN       = 0x08;
+    static constexpr size_t  FPORT_PRIM_OFFSET      = 2u;
+    static constexpr uint8_t FPORT_PRIM_NULL        = 0x00;
+    static constexpr uint8_t FPORT_PRIM_DATA        = 0x10;
+    static constexpr int64_t FPORT_UPLINK_SEND_DELAY_MAX_US = 2500ll;
+
+    static constexpr uint8_t FPORT_MAX_LEN = FPORT_CONTROL_LEN;
+
+    static_assert(FPORT_PAYLOAD_OFFSET+FPORT_CONTROL_CHANNEL_COUNT*FBUS_CHANNEL_BITS/8==FPORT_CONTROL_FLAGS_OFFSET, "Expected channel data to fill up to the flags");
+
+    static constexpr bool fport_needs_escape(uint8_t byte) { return byte==FPORT_DELIMITER || byte==FPORT_ESCAPE; }
+
+}
@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <utility>
 
 namespace FBus2 {
 
@@ -68,6 +69,16 @@ namespace FBus2 {
     } __attribute__((__packed__)) fbus_control_24_t;
 
     
+    static inline bool fbus_control_size_valid(uint8_t size)
+    {
+        return size==FBUS_CONTROL_8CH_SIZE || size==FBUS_CONTROL_16CH_SIZE || size==FBUS_CONTROL_24CH_SIZE;
+    }
+
+    static inline size_t fbus_control_channel_count(uint8_t size)
+    {
+        return 8u*(size-2u)/FBUS_CONTROL_8_VALUE_SIZE;
+    }
+
     template <typename buffer_type> 
     static inline uint8_t fbus_control_size(const buffer_type &buffer) 
     { 
@@ -80,6 +91,18 @@ namespace FBus2 {
         return buffer[buffer[0]+FBUS_CONTROL_HDR_SIZE]; 
     }
 
+    template <typename buffer_type> 
+    static inline uint8_t fbus_control_flags(const buffer_type &buffer) 
+    { 
+        return buffer[buffer[0]+FBUS_CONTROL_HDR_SIZE-2]; 
+    }
+
+    template <typename buffer_type> 
+    static inline uint8_t fbus_control_rssi(const buffer_type &buffer) 
+    { 
+        return buffer[buffer[0]+FBUS_CONTROL_HDR_SIZE-1]; 
+    }
+
     // Downlink package
     static constexpr uint8_t FBUS_DOWNLINK_HDR      = 0x08;
     static constexpr size_t  FBUS_DOWNLINK_HDR_SIZE = 1u;
@@ -91,6 +114,12 @@ namespace FBus2 {
         return buffer[buffer[0]+FBUS_DOWNLINK_HDR_SIZE]; 
     }
 
+    template <typename buffer_type> 
+    static inline uint8_t fbus_downlink_id(const buffer_type &buffer) 
+    { 
+        return buffer[FBUS_DOWNLINK_HDR_SIZE]; 
+    }
+
     typedef struct {
         uint8_t size;
         uint8_t id;
@@ -153,26 +182,90 @@ namespace FBus2 {
 
 
     /**
-     * @brief Extracts 8 channels (11 bit per channel) from fbus package
+     * @brief Channel data is packed as 11 bit values, LSB first
+     */
+    static constexpr uint   FBUS_CHANNEL_BITS { 11u };
+    static constexpr uint32_t FBUS_CHANNEL_MASK { (1u<<FBUS_CHANNEL_BITS)-1u };
+
+    /**
+     * @brief Compile time position of packed channel CH
+     * 
+     * A channel always spans 2 or 3 bytes, WIDE is set when it needs the 3rd.
+     */
+    template <size_t CH>
+    struct fbus_channel_pos {
+        static constexpr size_t BIT   { CH*FBUS_CHANNEL_BITS };
+        static constexpr size_t BYTE  { BIT/8u };
+        static constexpr uint   SHIFT { BIT%8u };
+        static constexpr bool   WIDE  { SHIFT+FBUS_CHANNEL_BITS>16u };
+    };
+
+    /**
+     * @brief Extract a single packed channel
+     * 
+     * The bytes holding the channel are combined into a 32 bit word, and the
+     * value is shifted and masked out of it. Offsets and shifts are all known 
+     * at compile time.
+     * 
+     * @tparam value_type Type of the channel value
+     * @tparam CH Channel number in the packed data
+     * @param src Source buffer
+     * @param src_offset Offset of the packed data in the source buffer
+     */
+    template <typename value_type, size_t CH, typename source_buffer_type>
+    static inline value_type fbus_get_channel(const source_buffer_type &src, size_t src_offset)
+    {
+        using pos = fbus_channel_pos<CH>;
+        const size_t off = src_offset+pos::BYTE;
+        uint32_t word = static_cast<uint32_t>(src[off]) | (static_cast<uint32_t>(src[off+1]) << 8);
+        if constexpr (pos::WIDE) {
+            word |= static_cast<uint32_t>(src[off+2]) << 16;
+        }
+        return static_cast<value_type>((word >> pos::SHIFT) & FBUS_CHANNEL_MASK);
+    }
+
+    template <typename value_type, typename source_buffer_type, typename dest_buffer_type, size_t... CH>
+    static inline void fbus_unpack_channels(const source_buffer_type &src, size_t src_offset, dest_buffer_type &dst, size_t dst_offset, std::index_sequence<CH...>)
+    {
+        ((dst[dst_offset+CH] = fbus_get_channel<value_type, CH>(src, src_offset)), ...);
+    }
+
+    /**
+     * @brief Extracts N channels (11 bit per channel) from fbus package
      * 
-     * @tparam source_buffer_type Type of source buffer
-     * @tparam dest_buffer_type Type of destination buffer
+     * @tparam value_type Type of the channel values
+     * @tparam N Number of channels
      * @param src Source buffer
      * @param src_offset Offset into source buffer
      * @param dst Destination buffer
      * @param dst_offset Offset into destination
      */
+    template <typename value_type, size_t N, typename source_buffer_type, typename dest_buffer_type>
+    static inline void fbus_unpack_channels(const source_buffer_type &src, size_t src_offset, dest_buffer_type &dst, size_t dst_offset=0)
+    {
+        fbus_unpack_channels<value_type>(src, src_offset, dst, dst_offset, std::make_index_sequence<N>{});
+    }
+
+    /**
+     * @brief Extracts all channels from a validated control package
+     * 
+     * @return size_t Number of channels extracted
+     */
     template <typename value_type, typename source_buffer_type, typename dest_buffer_type>
-    void fbus_get_8channel(const source_buffer_type &src, size_t src_offset, dest_buffer_type &dst, size_t dst_offset)
+    static inline size_t fbus_control_channels(const source_buffer_type &src, dest_buffer_type &dst)
     {
-        dst[dst_offset  ] = (static_cast<value_type>(src[src_offset+0]))           + ((0x07 & src[src_offset+1])<<8);
-        dst[dst_offset+1] = (static_cast<value_type>(0xF8 & src[src_offset+1])>>3) + ((0x3F & src[src_offset+2])<<5);
-        dst[dst_offset+2] = (static_cast<value_type>(0xC0 & src[src_offset+2])>>6) + (src[src_offset+3]<<2) + ((0x01 & src[src_offset+4])<<10);
-        dst[dst_offset+3] = (static_cast<value_type>(0xFE & src[src_offset+4])>>1) + ((0x0F & src[src_offset+5])<<7);
-        dst[dst_offset+4] = (static_cast<value_type>(0xF0 & src[src_offset+5])>>4) + ((0x7F & src[src_offset+6])<<4);
-        dst[dst_offset+5] = (static_cast<value_type>(0x80 & src[src_offset+6])>>7) + (src[src_offset+7]<<1) + ((0x03 & src[src_offset+8])<<9);
-        dst[dst_offset+6] = (static_cast<value_type>(0xFC & src[src_offset+8])>>2) + ((0x1F & src[src_offset+9])<<6);
-        dst[dst_offset+7] = (static_cast<value_type>(0xF0 & src[src_offset+9])>>5) + ((src[src_offset+10])<<3);
+        switch (src[0]) {
+            case FBUS_CONTROL_8CH_SIZE:
+                fbus_unpack_channels<value_type, 8>(src, FBUS_CONTROL_HDR_SIZE, dst);
+                return 8;
+            case FBUS_CONTROL_16CH_SIZE:
+                fbus_unpack_channels<value_type, 16>(src, FBUS_CONTROL_HDR_SIZE, dst);
+                return 16;
+            case FBUS_CONTROL_24CH_SIZE:
+                fbus_unpack_channels<value_type, 24>(src, FBUS_CONTROL_HDR_SIZE, dst);
+                return 24;
+        }
+        return 0;
     }
 
 
@@ -0,0 +1,234 @@
+/**
+ * @file protocol_fbus2.cpp
+ * @author Peter Christoffersen
+ * @brief
+ * @version 0.1
+ * @date 2022-07-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Implementation of the FrSky FBus2 protocol.
+ *
+ */
+#include <fbus2/protocol_fbus2.h>
+
+#include <pico/stdlib.h>
+
+#include "protocol.h"
+
+namespace FBus2 {
+
+
+void FBus2Protocol::begin_sync(Receiver &rx)
+{
+    m_state = State::SYNCING;
+    rx.begin_sync();
+}
+
+
+/**
+ * @brief Run the handler for the current state once
+ */
+bool FBus2Protocol::step(Receiver &rx)
+{
+    switch (m_state) {
+        case State::SYNCING:
+            return do_sync(rx);
+        case State::READ_CONTROL:
+            return do_read_control(rx);
+        case State::READ_DOWNLINK:
+            return do_read_downlink(rx);
+        case State::WRITE_UPLINK:
+            return do_write_uplink(rx);
+        case State::READ_UPLINK:
+            return do_read_uplink(rx);
+        default:
+            assert(false);
+            vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+}
+
+
+/**
+ * @brief Find the next control package, to get back in sync
+ *
+ * The whole window is scanned in one pass for a valid size followed by the
+ * control header, and the first candidate that is complete and has a matching
+ * checksum is taken as the start of a control package. Everything scanned
+ * before it is dropped in one go.
+ *
+ * If the scan is inconclusive, the task waits for just enough data to decide:
+ * the rest of the first candidate, or a full package of the smallest size when
+ * there is no candidate yet. So it is woken once per package worth of data,
+ * and not for every byte.
+ */
+bool FBus2Protocol::do_sync(Receiver &rx)
+{
+    rx.check_sync_timeout();
+
+    auto frame = rx.m_rx_window.view();
+    size_t size = rx.m_rx_window.size();
+    size_t pos = 0;
+    size_t needed = FBUS_CONTROL_HDR_SIZE+FBUS_CONTROL_8CH_SIZE+1;
+    while (pos+1<size) {
+        if (frame[pos+1]!=FBUS_CONTROL_HDR || !fbus_control_size_valid(frame[pos])) {
+            pos++;
+            continue;
+        }
+        // Candidate, check that we have all of it
+        size_t len = FBUS_CONTROL_HDR_SIZE+frame[pos]+1;
+        if (pos+len>size) {
+            needed = len;
+            break;
+        }
+        if (rx.rx_checksum(pos+FBUS_CONTROL_HDR_SIZE, frame[pos])==frame[pos+len-1]) {
+            // Everything checks out - we are in sync
+            rx.rx_window_pop(pos);
+            rx.sync_found();
+            begin_read_control();
+            return true;
+        }
+        // The header can't be a size, so skip both
+        pos += 2;
+    }
+
+    // Drop what has been scanned, but keep a size byte that may be the start of a package
+    rx.rx_window_pop(std::min(pos, size));
+    return rx.rx_window_recv(needed);
+}
+
+
+
+bool FBus2Protocol::do_read_control(Receiver &rx)
+{
+    if (!rx.rx_window_recv(FBUS_CONTROL_HDR_SIZE)) return false;
+    auto frame = rx.m_rx_window.view();
+
+    if (frame[1]!=FBUS_CONTROL_HDR || !fbus_control_size_valid(frame[0])) {
+        // Lost sync
+        begin_sync(rx);
+        return true;
+    }
+
+    const size_t size = fbus_control_size(frame);
+    if (!rx.rx_window_recv(size)) return false;
+
+    // Validate CRC
+    if (rx.rx_checksum(FBUS_CONTROL_HDR_SIZE, frame[0])!=fbus_control_crc(frame)) {
+        rx.m_stats.crc_failure(FrameType::CONTROL);
+        begin_sync(rx);
+        return true;
+    }
+
+    static_assert(FBUS_CONTROL_8CH_SIZE+FBUS_CONTROL_HDR_SIZE+sizeof(fbus_control_8_t::crc)==sizeof(fbus_control_8_t), "Expected control size to match struct");
+    static_assert(FBUS_CONTROL_16CH_SIZE+FBUS_CONTROL_HDR_SIZE+sizeof(fbus_control_16_t::crc)==sizeof(fbus_control_16_t), "Expected control size to match struct");
+    static_assert(FBUS_CONTROL_24CH_SIZE+FBUS_CONTROL_HDR_SIZE+sizeof(fbus_control_24_t::crc)==sizeof(fbus_control_24_t), "Expected control size to match struct");
+    static_assert(Receiver::rx_window_type::capacity() >= sizeof(fbus_control_24_t));
+
+    // Process package directly from the window
+    auto &channels = rx.m_channels;
+    channels.set_flags(fbus_control_flags(frame));
+    channels.set_rssi(fbus_control_rssi(frame));
+    channels.set_count(fbus_control_channel_count(frame[0]));
+    fbus_control_channels<ChannelValue::raw_type>(frame, channels);
+
+    rx.publish_channels(rx.rx_time(size-1));
+
+    rx.rx_window_pop(size);
+
+    begin_read_downlink();
+    return true;
+}
+
+
+bool FBus2Protocol::do_read_downlink(Receiver &rx)
+{
+    // Fill buffer
+    if (!rx.rx_window_recv(FBUS_DOWNLINK_SIZE)) return false;
+    auto frame = rx.m_rx_window.view();
+    if (frame[0]!=FBUS_DOWNLINK_HDR) {
+        begin_sync(rx);
+        return true;
+    }
+
+    // Validate CRC
+    if (rx.rx_checksum(FBUS_DOWNLINK_HDR_SIZE, frame[0])!=fbus_downlink_crc(frame)) {
+        rx.m_stats.crc_failure(FrameType::DOWNLINK);
+        begin_sync(rx);
+        return true;
+    }
+
+    // Process package
+    static_assert(FBUS_DOWNLINK_SIZE==sizeof(fbus_downlink_t), "Expected downlink size to match struct");
+    auto id = fbus_downlink_id(frame);
+    rx.rx_window_pop(FBUS_DOWNLINK_SIZE);
+
+    // Check if we need to respond to downlink
+    if (rx.answers(id)) {
+        begin_write_uplink(id);
+        return true;
+    }
+
+    begin_read_uplink();
+    return true;
+}
+
+
+bool FBus2Protocol::do_write_uplink(Receiver &rx)
+{
+    if (!rx.uplink_in_time(FBUS_UPLINK_SEND_DELAY_MAX_US)) {
+        // We missed the send window
+        begin_read_uplink();
+        return true;
+    }
+
+    // Only fetched when it is sent, so a missed window doesn't use up a scheduled value
+    Telemetry event = rx.get_next_telemetry(m_uplink_id);
+
+    // Start sending uplink
+    fbus_uplink_t uplink;
+    uint8_t *uplink_ptr = (uint8_t*)&uplink;
+    static_assert(FBUS_UPLINK_SIZE == sizeof(fbus_uplink_t), "Uplink mismatch");
+    static_assert(Receiver::TX_BUFFER_SIZE >= sizeof(fbus_uplink_t));
+    uplink.size = FBUS_UPLINK_HDR;
+    uplink.id = m_uplink_id;
+    uplink.prim = FBUS_UPLINK_DATA_FRAME;
+    uplink.app_id = event.app_id;
+    uplink.data = event.data;
+    uplink.crc = fbus_checksum(uplink_ptr, FBUS_UPLINK_HDR_SIZE, uplink.size);
+
+    rx.send_uplink(uplink_ptr, sizeof(uplink));
+
+    begin_read_uplink();
+    return true;
+}
+
+
+bool FBus2Protocol::do_read_uplink(Receiver &rx)
+{
+    // Fill buffer
+    if (!rx.rx_window_recv(FBUS_UPLINK_HDR_SIZE)) return false;
+    auto frame = rx.m_rx_window.view();
+    if (frame[0]!=FBUS_UPLINK_HDR) {
+        // No uplink
+        begin_read_control();
+        return true;
+    }
+    if (!rx.rx_window_recv(FBUS_UPLINK_SIZE)) return false;
+
+    // Validate CRC
+    if (rx.rx_checksum(FBUS_UPLINK_HDR_SIZE, frame[0])!=fbus_uplink_crc(frame)) {
+        rx.m_stats.crc_failure(FrameType::UPLINK);
+        begin_sync(rx);
+        return true;
+    }
+
+    rx.rx_window_pop(FBUS_UPLINK_SIZE);
+
+    begin_read_control();
+    return true;
+}
+
+
+}
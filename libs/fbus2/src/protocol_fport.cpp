@@ -0,0 +1,244 @@
+/**
+ * @file protocol_fport.cpp
+ * @author Peter Christoffersen
+ * @brief
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Implementation of the FrSky FPort protocol.
+ *
+ */
+#include <fbus2/protocol_fport.h>
+
+#include <pico/stdlib.h>
+
+#include "fport.h"
+
+namespace FBus2 {
+
+
+static_assert(FPortProtocol::MAX_FRAME_SIZE==fport_frame_size(FPORT_MAX_LEN));
+
+
+void FPortProtocol::begin_sync(Receiver &rx)
+{
+    m_state = State::SYNCING;
+    m_synced = false;
+    rx.begin_sync();
+}
+
+
+bool FPortProtocol::step(Receiver &rx)
+{
+    switch (m_state) {
+        case State::SYNCING:
+            return do_sync(rx);
+        case State::READ_FRAME:
+            return do_read_frame(rx);
+        case State::WRITE_UPLINK:
+            return do_write_uplink(rx);
+        default:
+            assert(false);
+            vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+}
+
+
+/**
+ * @brief Find the next delimiter
+ *
+ * Stuffing keeps the delimiter out of the frames, so the next one is always
+ * the start (or end) of a frame. Sync is confirmed by the first valid frame.
+ */
+bool FPortProtocol::do_sync(Receiver &rx)
+{
+    rx.check_sync_timeout();
+
+    auto frame = rx.m_rx_window.view();
+    size_t size = rx.m_rx_window.size();
+    for (size_t pos=0; pos<size; ++pos) {
+        if (frame[pos]==FPORT_DELIMITER) {
+            rx.rx_window_pop(pos);
+            m_state = State::READ_FRAME;
+            return true;
+        }
+    }
+
+    rx.rx_window_pop(size);
+    return rx.rx_window_recv(fport_frame_size(FPORT_DOWNLINK_LEN)+2);
+}
+
+
+/**
+ * @brief Read the frame that starts at the delimiter at the head of the window
+ *
+ * LEN gives the stuffed size of the frame, plus one for each escape. The 
+ * escapes are counted as the data comes in, so it is one wakeup per frame
+ * unless a frame is stuffed. The closing delimiter is left in the window, as 
+ * it may also open the next frame.
+ */
+bool FPortProtocol::do_read_frame(Receiver &rx)
+{
+    if (!rx.rx_window_recv(2)) return false;
+    auto window = rx.m_rx_window.view();
+
+    if (window[0]!=FPORT_DELIMITER) {
+        begin_sync(rx);
+        return true;
+    }
+    if (window[1]==FPORT_DELIMITER) {
+        // The first delimiter closed the previous frame
+        rx.rx_window_pop(1);
+        return true;
+    }
+
+    const uint8_t len = window[1];
+    if (len==0 || len>FPORT_MAX_LEN) {
+        rx.m_stats.crc_failure(FrameType::CONTROL);
+        rx.rx_window_pop(1);
+        begin_sync(rx);
+        return true;
+    }
+
+    // Delimiter, LEN..CRC with escapes, delimiter
+    static_assert(Receiver::rx_window_type::capacity() >= MAX_STUFFED_SIZE, "Frames must fit the receive window, fully stuffed");
+    size_t needed = 1+fport_frame_size(len)+1;
+    size_t pos = 2;
+    while (pos<needed-1) {
+        if (needed>MAX_STUFFED_SIZE) {
+            // More escapes than a frame can have, it would never fit the window
+            rx.m_stats.crc_failure(FrameType::CONTROL);
+            rx.rx_window_pop(1);
+            begin_sync(rx);
+            return true;
+        }
+        if (!rx.rx_window_recv(needed)) return false;
+        for (const size_t end=needed-1; pos<end; ++pos) {
+            if (window[pos]==FPORT_ESCAPE) {
+                // The escaped byte is data, even if it is another escape
+                needed++;
+                pos++;
+            }
+            if (window[pos]==FPORT_DELIMITER) {
+                // Bytes were lost, this is the start of the next frame
+                rx.m_stats.crc_failure(FrameType::CONTROL);
+                rx.rx_window_pop(pos);
+                return true;
+            }
+        }
+    }
+
+    // An escape at the end of the window pushes the closing delimiter past it
+    if (!rx.rx_window_recv(needed)) return false;
+    if (window[needed-1]!=FPORT_DELIMITER) {
+        rx.m_stats.crc_failure(FrameType::CONTROL);
+        rx.rx_window_pop(1);
+        begin_sync(rx);
+        return true;
+    }
+
+    // Unstuff
+    m_frame_size = 0;
+    for (size_t i=1; i<needed-1 && m_frame_size<MAX_FRAME_SIZE; ++i) {
+        uint8_t byte = window[i];
+        if (byte==FPORT_ESCAPE) {
+            byte = window[++i] ^ FPORT_ESCAPE_XOR;
+        }
+        m_frame[m_frame_size++] = byte;
+    }
+    // The CRC, the last byte of the frame
+    absolute_time_t rx_time = rx.rx_time(needed-2);
+    rx.rx_window_pop(needed-1);
+
+    if (fbus_checksum(m_frame, FPORT_LEN_OFFSET, m_frame_size-1)!=fport_crc(m_frame)) {
+        switch (m_frame[FPORT_TYPE_OFFSET]) {
+            case FPORT_TYPE_CONTROL:  rx.m_stats.crc_failure(FrameType::CONTROL); break;
+            case FPORT_TYPE_DOWNLINK: rx.m_stats.crc_failure(FrameType::DOWNLINK); break;
+            default:                  rx.m_stats.crc_failure(FrameType::UPLINK); break;
+        }
+        return true;
+    }
+
+    if (!m_synced) {
+        m_synced = true;
+        rx.sync_found();
+    }
+    process_frame(rx, rx_time);
+    return true;
+}
+
+
+void FPortProtocol::process_frame(Receiver &rx, absolute_time_t rx_time)
+{
+    const uint8_t len = m_frame[FPORT_LEN_OFFSET];
+    switch (m_frame[FPORT_TYPE_OFFSET]) {
+        case FPORT_TYPE_CONTROL:
+            if (len==FPORT_CONTROL_LEN) {
+                auto &channels = rx.m_channels;
+                channels.set_flags(m_frame[FPORT_CONTROL_FLAGS_OFFSET] & FPORT_CONTROL_FLAGS_MASK);
+                channels.set_rssi(m_frame[FPORT_CONTROL_RSSI_OFFSET]);
+                channels.set_count(FPORT_CONTROL_CHANNEL_COUNT);
+                fbus_unpack_channels<ChannelValue::raw_type, FPORT_CONTROL_CHANNEL_COUNT>(m_frame, FPORT_PAYLOAD_OFFSET, channels);
+
+                rx.publish_channels(rx_time);
+            }
+            break;
+        case FPORT_TYPE_DOWNLINK:
+            if (len==FPORT_DOWNLINK_LEN && (m_frame[FPORT_PRIM_OFFSET]==FPORT_PRIM_NULL || m_frame[FPORT_PRIM_OFFSET]==FPORT_PRIM_DATA)) {
+                m_state = State::WRITE_UPLINK;
+            }
+            break;
+        default:
+            // Uplinks, ours or from the flight controller
+            break;
+    }
+}
+
+
+bool FPortProtocol::do_write_uplink(Receiver &rx)
+{
+    m_state = State::READ_FRAME;
+
+    if (!rx.uplink_in_time(FPORT_UPLINK_SEND_DELAY_MAX_US)) {
+        return true;
+    }
+
+    // Only fetched when it is sent, so a missed window doesn't use up a scheduled value
+    Telemetry event = rx.get_next_telemetry(rx.sensor_id(0));
+
+    const uint8_t frame[] { 
+        FPORT_UPLINK_LEN, 
+        FPORT_TYPE_UPLINK, 
+        FPORT_PRIM_DATA,
+        static_cast<uint8_t>(event.app_id & 0xFF),
+        static_cast<uint8_t>(event.app_id >> 8),
+        static_cast<uint8_t>(event.data & 0xFF),
+        static_cast<uint8_t>((event.data >> 8) & 0xFF),
+        static_cast<uint8_t>((event.data >> 16) & 0xFF),
+        static_cast<uint8_t>(event.data >> 24),
+        0x00
+    };
+    static_assert(sizeof(frame)==fport_frame_size(FPORT_UPLINK_LEN));
+    static_assert(Receiver::TX_BUFFER_SIZE >= 2*sizeof(frame), "Uplink must fit the tx buffer, fully stuffed");
+
+    uint8_t crc = fbus_checksum(frame, FPORT_LEN_OFFSET, sizeof(frame)-1);
+    uint8_t uplink[2*sizeof(frame)];
+    size_t size = 0;
+    for (size_t i=0; i<sizeof(frame); ++i) {
+        uint8_t byte = i==sizeof(frame)-1 ? crc : frame[i];
+        if (fport_needs_escape(byte)) {
+            uplink[size++] = FPORT_ESCAPE;
+            byte ^= FPORT_ESCAPE_XOR;
+        }
+        uplink[size++] = byte;
+    }
+
+    rx.send_uplink(uplink, size);
+    return true;
+}
+
+
+}
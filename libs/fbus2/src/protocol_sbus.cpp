@@ -0,0 +1,110 @@
+/**
+ * @file protocol_sbus.cpp
+ * @author Peter Christoffersen
+ * @brief
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Implementation of the SBUS protocol.
+ *
+ */
+#include <fbus2/protocol_sbus.h>
+
+#include <pico/stdlib.h>
+
+#include "sbus.h"
+
+namespace FBus2 {
+
+
+static_assert(SBUS_FLAGS_MASK==(Flags::CH17_MASK|Flags::CH18_MASK|Flags::FRAME_LOST_MASK|Flags::FAILSAFE_MASK), "Expected SBUS flags to match FBus2 flags");
+
+
+void SBusProtocol::begin_sync(Receiver &rx)
+{
+    m_state = State::SYNCING;
+    rx.begin_sync();
+}
+
+
+bool SBusProtocol::step(Receiver &rx)
+{
+    switch (m_state) {
+        case State::SYNCING:
+            return do_sync(rx);
+        case State::READ_FRAME:
+            return do_read_frame(rx);
+        default:
+            assert(false);
+            vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+}
+
+
+/**
+ * @brief Find the next frame, to get back in sync
+ *
+ * Without a checksum, a header and footer in the right places could just as
+ * well be channel data, so a candidate is only taken when the header of the
+ * following frame is where it should be too. Like FBus2, the window is
+ * scanned in one pass, and the task waits for just enough data to decide.
+ */
+bool SBusProtocol::do_sync(Receiver &rx)
+{
+    rx.check_sync_timeout();
+
+    auto frame = rx.m_rx_window.view();
+    size_t size = rx.m_rx_window.size();
+    size_t pos = 0;
+    constexpr size_t needed = SBUS_FRAME_SIZE+1;
+    for (; pos<size; ++pos) {
+        if (frame[pos]!=SBUS_HDR) {
+            continue;
+        }
+        if (pos+needed>size) {
+            break;
+        }
+        if (sbus_footer_valid(frame[pos+SBUS_FOOTER_OFFSET]) && frame[pos+SBUS_FRAME_SIZE]==SBUS_HDR) {
+            rx.rx_window_pop(pos);
+            rx.sync_found();
+            m_state = State::READ_FRAME;
+            return true;
+        }
+    }
+
+    rx.rx_window_pop(pos);
+    return rx.rx_window_recv(needed);
+}
+
+
+bool SBusProtocol::do_read_frame(Receiver &rx)
+{
+    static_assert(Receiver::rx_window_type::capacity() > SBUS_FRAME_SIZE, "Sync needs a frame and the next header in the window");
+
+    if (!rx.rx_window_recv(SBUS_FRAME_SIZE)) return false;
+    auto frame = rx.m_rx_window.view();
+
+    if (!sbus_frame_valid(frame)) {
+        // A bad header or footer is all the error checking there is
+        rx.m_stats.crc_failure(FrameType::CONTROL);
+        begin_sync(rx);
+        return true;
+    }
+
+    auto &channels = rx.m_channels;
+    channels.set_flags(sbus_flags(frame));
+    channels.set_rssi(0);
+    channels.set_count(SBUS_CHANNEL_COUNT);
+    fbus_unpack_channels<ChannelValue::raw_type, SBUS_CHANNEL_COUNT>(frame, SBUS_CHANNELS_OFFSET, channels);
+
+    rx.publish_channels(rx.rx_time(SBUS_FRAME_SIZE-1));
+
+    rx.rx_window_pop(SBUS_FRAME_SIZE);
+    return true;
+}
+
+
+}
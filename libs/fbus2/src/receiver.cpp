@@ -7,15 +7,15 @@
  * 
  * @copyright Copyright (c) 2022
  * 
- * Implementation of the FrSky FBus2 protocol. 
+ * The receiver pipeline, from the rx ISR to the lower task. The protocols
+ * are implemented in protocol_*.cpp.
  * 
  */
 #include <fbus2/receiver.h>
 
+#include <inttypes.h>
 #include <pico/stdlib.h>
 
-#include "protocol.h"
-
 #ifndef NDEBUG
 #define debugf(X...) { printf(X); }
 #else
@@ -26,46 +26,40 @@
 namespace FBus2 {
 
 
-Receiver *Receiver::m_instance = nullptr;
-
-
-
-
-Receiver::Receiver(uint baudrate, UBaseType_t task_priority, UBaseType_t lower_task_priority) :
-    m_baudrate { baudrate },
+Receiver::Receiver(const LineConfig &line, UBaseType_t task_priority, UBaseType_t lower_task_priority) :
+    m_line { line },
+    m_baudrate { line.baudrate },
     m_task_priority { task_priority },
     m_lower_task_priority { lower_task_priority },
     m_task { nullptr }, 
-    m_rx_scratch_size { 0 },
+    m_task_lower { nullptr }, 
     m_rx_buffer { nullptr },
-    m_tx_buffer { nullptr },
-    m_state { State::SYNCING },
-    m_control_packets { 0 }
+    m_rx_timeout { portMAX_DELAY },
+    m_control_packets { 0 },
+    m_telemetry_sent { 0 },
+    m_telemetry_skipped { 0 },
+    m_failsafes { 0 },
+    m_sensor_ids { RECEIVER_ID },
+    m_sensor_id_count { 1 },
+    m_uplink_latency_us { 0 },
+    m_uplink_latency_max_us { 0 },
+    m_recorder { nullptr },
+    m_freeze_recorder { false },
+    m_shaper { nullptr },
+    m_failsafe_us { FAILSAFE_TIMEOUT }
 {
-    static_assert(RX_SCRATCH_SIZE >= sizeof(fbus_control_24_t));
-    static_assert(TX_BUFFER_SIZE >= sizeof(fbus_uplink_t));
-
-    assert(m_instance==nullptr);
-    m_instance = this;
-    m_mutex = xSemaphoreCreateBinaryStatic(&m_mutex_buf);
-    assert(m_mutex);
-    xSemaphoreGive(m_mutex);
+    static_assert(RX_SUMS_SIZE > RX_BUFFER_SIZE+RX_WINDOW_SIZE, "Checksum tracker must cover all buffered data");
 }
 
 
-void Receiver::init()
+Receiver::~Receiver()
 {
-    assert(m_instance==this);
-
-    m_rx_scratch_size = 0;
-    m_rx_buffer = xStreamBufferCreateStatic(RX_BUFFER_SIZE, 1, m_rx_buffer_data, &m_rx_buffer_buf);
-    assert(m_rx_buffer);
-    m_tx_buffer = xStreamBufferCreateStatic(TX_BUFFER_SIZE, 1, m_tx_buffer_data, &m_tx_buffer_buf);
-    assert(m_tx_buffer);
+}
 
-    hardware_init();
 
-    begin_sync();
+void Receiver::init()
+{
+    init_receiver();
 
     m_task = xTaskCreateStatic([](auto args){ reinterpret_cast<Receiver*>(args)->run(); }, "RC", TASK_STACK_SIZE, this, m_task_priority, m_task_stack, &m_task_buf);
     #if FREE_RTOS_KERNEL_SMP && configNUM_CORES > 1
@@ -80,32 +74,72 @@ void Receiver::init()
 }
 
 
-void Receiver::start()
+/**
+ * @brief Setup buffers, hardware and state, everything but the tasks
+ */
+void Receiver::init_receiver()
 {
-    vTaskResume(m_task);
-    vTaskResume(m_task_lower);
-}
+    m_rx_window.clear();
+    m_rx_sums.reset();
+    m_rx_times.reset();
+    m_rx_pos = 0;
+    m_rx_buffer = xStreamBufferCreateStatic(RX_BUFFER_SIZE, 1, m_rx_buffer_data, &m_rx_buffer_buf);
+    assert(m_rx_buffer);
 
+    hardware_init();
 
+    protocol_init();
+}
 
-void Receiver::rx_scratch_recv(size_t bytes)
+
+void Receiver::start()
 {
-    while (m_rx_scratch_size<bytes) {
-        size_t rsz = bytes-m_rx_scratch_size;
-        xStreamBufferSetTriggerLevel(m_rx_buffer, rsz);
-        auto res = xStreamBufferReceive(m_rx_buffer, m_rx_scratch+m_rx_scratch_size, rsz, portMAX_DELAY);
-        m_rx_scratch_size+=res;
-    }
+    vTaskResume(m_task);
+    vTaskResume(m_task_lower);
 }
 
 
-void Receiver::rx_scratch_pop(size_t bytes)
+
+/**
+ * @brief Make sure the receive window holds at least bytes
+ * 
+ * Data is received straight into the free space of the window, and frames are 
+ * parsed in place, so consuming data is just a matter of moving the head.
+ * Whatever is available in the stream buffer (up to the contiguous free space) 
+ * is taken in each call, so bytes for the following frames are usually 
+ * already in the window when we get to them.
+ * 
+ * The trigger level is set to what is missing, so the task is only woken once
+ * there is enough data to make progress. When polled (m_rx_timeout 0, on the
+ * host), nothing is taken before the trigger level is reached either, so the
+ * number of receives matches the wakeups on the target.
+ * 
+ * @return false if the stream buffer ran dry before m_rx_timeout (never with
+ *         the default portMAX_DELAY)
+ */
+bool Receiver::rx_window_recv(size_t bytes)
 {
-    assert(m_rx_scratch_size>=bytes);
-    for (size_t i=bytes; i<m_rx_scratch_size; ++i) {
-        m_rx_scratch[i-bytes] = m_rx_scratch[i];
+    assert(bytes<=rx_window_type::capacity());
+    while (m_rx_window.size()<bytes) {
+        uint8_t *ptr;
+        size_t span = m_rx_window.write_span(ptr);
+        size_t trigger = std::min(bytes-m_rx_window.size(), span);
+        xStreamBufferSetTriggerLevel(m_rx_buffer, trigger);
+        if (m_rx_timeout==0 && xStreamBufferBytesAvailable(m_rx_buffer)<trigger) {
+            // Polled (host), the task would still be blocked
+            return false;
+        }
+        auto res = xStreamBufferReceive(m_rx_buffer, ptr, span, m_rx_timeout);
+        if (res==0) {
+            return false;
+        }
+        m_stats.rx_wakeup();
+        if (ReceiverStats::ENABLED) {
+            m_stats.rx_pending(res+xStreamBufferBytesAvailable(m_rx_buffer));
+        }
+        m_rx_window.commit(res);
     }
-    m_rx_scratch_size-=bytes;
+    return true;
 }
 
 
@@ -114,340 +148,229 @@ void Receiver::rx_scratch_pop(size_t bytes)
 
 
 
-void Receiver::lost_sync()
+/**
+ * @brief Time the ISR received the last byte
+ */
+absolute_time_t Receiver::last_rx_time() const
 {
-    debugf("Lost sync for too long\n");
-
-    xSemaphoreTake(m_mutex, portMAX_DELAY);
-    m_channels.set_flags(Flags::INITIAL_VALUE);
-    m_channels.set_rssi(0);
-    m_channels.set_sync(false);
-    xSemaphoreGive(m_mutex);
-    xTaskNotifyGive(m_task_lower);
+    taskENTER_CRITICAL();
+    absolute_time_t last_rx = m_last_rx_time;
+    taskEXIT_CRITICAL();
+    return last_rx;
 }
 
 
-
-
 void Receiver::begin_sync()
 {
-    debugf("Begin SYNC!!   %u\n", m_rx_scratch_size);
-    m_state = State::SYNCING;
-    m_sync_begin_time = get_absolute_time();
+    debugf("Begin SYNC!!   %zu\n", m_rx_window.size());
+    m_sync_begin_time = now();
+    m_stats.sync_begin(m_sync_begin_time);
 }
 
 
-void Receiver::begin_read_control()
+/**
+ * @brief Called while syncing, reports frame lost once sync has been lost for SYNC_TIMEOUT
+ */
+void Receiver::check_sync_timeout()
 {
-    //printf("Begin CTRL   %u\n", m_rx_scratch_size);
-    m_state = State::READ_CONTROL;
+    if (!m_channels.flags().frameLost() && absolute_time_diff_us(m_sync_begin_time, now())>SYNC_TIMEOUT) {
+        lost_sync();
+    }
 }
 
 
-void Receiver::begin_read_downlink()
+void Receiver::lost_sync()
 {
-    //printf("Begin DOWN   %u\n", m_rx_scratch_size);
-    m_state = State::READ_DOWNLINK;
-}
+    debugf("Lost sync for too long\n");
 
+    mark_lost(m_channels);
+    m_channels_published.store(m_channels);
+    notify_lower();
 
-void Receiver::begin_write_uplink()
-{
-    //printf("Begin WUPL\n");
-    m_state = State::WRITE_UPLINK;
+    if (m_recorder && m_freeze_recorder) {
+        m_recorder->freeze();
+    }
 }
 
 
-void Receiver::begin_read_uplink()
+void Receiver::mark_lost(channels_type &channels)
 {
-    //printf("Begin RUPL\n");
-    m_state = State::READ_UPLINK;
+    channels.set_flags(Flags::INITIAL_VALUE);
+    channels.set_rssi(0);
+    channels.set_sync(false);
 }
 
 
+/**
+ * @brief Publish m_channels, once the protocol has filled in a valid frame
+ * 
+ * @param rx_time Time the ISR received the last byte of the frame
+ */
+void Receiver::publish_channels(absolute_time_t rx_time)
+{
+    m_channels.set_sync(true);
+    m_channels.set_seq(m_control_packets);
+    m_channels.set_time(rx_time);
 
+    m_control_packets++;
 
-
-void Receiver::do_sync()
-{
-    if (!m_channels.flags().frameLost() && absolute_time_diff_us(m_sync_begin_time, get_absolute_time())>SYNC_TIMEOUT) {
-        // We lost sync too long, set frame lost
-        lost_sync();
+    if (ReceiverStats::ENABLED) {
+        m_stats.control_frame(rx_time, now());
     }
 
-    // We need at least 2 bytes
-    rx_scratch_recv(2);
+    // Readers never block the parser, they get the previous frame until this one is published
+    m_channels_published.store(m_channels);
 
-    // Look for header byte
-    if (m_rx_scratch[1]!=FBUS_CONTROL_HDR) {
-        rx_scratch_pop(1);
-        return;
-    }
-    //printf("Got control hdr %02x %02x\n", g_receiver_buffer[0], g_receiver_buffer[1]);
+    notify_lower();
+}
 
-    // Check size 
-    if (m_rx_scratch[0]!=FBUS_CONTROL_8CH_SIZE && m_rx_scratch[0]!=FBUS_CONTROL_16CH_SIZE && m_rx_scratch[0]!=FBUS_CONTROL_24CH_SIZE) {
-        // Incorrect size - drop the first two bytes 
-        rx_scratch_pop(2);
-        return;
-    }
 
-    // Check if we have a full control package
-    rx_scratch_recv(fbus_control_size(m_rx_scratch));
+static_assert(Receiver::physical_id(7)==Receiver::RECEIVER_ID, "Physical id check bits");
 
-    // Check CRC
-    if (fbus_checksum(m_rx_scratch, FBUS_CONTROL_HDR_SIZE, m_rx_scratch[0])!=fbus_control_crc(m_rx_scratch)) {
-        rx_scratch_pop(2);
-        return;
-    }
-    // Control package OK
 
-    // Everything checks out - we are in sync
-    begin_read_control();
+void Receiver::set_sensor_ids(const uint8_t *ids, size_t count)
+{
+    assert(count>0 && count<=MAX_SENSOR_IDS);
+    m_sensor_id_count = std::min(count, MAX_SENSOR_IDS);
+    std::copy(ids, ids+m_sensor_id_count, m_sensor_ids.begin());
 }
 
 
-
-void Receiver::do_read_control()
+bool Receiver::answers(uint8_t id) const
 {
-    rx_scratch_recv(FBUS_CONTROL_HDR_SIZE);
-
-    if (m_rx_scratch[1]!=FBUS_CONTROL_HDR) {
-        // Lost sync
-        begin_sync();
-        return;
+    for (size_t i=0; i<m_sensor_id_count; ++i) {
+        if (m_sensor_ids[i]==id) return true;
     }
+    return false;
+}
 
-    if (m_rx_scratch[1]!=FBUS_CONTROL_HDR || (m_rx_scratch[0]!=FBUS_CONTROL_8CH_SIZE && m_rx_scratch[0]!=FBUS_CONTROL_16CH_SIZE && m_rx_scratch[0]!=FBUS_CONTROL_24CH_SIZE)) {
-        // Lost sync
-        begin_sync();
-        return;
-    }
 
-    rx_scratch_recv(fbus_control_size(m_rx_scratch));
+/**
+ * @brief Check that an uplink can still make it into the send window
+ * 
+ * Measures the time from the last received byte. Get the telemetry after
+ * this, so a missed window doesn't use up a scheduled value; the provider
+ * must be quick, as its time comes on top.
+ * 
+ * @return false if the window has been missed, the uplink is counted as skipped
+ */
+bool Receiver::uplink_in_time(int64_t max_delay_us)
+{
+    int64_t diff = absolute_time_diff_us(last_rx_time(), now());
+    m_uplink_latency_us = diff;
+    m_uplink_latency_max_us = std::max(m_uplink_latency_max_us, diff);
+    m_stats.uplink_latency(diff);
 
-    // Validate CRC
-    if (fbus_checksum(m_rx_scratch, FBUS_CONTROL_HDR_SIZE, m_rx_scratch[0])!=fbus_control_crc(m_rx_scratch)) {
-        begin_sync();
-        return;
+    if (diff > max_delay_us) {
+        m_telemetry_skipped++;
+        return false;
     }
+    return true;
+}
 
-    // Process package
-    xSemaphoreTake(m_mutex, portMAX_DELAY);
-
-    static_assert(FBUS_CONTROL_8CH_SIZE+FBUS_CONTROL_HDR_SIZE+sizeof(fbus_control_8_t::crc)==sizeof(fbus_control_8_t), "Expected control size to match struct");
-    static_assert(FBUS_CONTROL_16CH_SIZE+FBUS_CONTROL_HDR_SIZE+sizeof(fbus_control_16_t::crc)==sizeof(fbus_control_16_t), "Expected control size to match struct");
-    static_assert(FBUS_CONTROL_24CH_SIZE+FBUS_CONTROL_HDR_SIZE+sizeof(fbus_control_24_t::crc)==sizeof(fbus_control_24_t), "Expected control size to match struct");
 
+void Receiver::run()
+{
+    task_init();
 
-    m_channels.set_sync(true);
-    m_channels.set_seq(m_control_packets);
+    // Allow task to run on all cores after we have setup interrupt handler
+    #if FREE_RTOS_KERNEL_SMP && configNUM_CORES > 1
+    vTaskCoreAffinitySet(nullptr, 0b11);
+    #endif
 
-    switch (m_rx_scratch[0]) {
-        case FBUS_CONTROL_8CH_SIZE:
-            {
-                fbus_control_8_t control;
-                memcpy(&control, m_rx_scratch, sizeof(control));
-                rx_scratch_pop(sizeof(control));
-
-                m_channels.set_flags(control.flags);
-                m_channels.set_rssi(control.rssi);
-                m_channels.set_count(8);
-                fbus_get_8channel<ChannelValue::raw_type>(control.channels, 0u, m_channels, 0u);
-            }
-            break;
-        case FBUS_CONTROL_16CH_SIZE:
-            {
-                fbus_control_16_t control;
-                memcpy(&control, m_rx_scratch, sizeof(control));
-                rx_scratch_pop(sizeof(control));
-
-                m_channels.set_flags(control.flags);
-                m_channels.set_rssi(control.rssi);
-                m_channels.set_count(16);
-                fbus_get_8channel<ChannelValue::raw_type>(control.channels, 0u, m_channels, 0u);
-                fbus_get_8channel<ChannelValue::raw_type>(control.channels, FBUS_CONTROL_8_VALUE_SIZE, m_channels, 8u);
-            }
-            break;
-        case FBUS_CONTROL_24CH_SIZE:
-            {
-                fbus_control_16_t control;
-                memcpy(&control, m_rx_scratch, sizeof(control));
-                rx_scratch_pop(sizeof(control));
-
-                m_channels.set_flags(control.flags);
-                m_channels.set_rssi(control.rssi);
-                m_channels.set_count(24);
-                fbus_get_8channel<ChannelValue::raw_type>(control.channels, 0u, m_channels, 0u);
-                fbus_get_8channel<ChannelValue::raw_type>(control.channels, FBUS_CONTROL_8_VALUE_SIZE, m_channels, 8u);
-                fbus_get_8channel<ChannelValue::raw_type>(control.channels, FBUS_CONTROL_8_VALUE_SIZE*2, m_channels, 16u);
-            }
-            break;
-        default:
-            // We should never get here, but drop package, and begin resync just in case
-            xSemaphoreGive(m_mutex);
-            rx_scratch_pop(fbus_control_size(m_rx_scratch));
-            begin_sync();
-            return;
+    while (true) {
+        step();
     }
-
-    m_control_packets++;
-
-    xSemaphoreGive(m_mutex);
-
-    xTaskNotifyGive(m_task_lower);
-
-    begin_read_downlink();
 }
 
 
-void Receiver::do_read_downlink()
+void Receiver::run_lower()
 {
-    // Fill buffer
-    rx_scratch_recv(FBUS_DOWNLINK_SIZE);
-    if (m_rx_scratch[0]!=FBUS_DOWNLINK_HDR) {
-        begin_sync();
-        return;
-    }
+    channels_type channels;
 
-    // Validate CRC
-    if (fbus_checksum(m_rx_scratch, FBUS_DOWNLINK_HDR_SIZE, m_rx_scratch[0])!=fbus_downlink_crc(m_rx_scratch)) {
-        begin_sync();
-        return;
-    }
+    while (true) {
+        // Woken by the next frame, or at the failsafe deadline of the last one
+        if (ulTaskNotifyTake(pdTRUE, failsafe_wait(channels))==0) {
+            check_failsafe(channels);
+            continue;
+        }
 
-    // Process package
-    static_assert(FBUS_DOWNLINK_SIZE==sizeof(fbus_downlink_t), "Expected downlink size to match struct");
-    fbus_downlink_t downlink;
-    memcpy(&downlink, m_rx_scratch, FBUS_DOWNLINK_SIZE);
-    rx_scratch_pop(FBUS_DOWNLINK_SIZE);
+        channels = m_channels_published.load();
 
-    // Check if we need to respond to downlink
-    if (downlink.id == RECEIVER_ID) {
-        begin_write_uplink();
-        return;
+        deliver(channels);
     }
-
-    begin_read_uplink();
 }
 
 
-void Receiver::do_write_uplink()
+/**
+ * @brief Shape the channels, and pass them on with what changed
+ */
+void Receiver::deliver(channels_type &channels)
 {
-    //m_rx_buffer.enter_blocking();
-    taskENTER_CRITICAL();
-    absolute_time_t last_rx = m_last_rx_time;
-    taskEXIT_CRITICAL();
-
-    absolute_time_t now = get_absolute_time();
-    int64_t diff = absolute_time_diff_us(last_rx, now);
-
-    if (diff > FBUS_UPLINK_SEND_DELAY_MAX_US) {
-        // We missed the send window
-        m_telemetry_skipped++;
-        begin_read_uplink();
-        return;
+    if (m_shaper) {
+        m_shaper->shape(channels);
     }
-
-    Telemetry event = get_next_telemetry();
-
-    // Start sending uplink    
-    fbus_uplink_t uplink;
-    uint8_t *uplink_ptr = (uint8_t*)&uplink;
-    static_assert(FBUS_UPLINK_SIZE == sizeof(fbus_uplink_t), "Uplink mismatch");
-    uplink.size = FBUS_UPLINK_HDR;
-    uplink.id = RECEIVER_ID;
-    uplink.prim = FBUS_UPLINK_DATA_FRAME;
-    uplink.app_id = event.app_id;
-    uplink.data = event.data;
-    uplink.crc = fbus_checksum(uplink_ptr, FBUS_UPLINK_HDR_SIZE, uplink.size);
-
-    //printf("Uplink: - %02x   %08x   - %lld\n", uplink.app_id, uplink.data, diff);
-    tx_send(uplink_ptr, sizeof(uplink));
-
-    m_telemetry_sent++;
-
-    begin_read_uplink();
+    on_data(channels, m_changes.update(channels));
 }
 
 
-void Receiver::do_read_uplink()
+/**
+ * @brief Time left before the failsafe is due for channels
+ * 
+ * @return 0 when it is due, -1 when the link is already down
+ */
+int64_t Receiver::failsafe_remaining_us(const channels_type &channels) const
 {
-    // Fill buffer
-    rx_scratch_recv(FBUS_UPLINK_HDR_SIZE);
-    if (m_rx_scratch[0]!=FBUS_UPLINK_HDR) {
-        // No uplink
-        begin_read_control();
-        return;
+    if (!channels.sync() || channels.flags().frameLost()) {
+        return -1;
     }
-    rx_scratch_recv(FBUS_UPLINK_SIZE);
-
-    // Validate CRC
-    if (fbus_checksum(m_rx_scratch, FBUS_UPLINK_HDR_SIZE, m_rx_scratch[0])!=fbus_uplink_crc(m_rx_scratch)) {
-        begin_sync();
-        return;
-    }
-
-    rx_scratch_pop(FBUS_UPLINK_SIZE);
-
-    begin_read_control();
+    return std::max(m_failsafe_us-absolute_time_diff_us(channels.time(), now()), int64_t { 0 });
 }
 
 
-void Receiver::run()
+/**
+ * @brief Ticks for the lower task to wait for the next frame, after channels
+ * 
+ * Rounded up, so the failsafe is never checked early, and fires at most a
+ * tick late.
+ */
+TickType_t Receiver::failsafe_wait(const channels_type &channels) const
 {
-    task_init();
-
-    // Allow task to run on all cores after we have setup interrupt handler
-    #if FREE_RTOS_KERNEL_SMP && configNUM_CORES > 1
-    vTaskCoreAffinitySet(nullptr, 0b11);
-    #endif
-
-    while (true) {
-        switch (m_state) {
-            case State::SYNCING:
-                do_sync();
-                break;
-            case State::READ_CONTROL:
-                do_read_control();
-                break;
-            case State::READ_DOWNLINK:
-                do_read_downlink();
-                break;
-            case State::WRITE_UPLINK:
-                do_write_uplink();
-                break;
-            case State::READ_UPLINK:
-                do_read_uplink();
-                break;
-            default:
-                assert(false);
-                vTaskDelay(pdMS_TO_TICKS(10));
-        }    
+    int64_t remaining = failsafe_remaining_us(channels);
+    if (remaining<0) {
+        return portMAX_DELAY;
     }
+    return std::max(static_cast<TickType_t>((remaining*configTICK_RATE_HZ+999999)/1000000), TickType_t { 1 });
 }
 
 
-void Receiver::run_lower()
+/**
+ * @brief Pass a frame lost on to on_data(), once the last frame is older than the failsafe timeout
+ * 
+ * From the lower task, so it leaves m_channels to the receiver task, which 
+ * reports the loss itself once bytes come in again.
+ * 
+ * @param channels Last delivered, marked lost if the failsafe was delivered
+ * @return true if the failsafe was delivered
+ */
+bool Receiver::check_failsafe(channels_type &channels)
 {
-    channels_type channels;
-
-    while (true) {
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-
-        xSemaphoreTake(m_mutex, portMAX_DELAY);
-        channels = m_channels;
-        xSemaphoreGive(m_mutex);
-
-        on_data(channels);
+    // A frame may have been published since the wait timed out, it is delivered next
+    if (failsafe_remaining_us(channels)!=0 || failsafe_remaining_us(m_channels_published.load())!=0) {
+        return false;
     }
+    mark_lost(channels);
+    m_failsafes++;
+    deliver(channels);
+    return true;
 }
 
 
 #ifndef NDEBUG
 void Receiver::print_stats()
 {
-    printf("Receiver: control: %d   telemetry: sent=%d  skipped=%d\n", m_control_packets, m_telemetry_sent, m_telemetry_skipped);
+    printf("Receiver: control: %d   telemetry: sent=%d  skipped=%d  latency=%" PRId64 "us (max %" PRId64 "us)  failsafes: %d\n", m_control_packets, m_telemetry_sent, m_telemetry_skipped, m_uplink_latency_us, m_uplink_latency_max_us, m_failsafes);
+    m_stats.print();
 }
 #endif
 
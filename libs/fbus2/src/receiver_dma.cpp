@@ -0,0 +1,311 @@
+/**
+ * @file receiver_dma.cpp
+ * @author Peter Christoffersen
+ * @brief
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * DMA data path shared by the hardware receivers.
+ *
+ */
+#include <fbus2/receiver_dma.h>
+
+#include <algorithm>
+#include <string.h>
+#include <pico/stdlib.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/clocks.h>
+
+
+namespace FBus2 {
+
+
+ReceiverDMA *ReceiverDMA::m_dma_instances[MAX_DMA_RECEIVERS] = {};
+bool ReceiverDMA::m_dma_irq_installed[DMA_IRQ_COUNT] = {};
+
+
+ReceiverDMA::ReceiverDMA(const LineConfig &line, UBaseType_t task_priority, UBaseType_t lower_task_priority, RxMode rx_mode) :
+    Receiver { line, task_priority, lower_task_priority },
+    m_rx_mode { rx_mode },
+    m_isr_calls { 0 },
+    m_isr_pushes { 0 },
+    m_isr_bytes { 0 },
+    m_isr_cycles { 0 },
+    m_dma_rx { -1, -1 },
+    m_dma_active { 0 },
+    m_dma_read { 0 },
+    m_dma_irq_index { 0 },
+    m_dma_idle_us { 0 },
+    m_dma_idle_alarm { 0 },
+    m_dma_tx { -1 }
+{
+
+}
+
+
+ReceiverDMA::~ReceiverDMA()
+{
+    for (auto &instance : m_dma_instances) {
+        if (instance==this) {
+            instance = nullptr;
+        }
+    }
+}
+
+
+void ReceiverDMA::isr_stats_begin()
+{
+    m_isr_calls = 0;
+    m_isr_pushes = 0;
+    m_isr_bytes = 0;
+    m_isr_cycles = 0;
+    m_isr_stats_begin = get_absolute_time();
+}
+
+
+/**
+ * @brief Setup DMA reception from a byte wide FIFO register
+ *
+ * Two chained channels take turns filling DMA_CHUNK_SIZE chunks of the ring,
+ * and each completed chunk is handed over to the receiver task from the DMA
+ * interrupt. After each chunk an idle alarm is armed, that hands over whatever
+ * arrived after the last complete chunk, so the tail of a frame is passed on
+ * once the line has been quiet for DMA_IDLE_TIMEOUT_CHARS.
+ */
+void ReceiverDMA::init_dma_rx(const volatile void *src, uint dreq)
+{
+    m_dma_read = 0;
+    m_dma_active = 0;
+    m_dma_idle_alarm = 0;
+    m_dma_idle_us = DMA_IDLE_TIMEOUT_CHARS*m_line.bits_per_char()*1000000ll/m_baudrate + 1;
+
+    for (auto &dma : m_dma_rx) {
+        dma = dma_claim_unused_channel(true);
+    }
+
+    for (uint i=0; i<2; ++i) {
+        dma_channel_config config = dma_channel_get_default_config(m_dma_rx[i]);
+        channel_config_set_dreq(&config, dreq);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_ring(&config, true, DMA_RING_BITS);
+        channel_config_set_chain_to(&config, m_dma_rx[i^1]);
+
+        dma_channel_configure(m_dma_rx[i],
+                              &config,
+                              &m_dma_ring[i*DMA_CHUNK_SIZE],
+                              src,
+                              DMA_CHUNK_SIZE,
+                              false);
+    }
+
+    auto slot = std::find(std::begin(m_dma_instances), std::end(m_dma_instances), nullptr);
+    assert(slot!=std::end(m_dma_instances));
+    *slot = this;
+
+    m_dma_irq_index = get_core_num();
+    uint dma_irq = m_dma_irq_index==0 ? DMA_IRQ_0 : DMA_IRQ_1;
+    if (!m_dma_irq_installed[m_dma_irq_index]) {
+        irq_add_shared_handler(dma_irq, m_dma_irq_index==0 ? &dma_irq_dispatch<0> : &dma_irq_dispatch<1>, DMA_IRQ_PRIORITY);
+        m_dma_irq_installed[m_dma_irq_index] = true;
+    }
+    irq_set_enabled(dma_irq, true);
+    for (auto dma : m_dma_rx) {
+        dma_irqn_set_channel_enabled(m_dma_irq_index, dma, true);
+    }
+
+    dma_channel_start(m_dma_rx[0]);
+}
+
+
+/**
+ * @brief Setup DMA transmission to a byte wide FIFO register
+ */
+void ReceiverDMA::init_dma_tx(volatile void *dst, uint dreq)
+{
+    m_dma_tx = dma_claim_unused_channel(true);
+
+    dma_channel_config config = dma_channel_get_default_config(m_dma_tx);
+    channel_config_set_dreq(&config, dreq);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+
+    dma_channel_configure(m_dma_tx,
+                          &config,
+                          dst,
+                          m_dma_tx_buf,
+                          0,
+                          false);
+}
+
+
+/**
+ * @brief Send data with DMA
+ *
+ * Returns once the data has been handed to DMA. An uplink frame fits in one
+ * transfer, so it is clocked out by the hardware without waiting.
+ */
+void ReceiverDMA::dma_tx_send(const uint8_t *buf, size_t sz)
+{
+    while (sz) {
+        dma_channel_wait_for_finish_blocking(m_dma_tx);
+
+        size_t len = std::min(sz, DMA_TX_SIZE);
+        memcpy(m_dma_tx_buf, buf, len);
+        dma_channel_transfer_from_buffer_now(m_dma_tx, m_dma_tx_buf, len);
+        buf += len;
+        sz -= len;
+    }
+}
+
+
+/**
+ * @brief Position in the ring the DMA will write next
+ */
+inline size_t ReceiverDMA::dma_write_pos() const
+{
+    return (dma_channel_hw_addr(m_dma_rx[m_dma_active])->write_addr - reinterpret_cast<uintptr_t>(m_dma_ring)) & DMA_RING_MASK;
+}
+
+
+/**
+ * @brief Hand everything received since last time over to the receiver task
+ *
+ * Called from both the DMA interrupt and the idle alarm, which may run on
+ * different cores, so it must be called inside a critical section.
+ *
+ * @param rx_time When the last byte was received, as near as the caller knows
+ */
+inline void ReceiverDMA::dma_rx_handover(absolute_time_t rx_time)
+{
+    size_t write = dma_write_pos();
+    size_t len = (write-m_dma_read) & DMA_RING_MASK;
+    if (len==0) {
+        return;
+    }
+
+    size_t first = std::min(len, DMA_RING_SIZE-m_dma_read);
+    size_t sent = rx_isr_push(&m_dma_ring[m_dma_read], first, rx_time);
+    if (sent) {
+        m_isr_pushes++;
+        m_isr_bytes += sent;
+    }
+    if (len>first) {
+        sent = rx_isr_push(m_dma_ring, len-first, rx_time);
+        if (sent) {
+            m_isr_pushes++;
+            m_isr_bytes += sent;
+        }
+    }
+
+    // Whatever did not fit in the rx buffer is dropped, like bytes left in the FIFO in IRQ mode
+    m_dma_read = write;
+    m_last_rx_time = rx_time;
+}
+
+
+/**
+ * @brief Interrupt handler for all the receivers on a DMA interrupt, each checks its own channels
+ */
+template<uint IRQ_INDEX>
+void ReceiverDMA::dma_irq_dispatch()
+{
+    for (auto receiver : m_dma_instances) {
+        if (receiver && receiver->m_dma_irq_index==IRQ_INDEX) {
+            receiver->dma_rx_handler();
+        }
+    }
+}
+
+
+inline void ReceiverDMA::dma_rx_handler()
+{
+    if (!dma_irqn_get_channel_status(m_dma_irq_index, m_dma_rx[0]) && !dma_irqn_get_channel_status(m_dma_irq_index, m_dma_rx[1])) {
+        // Another receiver's channel
+        return;
+    }
+
+    auto cycles = isr_cycles_begin();
+    auto saved = taskENTER_CRITICAL_FROM_ISR();
+
+    for (uint i=0; i<2; ++i) {
+        auto dma = m_dma_rx[i];
+        if (!dma_irqn_get_channel_status(m_dma_irq_index, dma)) {
+            continue;
+        }
+        dma_irqn_acknowledge_channel(m_dma_irq_index, dma);
+
+        // The other channel is running now, rearm this one for the chunk after it
+        size_t end = (dma_channel_hw_addr(dma)->write_addr - reinterpret_cast<uintptr_t>(m_dma_ring)) & DMA_RING_MASK;
+        dma_channel_set_write_addr(dma, &m_dma_ring[(end+DMA_CHUNK_SIZE) & DMA_RING_MASK], false);
+        dma_channel_set_trans_count(dma, DMA_CHUNK_SIZE, false);
+        m_dma_active = i^1;
+    }
+
+    // A chunk has just completed, so its last byte came in now
+    dma_rx_handover(get_absolute_time());
+
+    if (m_dma_idle_alarm==0) {
+        m_dma_idle_alarm = add_alarm_in_us(m_dma_idle_us, +[](alarm_id_t id, void *user_data) -> int64_t {
+            return static_cast<ReceiverDMA*>(user_data)->dma_idle_handler();
+        }, this, true);
+        if (m_dma_idle_alarm<0) {
+            // No alarm, the tail will be handed over with the next chunk
+            m_dma_idle_alarm = 0;
+        }
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    isr_cycles_end(cycles);
+}
+
+
+/**
+ * @brief Line idle check, hands over a partial chunk
+ *
+ * @return int64_t Time until the next check, 0 when the line has gone idle
+ */
+inline int64_t ReceiverDMA::dma_idle_handler()
+{
+    auto cycles = isr_cycles_begin();
+    auto saved = taskENTER_CRITICAL_FROM_ISR();
+
+    int64_t next = 0;
+    if (dma_write_pos()!=m_dma_read) {
+        // Still receiving. The tail came in some time since the last handover,
+        // at most an idle period ago, so take the earliest, and the uplink
+        // window is never overestimated
+        dma_rx_handover(from_us_since_boot(to_us_since_boot(get_absolute_time())-m_dma_idle_us));
+        next = m_dma_idle_us;
+    }
+    else {
+        m_dma_idle_alarm = 0;
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    isr_cycles_end(cycles);
+    return next;
+}
+
+
+#ifndef NDEBUG
+void ReceiverDMA::print_stats()
+{
+    Receiver::print_stats();
+
+    int64_t elapsed_us = absolute_time_diff_us(m_isr_stats_begin, get_absolute_time());
+    float load = 100.0f*m_isr_cycles/(elapsed_us*(clock_get_hz(clk_sys)/1000000.0f));
+    printf("Receiver rx: mode=%s  isr calls=%u  pushes=%u  bytes=%u  cycles/byte=%.1f  load=%.2f%%\n",
+        m_rx_mode==RxMode::DMA ? "DMA" : "IRQ",
+        m_isr_calls, m_isr_pushes, m_isr_bytes,
+        m_isr_bytes ? static_cast<float>(m_isr_cycles)/m_isr_bytes : 0.0f,
+        load);
+}
+#endif
+
+
+}
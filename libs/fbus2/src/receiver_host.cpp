@@ -0,0 +1,139 @@
+/**
+ * @file receiver_host.cpp
+ * @author Peter Christoffersen
+ * @brief 
+ * @version 0.1
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ * Receiver fed from memory, for running the protocols on the host.
+ * 
+ */
+#include <fbus2/receiver_host.h>
+
+#include <algorithm>
+#include <pico/stdlib.h>
+
+namespace FBus2 {
+
+
+ReceiverHostBase::ReceiverHostBase(const LineConfig &line) :
+    Receiver { line, tskIDLE_PRIORITY, tskIDLE_PRIORITY },
+    m_steps { 0 },
+    m_data_count { 0 },
+    m_changed_count { 0 },
+    m_telemetry { Telemetry::null() }
+{
+    // Never block waiting for data, step() returns when the buffer runs dry
+    m_rx_timeout = 0;
+}
+
+
+/**
+ * @brief Setup buffers and state, but no tasks
+ * 
+ * There is no lower task, so on_data() is called from poll() whenever a control
+ * package has been received, and no frames are skipped. The failsafe deadline
+ * is checked by poll_failsafe().
+ */
+void ReceiverHostBase::init()
+{
+    init_receiver();
+}
+
+
+/**
+ * @brief Push data into the receiver, like the ISR does, and process it
+ * 
+ * Data is pushed in chunks of what the rx stream buffer can hold, and the 
+ * receiver is polled between each chunk.
+ * 
+ * @param rx_time Time the data was received, or nil_time for the current time, 
+ *                so tests can run on a simulated clock
+ * @return size_t Number of bytes processed (always len)
+ */
+size_t ReceiverHostBase::feed(const uint8_t *data, size_t len, absolute_time_t rx_time)
+{
+    size_t fed = 0;
+    while (fed<len) {
+        fed += push(data+fed, len-fed, rx_time);
+        poll();
+    }
+    return fed;
+}
+
+
+/**
+ * @brief Push data into the rx stream buffer, like the ISR does, without processing it
+ * 
+ * @param rx_time Time the data was received, or nil_time for now()
+ * @return size_t Number of bytes accepted, the rest is dropped as by the ISR
+ */
+size_t ReceiverHostBase::push(const uint8_t *data, size_t len, absolute_time_t rx_time)
+{
+    len = std::min(xStreamBufferSpacesAvailable(m_rx_buffer), len);
+    m_last_rx_time = is_nil_time(rx_time) ? now() : rx_time;
+    if (m_recorder) {
+        m_recorder->record(data, len, m_last_rx_time);
+    }
+    for (size_t i=0; i<len; ++i) {
+        m_rx_sums.push(data[i]);
+    }
+    m_rx_times.push(len, m_last_rx_time);
+    return xStreamBufferSend(m_rx_buffer, data, len, 0);
+}
+
+
+/**
+ * @brief Feed a recorded log, as fast as it can be parsed
+ * 
+ * Each entry is fed with its recorded time, so the receiver sees the original 
+ * timing without having to wait for it. Timeouts that are checked against 
+ * now() (SYNC_TIMEOUT) still run on the host clock, unless now() is overridden.
+ * 
+ * @return size_t Number of bytes fed
+ */
+size_t ReceiverHostBase::replay(RecordReader log)
+{
+    size_t fed = 0;
+    RecordReader::Entry entry;
+    while (log.next(entry)) {
+        fed += feed(entry.data, entry.len, entry.time);
+    }
+    return fed;
+}
+
+
+/**
+ * @brief Step the state machine until it has used all the received data
+ * 
+ * Whatever the receiver task publishes, frames and lost sync, is delivered 
+ * as the lower task would.
+ * 
+ * @return size_t Number of steps taken
+ */
+size_t ReceiverHostBase::poll()
+{
+    size_t steps = 0;
+    auto published = m_channels_published.seq();
+    while (step()) {
+        steps++;
+        if (m_channels_published.seq()!=published) {
+            published = m_channels_published.seq();
+            m_lower_channels = m_channels_published.load();
+            deliver(m_lower_channels);
+        }
+    }
+    m_steps += steps;
+    return steps;
+}
+
+
+void ReceiverHostBase::tx_send(const uint8_t *buf, size_t sz)
+{
+    m_tx_data.insert(m_tx_data.end(), buf, buf+sz);
+}
+
+
+}
@@ -15,6 +15,7 @@
 #include <pico/stdlib.h>
 #include <hardware/pio.h>
 #include <hardware/irq.h>
+#include <hardware/dma.h>
 
 #include "uart_rx.pio.h"
 #include "uart_tx.pio.h"
@@ -23,8 +24,13 @@
 namespace FBus2 {
 
 
-ReceiverPIO::ReceiverPIO(PIO pio, uint baudrate, uint pin, UBaseType_t task_priority, UBaseType_t lower_task_priority) :
-    Receiver { baudrate, task_priority, lower_task_priority },
+ReceiverPIO *ReceiverPIO::m_instances[NUM_PIOS][NUM_PIO_STATE_MACHINES] = {};
+int ReceiverPIO::m_rx_offset[NUM_PIOS] = { -1, -1 };
+int ReceiverPIO::m_tx_offset[NUM_PIOS] = { -1, -1 };
+
+
+ReceiverPIO::ReceiverPIO(PIO pio, const LineConfig &line, uint pin, UBaseType_t task_priority, UBaseType_t lower_task_priority, RxMode rx_mode) :
+    ReceiverDMA { line, task_priority, lower_task_priority, rx_mode },
     m_pio { pio },
     m_pin { pin }
 {
@@ -32,16 +38,40 @@ ReceiverPIO::ReceiverPIO(PIO pio, uint baudrate, uint pin, UBaseType_t task_prio
 }
 
 
+ReceiverPIO::~ReceiverPIO()
+{
+    for (auto &pio_instances : m_instances) {
+        for (auto &instance : pio_instances) {
+            if (instance==this) {
+                instance = nullptr;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Setup a rx and a tx state machine
+ * 
+ * The programs are only loaded once per PIO, so two receivers fit on one PIO.
+ * They are 8N1 only, and the pin is driven open drain, so inverted lines need
+ * the UART receiver.
+ */
 void ReceiverPIO::hardware_init()
 {
-    auto rx_offset = pio_add_program(m_pio, &uart_rx_program);
-    auto tx_offset = pio_add_program(m_pio, &uart_tx_program);
+    assert(m_line.is_8n1());
+
+    uint index = pio_get_index(m_pio);
+    if (m_rx_offset[index]<0) {
+        m_rx_offset[index] = pio_add_program(m_pio, &uart_rx_program);
+        m_tx_offset[index] = pio_add_program(m_pio, &uart_tx_program);
+    }
 
     m_rx_sm = pio_claim_unused_sm(m_pio, true);
-    uart_rx_program_init(m_pio, m_rx_sm, rx_offset, m_pin, m_baudrate);
+    uart_rx_program_init(m_pio, m_rx_sm, m_rx_offset[index], m_pin, m_baudrate);
 
     m_tx_sm = pio_claim_unused_sm(m_pio, true);
-    uart_tx_program_init(m_pio, m_tx_sm, tx_offset, m_pin, m_baudrate);
+    uart_tx_program_init(m_pio, m_tx_sm, m_tx_offset[index], m_pin, m_baudrate);
 
     // Only drive output on LOW, on HIGH leave pin floating with a pullup
     gpio_pull_up(m_pin);
@@ -56,53 +86,70 @@ void ReceiverPIO::task_init()
 }
 
 
-void ReceiverPIO::irq_set_tx_enable(bool enable)
-{
-    pio_set_irqn_source_enabled(m_pio, get_core_num(), static_cast<pio_interrupt_source>(pis_sm0_tx_fifo_not_full+m_tx_sm), enable);
-}
-
-
+/**
+ * @brief Send with DMA
+ * 
+ * The whole uplink frame is clocked out by the tx state machine, paced by 
+ * DMA, so there are no tx interrupts within the reply window.
+ */
 void ReceiverPIO::tx_send(const uint8_t *buf, size_t sz)
 {
-    while (sz && !pio_sm_is_tx_fifo_full(m_pio, m_tx_sm)) {
-        uart_tx_program_putc(m_pio, m_tx_sm, *buf);
-        buf++;
-        sz--;
-    }
-    if (sz) {
-        xStreamBufferSend(m_tx_buffer, buf, sz, portMAX_DELAY);
-        irq_set_tx_enable(true);
-    }
+    dma_tx_send(buf, sz);
 }
 
 
+/**
+ * @brief Drain the rx FIFO, and pass it on in one go
+ */
 inline void ReceiverPIO::isr_handler()
 {
-    uint8_t ch;
+    auto cycles = isr_cycles_begin();
+    uint8_t data[RX_FIFO_SIZE];
+    size_t len = 0;
 
-    while (pio_sm_is_rx_fifo_empty(m_pio, m_rx_sm)) {
-        ch = uart_rx_program_getc(m_pio, m_rx_sm);
-        if (xStreamBufferSendFromISR(m_rx_buffer, &ch, 1, nullptr)!=sizeof(ch))
-            break;
+    while (len<RX_FIFO_SIZE && !pio_sm_is_rx_fifo_empty(m_pio, m_rx_sm)) {
+        data[len++] = uart_rx_program_getc(m_pio, m_rx_sm);
+    }
+    auto rx_time = get_absolute_time();
+    size_t sent = len ? rx_isr_push(data, len, rx_time) : 0;
+    if (sent) {
+        m_isr_pushes++;
+        m_isr_bytes += sent;
     }
     auto saved = taskENTER_CRITICAL_FROM_ISR();
-    m_last_rx_time = get_absolute_time();
+    m_last_rx_time = rx_time;
     taskEXIT_CRITICAL_FROM_ISR(saved);
 
-    if (!xStreamBufferIsEmpty(m_tx_buffer) && !pio_sm_is_tx_fifo_full(m_pio, m_tx_sm)) {
-        if (xStreamBufferReceiveFromISR(m_tx_buffer, &ch, sizeof(ch), nullptr)==sizeof(ch)) {
-            uart_tx_program_putc(m_pio, m_tx_sm, ch);
+    isr_cycles_end(cycles);
+}
+
+
+
+/**
+ * @brief Interrupt handler for all the receivers on a PIO, they share its interrupt
+ */
+template<uint PIO_INDEX>
+void ReceiverPIO::isr_dispatch()
+{
+    for (auto receiver : m_instances[PIO_INDEX]) {
+        if (receiver && !pio_sm_is_rx_fifo_empty(receiver->m_pio, receiver->m_rx_sm)) {
+            receiver->isr_handler();
         }
     }
-    if (xStreamBufferIsEmpty(m_tx_buffer)) {
-        irq_set_tx_enable(false);
-    }
 }
 
 
-
 void ReceiverPIO::init_isr()
 {
+    init_dma_tx(&m_pio->txf[m_tx_sm], pio_get_dreq(m_pio, m_tx_sm, true));
+    isr_stats_begin();
+
+    if (m_rx_mode==RxMode::DMA) {
+        // Data is in the top byte of the FIFO word, as it is shifted in from the left
+        init_dma_rx(reinterpret_cast<io_rw_8*>(&m_pio->rxf[m_rx_sm])+3, pio_get_dreq(m_pio, m_rx_sm, false));
+        return;
+    }
+
     uint irq_num;
     if (m_pio==pio0) {
         irq_num = PIO0_IRQ_0 + get_core_num();
@@ -111,9 +158,17 @@ void ReceiverPIO::init_isr()
         irq_num = PIO1_IRQ_0 + get_core_num();
     }
 
+    static_assert(NUM_PIOS==2);
+    uint index = pio_get_index(m_pio);
+    assert(m_instances[index][m_rx_sm]==nullptr);
+    m_instances[index][m_rx_sm] = this;
+
     pio_set_irqn_source_enabled(m_pio, get_core_num(), static_cast<pio_interrupt_source>(pis_sm0_rx_fifo_not_empty+m_rx_sm), true);
 
-    irq_set_exclusive_handler(irq_num, +[]() { static_cast<ReceiverPIO*>(m_instance)->isr_handler(); });
+    irq_handler_t handler = index==0 ? &isr_dispatch<0> : &isr_dispatch<1>;
+    if (irq_get_exclusive_handler(irq_num)!=handler) {
+        irq_set_exclusive_handler(irq_num, handler);
+    }
     irq_set_enabled(irq_num, true);
 }
 
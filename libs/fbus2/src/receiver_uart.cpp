@@ -14,30 +14,55 @@
 
 #include <pico/stdlib.h>
 #include <hardware/uart.h>
+#include <hardware/irq.h>
 
 namespace FBus2 {
 
 
-ReceiverUART::ReceiverUART(uart_inst_t *uart, uint baudrate, uint tx_pin, uint rx_pin, UBaseType_t task_priority, UBaseType_t lower_task_priority) :
-    Receiver { baudrate, task_priority, lower_task_priority },
+ReceiverUART *ReceiverUART::m_instances[NUM_UARTS] = {};
+
+
+ReceiverUART::ReceiverUART(uart_inst_t *uart, const LineConfig &line, uint tx_pin, uint rx_pin, UBaseType_t task_priority, UBaseType_t lower_task_priority, RxMode rx_mode) :
+    ReceiverDMA { line, task_priority, lower_task_priority, rx_mode },
     m_uart { uart },
     m_tx_pin { tx_pin },
-    m_rx_pin { rx_pin }
+    m_rx_pin { rx_pin },
+    m_tx_buffer { nullptr }
 {
 
 }
 
 
+ReceiverUART::~ReceiverUART()
+{
+    for (auto &instance : m_instances) {
+        if (instance==this) {
+            instance = nullptr;
+        }
+    }
+}
+
+
 void ReceiverUART::hardware_init()
 {
+    m_tx_buffer = xStreamBufferCreateStatic(TX_BUFFER_SIZE, 1, m_tx_buffer_data, &m_tx_buffer_buf);
+    assert(m_tx_buffer);
+
     gpio_set_function(m_tx_pin, GPIO_FUNC_UART);
     gpio_set_function(m_rx_pin, GPIO_FUNC_UART);
 
     uart_init(m_uart, m_baudrate);
+    uart_set_format(m_uart, 8, m_line.stop_bits, 
+        m_line.parity==LineConfig::Parity::EVEN ? UART_PARITY_EVEN : 
+        m_line.parity==LineConfig::Parity::ODD ? UART_PARITY_ODD : UART_PARITY_NONE);
     #if PICO_UART_ENABLE_CRLF_SUPPORT
     uart_set_translate_crlf(m_uart, false);
     #endif
 
+    // Inverted lines (SBUS) are inverted at the pads, so the UART sees a normal line
+    gpio_set_inover(m_rx_pin, m_line.inverted ? GPIO_OVERRIDE_INVERT : GPIO_OVERRIDE_NORMAL);
+    gpio_set_outover(m_tx_pin, m_line.inverted ? GPIO_OVERRIDE_INVERT : GPIO_OVERRIDE_NORMAL);
+
 }
 
 
@@ -67,20 +92,33 @@ void ReceiverUART::tx_send(const uint8_t *buf, size_t sz)
 }
 
 
+/**
+ * @brief UART interrupt, rx in IRQ mode and tx from the stream buffer
+ *
+ * Only the rx half is counted in the ISR load, so it compares with DMA mode.
+ */
 inline void ReceiverUART::isr_handler()
 {
     uint8_t ch;
 
     auto status = uart_get_hw(m_uart)->mis;
 
-    while (uart_is_readable(m_uart)) {
-        uart_read_blocking(m_uart, &ch, sizeof(ch));
-        if (xStreamBufferSendFromISR(m_rx_buffer, &ch, 1, nullptr)!=sizeof(ch))
-            break;
+    if (m_rx_mode==RxMode::IRQ) {
+        auto cycles = isr_cycles_begin();
+        // The FIFO is drained in a few us, so the bytes share a time
+        auto rx_time = get_absolute_time();
+        while (uart_is_readable(m_uart)) {
+            uart_read_blocking(m_uart, &ch, sizeof(ch));
+            if (!rx_isr_push(ch, rx_time))
+                break;
+            m_isr_pushes++;
+            m_isr_bytes++;
+        }
+        auto saved = taskENTER_CRITICAL_FROM_ISR();
+        m_last_rx_time = rx_time;
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+        isr_cycles_end(cycles);
     }
-    auto saved = taskENTER_CRITICAL_FROM_ISR();
-    m_last_rx_time = get_absolute_time();
-    taskEXIT_CRITICAL_FROM_ISR(saved);
 
     if (status & UART_UARTMIS_TXMIS_BITS) {
         while (uart_is_writable(m_uart) && !xStreamBufferIsEmpty(m_tx_buffer)) {
@@ -96,17 +134,38 @@ inline void ReceiverUART::isr_handler()
 
 
 
+template<uint UART_INDEX>
+void ReceiverUART::isr_dispatch()
+{
+    m_instances[UART_INDEX]->isr_handler();
+}
+
+
 void ReceiverUART::init_isr()
 {
+    static_assert(NUM_UARTS==2);
+    uint index = uart_get_index(m_uart);
+    assert(m_instances[index]==nullptr);
+    m_instances[index] = this;
+
     uint UART_IRQ = m_uart == uart0 ? UART0_IRQ : UART1_IRQ;
-    irq_set_exclusive_handler(UART_IRQ, +[]() { static_cast<ReceiverUART*>(m_instance)->isr_handler(); });
+    irq_set_exclusive_handler(UART_IRQ, index==0 ? &isr_dispatch<0> : &isr_dispatch<1>);
     irq_set_enabled(UART_IRQ, true);
 
-    uart_get_hw(m_uart)->imsc = (1u << UART_UARTIMSC_RTIM_LSB)|(1u << UART_UARTIMSC_RXIM_LSB);
+    if (m_rx_mode==RxMode::IRQ) {
+        uart_get_hw(m_uart)->imsc = (1u << UART_UARTIMSC_RTIM_LSB)|(1u << UART_UARTIMSC_RXIM_LSB);
+    }
+    else {
+        // Rx FIFO is drained by DMA, the UART interrupt is only used for tx
+        uart_get_hw(m_uart)->imsc = 0;
+        init_dma_rx(&uart_get_hw(m_uart)->dr, uart_get_dreq(m_uart, false));
+    }
     // Set minimum rx threshold to 1/2
     hw_write_masked(&uart_get_hw(m_uart)->ifls, 0b010 << UART_UARTIFLS_RXIFLSEL_LSB, UART_UARTIFLS_RXIFLSEL_BITS);
     // Set maximum tx threshold to 1/2
     hw_write_masked(&uart_get_hw(m_uart)->ifls, 0b000 << UART_UARTIFLS_TXIFLSEL_LSB, UART_UARTIFLS_TXIFLSEL_BITS);
+
+    isr_stats_begin();
 }
 
 
@@ -0,0 +1,60 @@
+/**
+ * @author Peter Christoffersen
+ * @brief SBUS protocol definitions
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ * 100000 baud, 8E2, inverted. A frame every 7 or 14 ms, with a gap between
+ * frames.
+ * 
+ */
+#pragma once
+
+#include "protocol.h"
+
+namespace FBus2 {
+
+    /**
+     * @brief Frame
+     * 
+     * |<HDR>|<CHANNEL DATA>|<FLAGS>|<FOOTER>|
+     * 
+     * HDR: Always 0x0F
+     * CHANNEL DATA: 16 channels of 11 bits, packed as FBus2 channels
+     * FLAGS: Ch17, ch18, frame lost and failsafe, in the same bits as FBus2
+     * FOOTER: 0x00, or 0x?4 on SBUS2, where the high nibble is the telemetry slot
+     * 
+     * There is no checksum, so a frame is only as good as its header and footer.
+     */
+    static constexpr uint8_t SBUS_HDR            = 0x0F;
+    static constexpr size_t  SBUS_FRAME_SIZE     = 25u;
+    static constexpr size_t  SBUS_CHANNEL_COUNT  = 16u;
+    static constexpr size_t  SBUS_CHANNELS_OFFSET = 1u;
+    static constexpr size_t  SBUS_FLAGS_OFFSET   = 23u;
+    static constexpr size_t  SBUS_FOOTER_OFFSET  = 24u;
+    static constexpr uint8_t SBUS_FLAGS_MASK     = 0x0F;
+    static constexpr uint8_t SBUS_FOOTER         = 0x00;
+    static constexpr uint8_t SBUS2_FOOTER        = 0x04;
+    static constexpr uint8_t SBUS2_FOOTER_MASK   = 0x0F;
+
+    static_assert(SBUS_CHANNELS_OFFSET+SBUS_CHANNEL_COUNT*FBUS_CHANNEL_BITS/8==SBUS_FLAGS_OFFSET, "Expected channel data to fill up to the flags");
+
+    static inline bool sbus_footer_valid(uint8_t footer)
+    {
+        return footer==SBUS_FOOTER || (footer & SBUS2_FOOTER_MASK)==SBUS2_FOOTER;
+    }
+
+    template <typename buffer_type> 
+    static inline bool sbus_frame_valid(const buffer_type &buffer) 
+    { 
+        return buffer[0]==SBUS_HDR && sbus_footer_valid(buffer[SBUS_FOOTER_OFFSET]);
+    }
+
+    template <typename buffer_type> 
+    static inline uint8_t sbus_flags(const buffer_type &buffer) 
+    { 
+        return buffer[SBUS_FLAGS_OFFSET] & SBUS_FLAGS_MASK;
+    }
+
+}
@@ -0,0 +1,67 @@
+/**
+ * @author Peter Christoffersen
+ * @brief LED brightness and color correction lookup
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <array>
+#include <type_traits>
+#include <pico/stdlib.h>
+
+#include <led/color.h>
+
+namespace LED::Color {
+
+    /**
+     * @brief Per channel tables for the conversion from color to strip pixel
+     *
+     * Each table maps a channel value to the value sent to the strip, with
+     * the brightness scaling and the color correction applied, so a pixel is
+     * a lookup per channel instead of the multiplies and divides. The result
+     * is the same as multiplying the color by the brightness and then by the
+     * correction. White is only scaled by the brightness, it has no
+     * correction.
+     *
+     * The tables take a while to build, so only set() them when the
+     * brightness or correction changes.
+     */
+    class Table {
+        public:
+            using pixel_type = uint32_t;
+            using raw_type = ColorBase::raw_type;
+            using brightness_type = ColorBase::brightness_type;
+            using channel_type = ColorBase::channel_type;
+
+            Table() { set(ColorBase::BRIGHTNESS_DEFAULT, Correction::UncorrectedRGBW); }
+
+            void set(brightness_type brightness, Correction correction);
+
+            /**
+             * @brief Convert a color to the strip pixel format, GRB in the top 24 bits and white in the low 8
+             */
+            template<typename COLOR>
+            pixel_type pixel(const COLOR &color) const
+            {
+                pixel_type p = static_cast<pixel_type>(m_green[color.green()])<<24
+                    | static_cast<pixel_type>(m_red[color.red()])<<16
+                    | static_cast<pixel_type>(m_blue[color.blue()])<<8;
+                if constexpr (std::is_base_of_v<RGBW, COLOR>) {
+                    p |= m_white[color.white()];
+                }
+                return p;
+            }
+
+        private:
+            using table_type = std::array<channel_type, ColorBase::CHANNEL_MAX+1>;
+
+            table_type m_red;
+            table_type m_green;
+            table_type m_blue;
+            table_type m_white;
+    };
+
+}
@@ -20,6 +20,7 @@
 
 #include <led/color.h>
 #include <led/colorbuffer.h>
+#include <led/colortable.h>
 
 namespace LED {
 
@@ -35,7 +36,13 @@ namespace LED {
             virtual Color::RGB &operator[](size_t n) = 0;
             virtual const Color::RGB &operator[](size_t n) const = 0;
 
-            void set_brightness(brightness_type brightness) { m_brightness = brightness; }
+            void set_brightness(brightness_type brightness)
+            {
+                if (brightness!=m_brightness) {
+                    m_brightness = brightness;
+                    update_table();
+                }
+            }
             brightness_type get_brightness() const { return m_brightness; }
 
         protected:
@@ -50,6 +57,7 @@ namespace LED {
 
             Color::Correction m_correction;
             brightness_type m_brightness;
+            Color::Table m_table;
 
             uint m_sm;
             uint m_dma;
@@ -66,6 +74,9 @@ namespace LED {
 
             StripBase(PIO pio, uint pin, bool is_rgbw);
 
+            // Use brightness ^2 to make the perceived brightness seem more linear
+            void update_table() { m_table.set(m_brightness*m_brightness, m_correction); }
+
             void base_init(volatile void *dma_addr, size_t dma_count);
 
             static void global_init(); 
@@ -108,13 +119,10 @@ namespace LED {
             {
                 dma_wait();
 
-                // Call sub-class function top copy pixel data into dma buffer
                 //printf("LED COPY\n");
+                auto pixel = m_table.pixel(color);
                 for (uint idx=0; idx<NCOLORS; idx++) {
-                    auto c = color;
-                    c *= (m_brightness*m_brightness); // Use brightness ^2 to make the perceived brightness seem more linear
-                    c *= m_correction;
-                    m_dma_buffer[idx++] = c.rgb()<<8 | c.white();
+                    m_dma_buffer[idx] = pixel;
                 }
 
                 dma_start(m_dma_buffer);
@@ -127,14 +135,11 @@ namespace LED {
 
                 dma_wait();
 
-                // Call sub-class function top copy pixel data into dma buffer
+                // Brightness and color correction are in the table
                 //printf("LED COPY\n");
                 uint idx = 0;
                 for (const auto &color : color_buffer) {
-                    auto c = color;
-                    c *= (m_brightness*m_brightness); // Use brightness ^2 to make the perceived brightness seem more linear
-                    c *= m_correction;
-                    m_dma_buffer[idx++] = c.rgb()<<8 | c.white();
+                    m_dma_buffer[idx++] = m_table.pixel(color);
                 }
 
                 dma_start(m_dma_buffer);
@@ -144,14 +149,11 @@ namespace LED {
             {
                 dma_wait();
 
-                // Call sub-class function top copy pixel data into dma buffer
+                // Brightness and color correction are in the table
                 //printf("LED COPY\n");
                 uint idx = 0;
                 for (const auto &color : m_color_buffer) {
-                    auto c = color;
-                    c *= (m_brightness*m_brightness); // Use brightness ^2 to make the perceived brightness seem more linear
-                    c *= m_correction;
-                    m_dma_buffer[idx++] = c.rgb()<<8 | c.white();
+                    m_dma_buffer[idx++] = m_table.pixel(color);
                 }
 
                 dma_start(m_dma_buffer);
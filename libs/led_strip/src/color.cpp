@@ -1,4 +1,5 @@
 #include <led/color.h>
+#include <led/colortable.h>
 
 namespace LED::Color {
 
@@ -23,4 +24,21 @@ void RGBW::operator<<(const RGBA &src_color) {
     m_data = dst_w | dst_r | dst_g | dst_b;
 }
 
-}
\ No newline at end of file
+
+void Table::set(brightness_type brightness, Correction correction)
+{
+    // Same rounding as RGB::operator*(brightness)
+    constexpr raw_type MAX { ColorBase::CHANNEL_MAX };
+    raw_type scale = std::clamp<raw_type>(brightness*static_cast<brightness_type>(MAX)+0.5f, ColorBase::CHANNEL_MIN, MAX);
+    raw_type corr = static_cast<raw_type>(correction);
+
+    for (raw_type v=0; v<=MAX; ++v) {
+        raw_type scaled = v*scale/MAX;
+        m_red[v]   = scaled*RGB::rawRed(corr)/MAX;
+        m_green[v] = scaled*RGB::rawGreen(corr)/MAX;
+        m_blue[v]  = scaled*RGB::rawBlue(corr)/MAX;
+        m_white[v] = scaled;
+    }
+}
+
+}
@@ -62,6 +62,7 @@ StripBase::StripBase(PIO pio, uint pin, bool is_rgbw):
     m_correction { Color::Correction::TypicalLEDStrip },
     m_brightness { Color::ColorBase::BRIGHTNESS_DEFAULT }
 {
+    update_table();
     assert(m_pio==nullptr || pio==m_pio); // Dont allow different PIO instances on different strips
     if (m_pio==nullptr) {
         m_pio = pio;
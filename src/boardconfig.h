@@ -28,6 +28,10 @@ static constexpr uint RADIO_RECEIVER_TX_PIN { 16 };
 static constexpr uint RADIO_RECEIVER_RX_PIN { 17 };
 static constexpr uint RADIO_RECEIVER_BAUD_RATE { 460800 };
 //static constexpr uint RADIO_RECEIVER_BAUD_RATE { 115200 };
+static constexpr bool RADIO_RECEIVER_RX_DMA { false }; // Receive with DMA instead of the UART rx interrupt
+static constexpr size_t RADIO_RECEIVER_LOG_SIZE { 0 }; // Raw stream recording, dumped to the console when sync is lost, e.g. 16*1024. 0 for none, it costs the RAM and time in the rx ISR
+static constexpr bool RADIO_RECEIVER_STICK_SHAPING { false }; // Expo, rate limit and low-pass on the sticks, on top of the deadband. Changes how the rover handles
+static constexpr int64_t RADIO_RECEIVER_FAILSAFE_US { 50000 }; // Motors are disarmed when no valid frame has come in for this long
 
 
 /* LED */
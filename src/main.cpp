@@ -103,6 +103,12 @@ static void main_task(__unused void *params)
                 break;
             case 2: 
                 {
+                    if constexpr (RADIO_RECEIVER_LOG_SIZE>0) {
+                        robot.receiver().dump_incident();
+                    }
+                    #ifndef NDEBUG
+                    robot.receiver().print_callback_load();
+                    #endif
                     //robot.receiver().print_stats();
                     //robot.telemetry_provider().print_stats();
                 }
@@ -196,14 +202,17 @@ static void init()
 
     #if 1
     // Register callbacks
-    robot.receiver().add_callback([](auto &receiver, auto &channels, auto &mapping){
+    robot.receiver().add_callback([](auto &receiver, auto &channels, auto &mapping, auto changes){
+        using mapping_type = Radio::Receiver::mapping_type;
+
         if (!channels.sync() || channels.flags().frameLost()) {
             robot.set_armed(false);
             return;
         }
 
+        // Arming is on a switch, so the motors are updated when it changes too
         robot.set_armed(mapping.sf());
-        if (robot.is_armed()) {
+        if (robot.is_armed() && changes.any(mapping_type::STICKS|mapping_type::DIALS|mapping_type::SWITCHES|Radio::ChangeMask::LINK)) {
             auto &servos = robot.servos();
             //servos[0].put(mapping.right_y().asServoPulse());
             //servos[1].put(mapping.right_x().asServoPulse());
@@ -212,6 +221,10 @@ static void init()
             drive_wheels(mapping.right_x().asFloat(), mapping.right_y().asFloat(), mapping.left_x().asFloat());
         }
 
+        if (!changes.any(mapping_type::DIALS|mapping_type::SLIDERS|mapping_type::SWITCHES|Radio::ChangeMask::LINK)) {
+            return;
+        }
+
         // LEDS
         auto &leds = robot.leds();
         switch (mapping.sc()) {
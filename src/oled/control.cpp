@@ -226,11 +226,10 @@ void Control::update_battery(bool force)
 
 void Control::update_radio(bool force)
 {
-    m_robot.receiver().lock();
-    auto flags = m_robot.receiver().flags();
-    auto sync= m_robot.receiver().sync();
-    auto rssi = m_robot.receiver().rssi();
-    m_robot.receiver().unlock();
+    auto channels = m_robot.receiver().channels();
+    auto flags = channels.flags();
+    auto sync = channels.sync();
+    auto rssi = channels.rssi();
 
     constexpr int TEXT_WIDTH  { 12 };
     constexpr int AREA_LEFT   { 128-Resource::Image::Battery.width()-20-TEXT_WIDTH };
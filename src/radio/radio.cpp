@@ -1,17 +1,77 @@
 #include "radio.h"
 
+#include <inttypes.h>
+
 namespace Radio {
 
 
-void Receiver::on_data(const channels_type &channels)
+/**
+ * @brief Map and dispatch the channels, unless nothing moved beyond the deadband
+ */
+void Receiver::on_data(const channels_type &channels, FBus2::ChangeMask changes)
+{
+    if (changes.none()) {
+        #ifndef NDEBUG
+        m_unchanged_frames++;
+        #endif
+        return;
+    }
+
+    #ifndef NDEBUG
+    auto begin = get_absolute_time();
+    #endif
+    if (changes.any(~FBus2::ChangeMask::LINK)) {
+        m_mapping.set(channels);
+    }
+    m_control_callback(*this, channels, m_mapping, changes);
+    #ifndef NDEBUG
+    m_callback_us += absolute_time_diff_us(begin, get_absolute_time());
+    m_callback_frames++;
+    #endif
+}
+
+#ifndef NDEBUG
+/**
+ * @brief Print the callback CPU time per second, and how many frames were skipped as unchanged
+ */
+void Receiver::print_callback_load()
+{
+    auto now = get_absolute_time();
+    int64_t elapsed_us = absolute_time_diff_us(m_callback_load_begin, now);
+    if (elapsed_us<=0) {
+        return;
+    }
+    printf("Radio: callbacks %" PRId64 " us/s  frames=%u  unchanged=%u\n", m_callback_us*1000000/elapsed_us, m_callback_frames, m_unchanged_frames);
+    m_callback_us = 0;
+    m_callback_frames = 0;
+    m_unchanged_frames = 0;
+    m_callback_load_begin = now;
+}
+#endif
+
+
+Telemetry Receiver::get_next_telemetry(uint8_t sensor_id) 
 {
-    m_mapping.set(channels);
-    m_control_callback(*this, channels, m_mapping);
+    return m_telemetry_provider->get_next_telemetry(sensor_id);
 }
 
-Telemetry Receiver::get_next_telemetry() 
+
+/**
+ * @brief Dump the recording to the console, if it was frozen by a loss of sync
+ * 
+ * Recording starts over afterwards. Use tools/fbus2_log.py to get the log out 
+ * of the console output. Only records with RADIO_RECEIVER_LOG_SIZE set.
+ */
+void Receiver::dump_incident()
 {
-    return m_telemetry_provider->get_next_telemetry();
+    auto log = recorder();
+    if (!log || !log->frozen()) {
+        return;
+    }
+    printf("Radio: lost sync, dumping %zu bytes of received data\n", log->size());
+    log->print_hex();
+    log->clear();
+    log->resume();
 }
 
 
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <fbus2/receiver_uart.h>
+#include <fbus2/protocol_receiver.h>
+#include <fbus2/protocol_fbus2.h>
 #include <fbus2/mapping.h>
 #include <fbus2/channels.h>
 #include <fbus2/telemetry.h>
+#include <fbus2/recorder.h>
+#include <fbus2/shaping.h>
+#include <type_traits>
 #include <util/callback.h>
 #include <boardconfig.h>
 #include <rtos.h>
@@ -11,39 +16,83 @@
 
 namespace Radio {
 
-    class Receiver : public FBus2::ReceiverUART {
+    class Receiver : public FBus2::ProtocolReceiver<FBus2::FBus2Protocol, FBus2::ReceiverUART> {
         public:
             using mapping_type = FBus2::TaranisX9DPlus;        
-            using control_cb_type = Callback<const Receiver&, const channels_type &, const mapping_type &>;
+            // Sticks are shaped once per frame, before the callbacks see them
+            using stick_filter_type = std::conditional_t<RADIO_RECEIVER_STICK_SHAPING,
+                FBus2::ChannelFilter<mapping_type::STICKS,
+                    FBus2::Shaping::Deadband<10>,
+                    FBus2::Shaping::Expo<30>,
+                    FBus2::Shaping::RateLimit<200>,   // 5 frames from center to full, 10 from full reverse to full forward
+                    FBus2::Shaping::LowPass<1>
+                >,
+                FBus2::ChannelFilter<mapping_type::STICKS,
+                    FBus2::Shaping::Deadband<10>
+                >
+            >;
+            using control_cb_type = Callback<const Receiver&, const channels_type &, const mapping_type &, FBus2::ChangeMask>;
 
             Receiver() : 
-                FBus2::ReceiverUART { 
+                ProtocolReceiver { 
                     RADIO_RECEIVER_UART, 
                     RADIO_RECEIVER_BAUD_RATE, 
                     RADIO_RECEIVER_TX_PIN, 
                     RADIO_RECEIVER_RX_PIN,
                     RECEIVER_TASK_PRIORITY,
-                    RECEIVER_LOWER_TASK_PRIORITY
-                }
+                    RECEIVER_LOWER_TASK_PRIORITY,
+                    RADIO_RECEIVER_RX_DMA ? RxMode::DMA : RxMode::IRQ
+                },
+                m_recorder { RADIO_RECEIVER_BAUD_RATE }
             {
-
+                #ifndef NDEBUG
+                m_callback_us = 0;
+                m_callback_frames = 0;
+                m_unchanged_frames = 0;
+                m_callback_load_begin = get_absolute_time();
+                #endif
+                set_recorder(recorder_ptr(m_recorder));
+                set_shaper(&m_stick_filter);
+                set_failsafe_timeout(RADIO_RECEIVER_FAILSAFE_US);
             }
 
             void add_callback(control_cb_type::call_type callback) { m_control_callback.add(callback); }
             void set_telemetry_provider(TelemetryProvider *provider) { m_telemetry_provider = provider; }
 
+            void dump_incident();
+            #ifndef NDEBUG
+            void print_callback_load();
+            #endif
+
         protected:
 
-            virtual void on_data(const channels_type &channels) override;
-            virtual Telemetry get_next_telemetry() override;
+            virtual void on_data(const channels_type &channels, FBus2::ChangeMask changes) override;
+            virtual Telemetry get_next_telemetry(uint8_t sensor_id) override;
 
         private:
             control_cb_type m_control_callback;
             TelemetryProvider *m_telemetry_provider;
             mapping_type m_mapping;
+            // Only there when RADIO_RECEIVER_LOG_SIZE is set
+            struct NoRecorder { NoRecorder(uint) {} };
+            using recorder_type = std::conditional_t<(RADIO_RECEIVER_LOG_SIZE>0), FBus2::StaticRecorder<RADIO_RECEIVER_LOG_SIZE>, NoRecorder>;
+            static FBus2::Recorder *recorder_ptr(FBus2::Recorder &recorder) { return &recorder; }
+            static FBus2::Recorder *recorder_ptr(NoRecorder &) { return nullptr; }
+
+            recorder_type m_recorder;
+            stick_filter_type m_stick_filter;
+
+            #ifndef NDEBUG
+            // Callback load, since the last print_callback_load()
+            int64_t m_callback_us;
+            uint m_callback_frames;
+            uint m_unchanged_frames;
+            absolute_time_t m_callback_load_begin;
+            #endif
     };
 
     using Channels = FBus2::Channels;
+    using ChangeMask = FBus2::ChangeMask;
     using Toggle = FBus2::Toggle;
 
 }
\ No newline at end of file
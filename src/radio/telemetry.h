@@ -9,7 +9,7 @@ namespace Radio {
     class TelemetryProvider {
         protected:
             friend class Receiver;
-            virtual Telemetry get_next_telemetry() = 0;
+            virtual Telemetry get_next_telemetry(uint8_t sensor_id) = 0;
     };
 
 }
\ No newline at end of file
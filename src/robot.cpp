@@ -58,6 +58,7 @@ void Robot::init()
     m_receiver.init();
     m_telemetry_provider.init();
     m_receiver.set_telemetry_provider(&m_telemetry_provider);
+    m_receiver.set_sensor_ids(Telemetry::Provider::SENSOR_IDS.data(), Telemetry::Provider::SENSOR_IDS.size());
 
     // Register callbacks
 
@@ -68,7 +69,10 @@ void Robot::init()
         }
     });
 
-    m_receiver.add_callback([this](const auto &receiver, const auto &channels, const auto &mapping){
+    m_receiver.add_callback([this](const auto &receiver, const auto &channels, const auto &mapping, auto changes){
+        if (!changes.link()) {
+            return;
+        }
         auto connected = channels.sync() && !channels.flags().frameLost();
         if (m_connected!=connected) {
             m_connected = connected;
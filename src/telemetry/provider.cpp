@@ -1,101 +1,83 @@
 #include "provider.h"
 
 #include <robot.h>
-#include <math.h>
 
 namespace Telemetry {
 
 Provider::Provider(Robot &robot) :
     m_robot { robot }, 
-    m_primary { 0 },
-    m_secondary { 0 }
+    m_count { 0 },
+    m_motors_scheduler { MOTORS_RATES },
+    m_attitude_scheduler { ATTITUDE_RATES },
+    m_power_scheduler { POWER_RATES }
 {
 
 }
 
 
+/**
+ * @brief Register the producers
+ * 
+ * Values are encoded by the sensor tasks as new data arrives, so the uplink 
+ * only has to copy a word from the cache, and never waits for a sensor lock.
+ * Must be called before the sensors are started.
+ */
 void Provider::init()
 {
     #ifndef NDEBUG
     m_last_print = get_absolute_time();
+    m_last_count = 0;
     #endif
-}
-
-
-
 
-Radio::Telemetry Provider::get_secondary()
-{
-    switch (m_secondary++) {
-        case 0:
-            {
-                auto voltage = m_robot.battery_sensor().get_bus_voltage();
-                return Radio::Telemetry::cells(0x00, 0, 2, voltage/2.0f, voltage/2.0f);
-            }
-        case 1:
-            {
-                auto current = m_robot.battery_sensor().get_current();
-                return Radio::Telemetry::current(0x00, current);
-            }
-        case 2:
-            {
-                auto temp = m_robot.sys_sensor().get_temp();
-                return Radio::Telemetry::temperature1(0, temp);
-            }
-        case 4:
-            {
-                m_secondary = 0;
-                auto voltage = m_robot.sys_sensor().get_vsys();
-                return Radio::Telemetry::a3(0, voltage);
-            }
+    for (size_t i=0; i<=RPM_3-RPM_0; ++i) {
+        m_robot.motors()[i].encoder().add_callback([this, i](const auto &encoder, auto value, auto rpm){
+            m_cache.store(RPM_0+i, Radio::Telemetry::rpm(encoder.id(), rpm));
+        });
     }
 
-    return Radio::Telemetry::null();
+    m_robot.imu().add_callback([this](const auto &imu, auto tick_delta){
+        imu.lock();
+        auto heading = imu.heading();
+        auto pitch = imu.pitch();
+        auto roll = imu.roll();
+        imu.unlock();
+        m_cache.store(HEADING, Radio::Telemetry::diy(0, to_degrees(heading)));
+        m_cache.store(PITCH, Radio::Telemetry::diy(1, to_degrees(pitch)));
+        m_cache.store(ROLL, Radio::Telemetry::diy(2, to_degrees(roll)));
+    });
+
+    m_robot.battery_sensor().add_callback([this](const auto &sensor, float voltage, float current, float power){
+        m_cache.store(CELLS, Radio::Telemetry::cells(0x00, 0, 2, voltage/2.0f, voltage/2.0f));
+        m_cache.store(CURRENT, Radio::Telemetry::current(0x00, current));
+    });
+
+    m_robot.sys_sensor().add_temp_cb([this](float temp){
+        m_cache.store(TEMPERATURE, Radio::Telemetry::temperature1(0, temp));
+    });
+    m_robot.sys_sensor().add_vsys_cb([this](float voltage){
+        m_cache.store(VSYS, Radio::Telemetry::a3(0, voltage));
+    });
 }
 
 
-Radio::Telemetry Provider::get_next_telemetry()
+/**
+ * @brief Called from the receiver task inside the uplink reply window, for the sensor id that was polled
+ */
+Radio::Telemetry Provider::get_next_telemetry(uint8_t sensor_id)
 {
     m_count++;
 
-
-    auto prim = m_primary++;
-    switch (prim) {
-        case 0:
-        case 1:
-        case 2:
-        case 3:
-            {
-                auto &encoder = m_robot.motors()[prim].encoder();
-                return Radio::Telemetry::rpm(encoder.id(), encoder.rpm());
-            }
-        case 4:
-            {
-                m_robot.imu().lock();
-                auto heading = m_robot.imu().heading();
-                m_robot.imu().unlock();
-                return Radio::Telemetry::diy(0, heading*180.0f/static_cast<float>(M_PI));
-            }
-        case 5:
-            {
-                m_robot.imu().lock();
-                auto pitch = m_robot.imu().pitch();
-                m_robot.imu().unlock();
-                return Radio::Telemetry::diy(1, pitch*180.0f/static_cast<float>(M_PI));
-            }
-        case 6:
-            {
-                m_robot.imu().lock();
-                auto roll = m_robot.imu().roll();
-                m_robot.imu().unlock();
-                return Radio::Telemetry::diy(2, roll*180.0f/static_cast<float>(M_PI));
-            }
+    auto now_us = to_us_since_boot(get_absolute_time());
+    switch (sensor_id) {
+        case MOTORS_ID:
+            return m_cache.load(RPM_0+m_motors_scheduler.next(now_us));
+        case ATTITUDE_ID:
+            return m_cache.load(HEADING+m_attitude_scheduler.next(now_us));
+        case POWER_ID:
+            return m_cache.load(CELLS+m_power_scheduler.next(now_us));
         default:
-            m_primary = 0;
-            return get_secondary();
+            return Radio::Telemetry::null();
     }
-
-    return Radio::Telemetry::null();
 }
 
 
@@ -113,9 +95,27 @@ void Provider::print_stats()
     }
 
     printf("Telemetry: count=%u  dc=%u  dt=%llu    %.2f\n", m_count, cdiff, tdiff, prc);
+
+    // Achieved against target rate, in Hz
+    auto now_us = to_us_since_boot(now);
+    print_scheduler(m_motors_scheduler, now_us);
+    print_scheduler(m_attitude_scheduler, now_us);
+    print_scheduler(m_power_scheduler, now_us);
+
     m_last_count = m_count;
     m_last_print = now;
 }
+
+
+template<typename scheduler_type>
+void Provider::print_scheduler(scheduler_type &scheduler, int64_t now_us)
+{
+    for (size_t i=0; i<scheduler.size(); ++i) {
+        auto &config = scheduler.config(i);
+        printf("  %-8s %6.2f / %6.2f\n", config.name, scheduler.achieved_mhz(i, now_us)/1000.0f, config.rate_mhz/1000.0f);
+    }
+    scheduler.reset_stats(now_us);
+}
 #endif
 
 }
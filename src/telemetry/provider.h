@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
+#include <math.h>
 #include <pico/stdlib.h>
 #include <radio/radio.h>
+#include <fbus2/telemetry_scheduler.h>
+#include <fbus2/telemetry_cache.h>
 
 class Robot;
 
@@ -9,11 +13,17 @@ namespace Telemetry {
 
     class Provider : public Radio::TelemetryProvider {
         public:
+            // Each sensor id gets its own poll slot, and its own group of values
+            static constexpr uint8_t MOTORS_ID   { Radio::Receiver::physical_id(10) };
+            static constexpr uint8_t ATTITUDE_ID { Radio::Receiver::physical_id(11) };
+            static constexpr uint8_t POWER_ID    { Radio::Receiver::RECEIVER_ID };
+            static constexpr std::array<uint8_t, 3> SENSOR_IDS { MOTORS_ID, ATTITUDE_ID, POWER_ID };
+
             Provider(Robot &robot);
 
             void init();
 
-            virtual  Radio::Telemetry get_next_telemetry();
+            virtual  Radio::Telemetry get_next_telemetry(uint8_t sensor_id);
 
             #ifndef NDEBUG
             absolute_time_t m_last_print;
@@ -22,13 +32,61 @@ namespace Telemetry {
             #endif
 
         private:
+            // Grouped by sensor id, in the order of SENSOR_IDS
+            enum Source : size_t {
+                RPM_0,
+                RPM_1,
+                RPM_2,
+                RPM_3,
+                HEADING,
+                PITCH,
+                ROLL,
+                CELLS,
+                CURRENT,
+                TEMPERATURE,
+                VSYS,
+                SOURCE_COUNT
+            };
+
+            using motors_scheduler_type = FBus2::TelemetryScheduler<HEADING-RPM_0>;
+            using attitude_scheduler_type = FBus2::TelemetryScheduler<CELLS-HEADING>;
+            using power_scheduler_type = FBus2::TelemetryScheduler<SOURCE_COUNT-CELLS>;
+            using cache_type = FBus2::TelemetryCache<SOURCE_COUNT>;
+            using Rate = FBus2::TelemetryRate;
+
+            // Target rates, in the order of Source
+            static constexpr motors_scheduler_type::config_type MOTORS_RATES {{
+                { "rpm0",    Rate::hz(10.0f), 2 },
+                { "rpm1",    Rate::hz(10.0f), 2 },
+                { "rpm2",    Rate::hz(10.0f), 2 },
+                { "rpm3",    Rate::hz(10.0f), 2 },
+            }};
+            static constexpr attitude_scheduler_type::config_type ATTITUDE_RATES {{
+                { "heading", Rate::hz(5.0f),  1 },
+                { "pitch",   Rate::hz(2.0f),  1 },
+                { "roll",    Rate::hz(2.0f),  1 },
+            }};
+            static constexpr power_scheduler_type::config_type POWER_RATES {{
+                { "cells",   Rate::hz(2.0f),  3 },
+                { "current", Rate::hz(2.0f),  2 },
+                { "temp",    Rate::hz(0.2f),  0 },
+                { "vsys",    Rate::hz(0.5f),  0 },
+            }};
+
             class Robot &m_robot;
 
             uint m_count;
-            uint m_primary;
-            uint m_secondary;
+            motors_scheduler_type m_motors_scheduler;
+            attitude_scheduler_type m_attitude_scheduler;
+            power_scheduler_type m_power_scheduler;
+            cache_type m_cache;
+
+            #ifndef NDEBUG
+            template<typename scheduler_type>
+            static void print_scheduler(scheduler_type &scheduler, int64_t now_us);
+            #endif
 
-            inline Radio::Telemetry get_secondary();
+            static float to_degrees(float rad) { return rad*180.0f/static_cast<float>(M_PI); }
     };
 
 }
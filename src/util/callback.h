@@ -1,24 +1,98 @@
 #pragma once
 
-#include <vector>
-#include <functional>
+#include <array>
+#include <new>
+#include <utility>
+#include <assert.h>
+#include <type_traits>
 
+/**
+ * @brief Callable with inline storage, for CallbackList
+ *
+ * Holds a lambda, or a function pointer, in place, so there is no heap, and
+ * calling it is one indirect call. The lambda must fit in INLINE_SIZE, i.e.
+ * capture a couple of pointers or values, and be trivially copyable, which
+ * lambdas that capture by pointer, reference or plain value are.
+ */
 template<typename... ARGS>
-class Callback {
+class Delegate {
     public:
-        using call_type = std::function<void(ARGS...)>;
+        static constexpr size_t INLINE_SIZE { 2*sizeof(void*) };
 
-        void add(call_type cb)    { m_callbacks.push_back(cb); }
-        void remove(call_type cb) { m_callbacks.remove(m_callbacks.begin(), m_callbacks.end(), cb); }
+        Delegate() : m_invoke { nullptr } {}
+
+        template<typename FUNC, typename = std::enable_if_t<!std::is_same_v<std::decay_t<FUNC>, Delegate>>>
+        Delegate(FUNC &&func)
+        {
+            using func_type = std::decay_t<FUNC>;
+            static_assert(sizeof(func_type)<=INLINE_SIZE, "Callback captures too much, capture a pointer to it instead");
+            static_assert(alignof(func_type)<=alignof(storage_type), "Callback alignment too large");
+            static_assert(std::is_trivially_copyable_v<func_type> && std::is_trivially_destructible_v<func_type>, "Callback must be trivially copyable");
+
+            new (&m_storage) func_type(std::forward<FUNC>(func));
+            m_invoke = [](const void *storage, ARGS... args) {
+                (*static_cast<const func_type*>(storage))(args...);
+            };
+        }
+
+        explicit operator bool() const { return m_invoke!=nullptr; }
 
         void operator ()(ARGS ... args) const
         {
-            for (auto cb : m_callbacks) {
-                cb(std::forward<ARGS>(args)...);
+            m_invoke(&m_storage, args...);
+        }
+
+    private:
+        using storage_type = std::aligned_storage_t<INLINE_SIZE, alignof(void*)>;
+        using invoke_type = void (*)(const void*, ARGS...);
+
+        storage_type m_storage;
+        invoke_type m_invoke;
+};
+
+
+/**
+ * @brief Fixed size list of callbacks, called in the order they were added
+ *
+ * No heap, and calling the list doesn't copy the callbacks, so it can be used
+ * on the sensor and radio paths.
+ */
+template<size_t CAPACITY, typename... ARGS>
+class CallbackList {
+    public:
+        using call_type = Delegate<ARGS...>;
+
+        CallbackList() : m_count { 0 } {}
+
+        bool add(call_type cb)
+        {
+            assert(m_count<CAPACITY);
+            if (m_count>=CAPACITY) {
+                return false;
+            }
+            m_callbacks[m_count++] = cb;
+            return true;
+        }
+        void clear() { m_count = 0; }
+
+        size_t size() const { return m_count; }
+        bool empty() const { return m_count==0; }
+        static constexpr size_t capacity() { return CAPACITY; }
+
+        void operator ()(ARGS ... args) const
+        {
+            for (size_t n=0; n<m_count; ++n) {
+                m_callbacks[n](args...);
             }
         }
     private:
-        using callback_list = std::vector<call_type>;
-        callback_list m_callbacks;
+        std::array<call_type, CAPACITY> m_callbacks;
+        size_t m_count;
 };
 
+
+// Callbacks per list, a few listeners per sensor or receiver
+static constexpr size_t CALLBACK_CAPACITY { 4 };
+
+template<typename... ARGS>
+using Callback = CallbackList<CALLBACK_CAPACITY, ARGS...>;
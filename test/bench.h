@@ -0,0 +1,97 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Minimal helpers for host benchmarks
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <stdio.h>
+#include <pico/stdlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace Bench {
+
+    using clock_type = std::chrono::steady_clock;
+
+    /**
+     * @brief Keep the compiler from optimizing away a computed value
+     */
+    template<typename T>
+    static inline void keep(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    class Timer {
+        public:
+            Timer() : m_start { clock_type::now() } {}
+
+            void restart() { m_start = clock_type::now(); }
+
+            double elapsed_s() const
+            {
+                return std::chrono::duration<double>(clock_type::now()-m_start).count();
+            }
+            double elapsed_ns() const
+            {
+                return std::chrono::duration<double, std::nano>(clock_type::now()-m_start).count();
+            }
+
+        private:
+            clock_type::time_point m_start;
+    };
+
+
+    /**
+     * @brief Run func n times, and return the average time per call in ns
+     */
+    template<typename FUNC>
+    static double ns_per_call(size_t n, FUNC &&func)
+    {
+        Timer timer;
+        for (size_t i=0; i<n; ++i) {
+            func();
+        }
+        return timer.elapsed_ns()/n;
+    }
+
+
+    /**
+     * @brief Read the CPU cycle counter, or 0 where there is none
+     */
+    static inline uint64_t cycles()
+    {
+        #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+        #else
+        return 0;
+        #endif
+    }
+
+    /**
+     * @brief Run func n times, and return the average number of cycles per call
+     */
+    template<typename FUNC>
+    static double cycles_per_call(size_t n, FUNC &&func)
+    {
+        uint64_t start = cycles();
+        for (size_t i=0; i<n; ++i) {
+            func();
+        }
+        return static_cast<double>(cycles()-start)/n;
+    }
+
+
+    static inline void header(const char *title)
+    {
+        printf("\n%s\n", title);
+        printf("--------------------------------------------------------------------\n");
+    }
+
+}
@@ -0,0 +1,102 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Callback dispatch benchmark
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Dispatches to a few listeners, like the encoder, IMU and radio callbacks,
+ * through the inline CallbackList, and through the original vector of
+ * std::function, which copied each one on every call, and the same vector
+ * called by reference, to show what the copy costs on its own. libstdc++
+ * keeps the two word captures used here inline in the std::function, so the
+ * copy is a call to its manager, not a heap allocation; captures larger than
+ * that allocate on every copy.
+ */
+#include <vector>
+#include <functional>
+#include <stdio.h>
+#include <util/callback.h>
+
+#include "bench.h"
+
+static constexpr size_t N_CALLS { 10000000 };
+
+
+/**
+ * @brief The original Callback, copying every std::function on each call
+ */
+template<typename... ARGS>
+class ReferenceCallback {
+    public:
+        using call_type = std::function<void(ARGS...)>;
+
+        void add(call_type cb) { m_callbacks.push_back(cb); }
+
+        void call_by_value(ARGS ... args) const
+        {
+            for (auto cb : m_callbacks) {
+                cb(std::forward<ARGS>(args)...);
+            }
+        }
+        void call_by_reference(ARGS ... args) const
+        {
+            for (auto &cb : m_callbacks) {
+                cb(std::forward<ARGS>(args)...);
+            }
+        }
+    private:
+        std::vector<call_type> m_callbacks;
+};
+
+
+struct Listener {
+    float value { 0.0f };
+    uint count { 0 };
+};
+
+
+template<typename LIST>
+static void add_listeners(LIST &list, Listener *listeners, size_t n)
+{
+    for (size_t i=0; i<n; ++i) {
+        Listener *listener = &listeners[i];
+        list.add([listener, i](int32_t value, float rpm) {
+            listener->value += rpm*(i+1);
+            listener->count += value&1;
+        });
+    }
+}
+
+
+template<typename CALL>
+static void run(const char *name, CALL &&call)
+{
+    int32_t i = 0;
+    auto cycles = Bench::cycles_per_call(N_CALLS, [&]() { call(i, 0.5f*i); i++; });
+    i = 0;
+    auto ns = Bench::ns_per_call(N_CALLS, [&]() { call(i, 0.5f*i); i++; });
+    printf("%-28s %8.1f cycles/call   %8.2f ns/call\n", name, cycles, ns);
+}
+
+
+int main()
+{
+    for (size_t n : { 1, 2, 4 }) {
+        char title[64];
+        snprintf(title, sizeof(title), "Dispatch to %zu listener(s)", n);
+        Bench::header(title);
+
+        Listener listeners[4];
+        ReferenceCallback<int32_t, float> reference;
+        add_listeners(reference, listeners, n);
+        Callback<int32_t, float> callbacks;
+        add_listeners(callbacks, listeners, n);
+
+        run("std::function copy (original)", [&](int32_t v, float rpm) { reference.call_by_value(v, rpm); });
+        run("std::function reference", [&](int32_t v, float rpm) { reference.call_by_reference(v, rpm); });
+        run("CallbackList", [&](int32_t v, float rpm) { callbacks(v, rpm); });
+        Bench::keep(listeners);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @author Peter Christoffersen
+ * @brief ChannelValue conversion and mapping benchmark
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Compares the fixed point ChannelValue accessors and the servo pulse table
+ * with the original float and division conversions. The host has an FPU
+ * and a fast divider, so they come out about even here, and the clamping
+ * shows; on the RP2040 the float versions are soft float calls.
+ *
+ * Also compares the Taranis X9D Plus mapping table with the original hand
+ * written decode, per frame.
+ */
+#include <array>
+#include <random>
+#include <stdio.h>
+#include <fbus2/channels.h>
+#include <fbus2/mapping.h>
+
+#include "bench.h"
+#include "fbus2_reference.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+static constexpr size_t N_VALUES { 1024 };
+static constexpr size_t N_CALLS { 10000000 };
+
+
+template<typename CONVERT>
+static void run(const char *name, const std::array<ChannelValue, N_VALUES> &values, CONVERT &&convert)
+{
+    size_t i = 0;
+    auto cycles = Bench::cycles_per_call(N_CALLS, [&]() {
+        Bench::keep(convert(values[i++ % N_VALUES]));
+    });
+    i = 0;
+    auto ns = Bench::ns_per_call(N_CALLS, [&]() {
+        Bench::keep(convert(values[i++ % N_VALUES]));
+    });
+    printf("%-28s %8.1f cycles/call   %8.2f ns/call\n", name, cycles, ns);
+}
+
+
+int main()
+{
+    std::mt19937 rng { 1 };
+    std::uniform_int_distribution<uint> value { ChannelValue::CHANNEL_MIN, ChannelValue::CHANNEL_MAX };
+    std::array<ChannelValue, N_VALUES> values;
+    for (auto &v : values) {
+        v = static_cast<ChannelValue::raw_type>(value(rng));
+    }
+
+    Bench::header("ChannelValue - servo pulse");
+    run("division (original)", values, [](ChannelValue v) { return Stream::reference_servo_pulse(v.raw()); });
+    run("table", values, [](ChannelValue v) { return v.asServoPulse(); });
+
+    Bench::header("ChannelValue - signed -1..1");
+    run("asFloat", values, [](ChannelValue v) { return v.asFloat(); });
+    run("asQ15", values, [](ChannelValue v) { return v.asQ15(); });
+
+    Bench::header("ChannelValue - unsigned 0..1");
+    run("asPercent", values, [](ChannelValue v) { return v.asPercent(); });
+    run("asUQ16", values, [](ChannelValue v) { return v.asUQ16(); });
+
+    // Frames with every channel, switches included, somewhere in the range
+    std::array<Channels, N_VALUES> frames;
+    for (size_t i=0; i<N_VALUES; ++i) {
+        for (size_t n=0; n<frames[i].count(); ++n) {
+            frames[i].set_channel(n, values[(i+n*37) % N_VALUES].raw());
+        }
+    }
+    Bench::header("Mapping - Taranis X9D Plus decode per frame");
+    Stream::ReferenceTaranisX9DPlus reference;
+    TaranisX9DPlus mapping;
+    size_t frame = 0;
+    run("hand written (original)", values, [&](ChannelValue) { reference.set(frames[frame++ % N_VALUES]); return reference.sf; });
+    frame = 0;
+    run("mapping table", values, [&](ChannelValue) { mapping.set(frames[frame++ % N_VALUES]); return mapping.sf(); });
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+/**
+ * @author Peter Christoffersen
+ * @brief FBus2 receive buffer benchmark
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Runs the receiver frame walk (sync, control, downlink, uplink) over a
+ * synthetic stream, with the old linear scratch buffer that shifts data down
+ * after every pop, and the ring window that is parsed in place.
+ */
+#include <string.h>
+#include <stdio.h>
+#include <fbus2/channels.h>
+#include <fbus2/ringbuffer.h>
+
+#include "bench.h"
+#include "fbus2_stream.h"
+
+using namespace FBus2;
+
+static constexpr size_t WINDOW_SIZE { 64u };
+
+/**
+ * @brief Source feeding bytes from memory, like the stream buffer does
+ */
+class Source {
+    public:
+        Source(const Test::stream_type &stream) : m_stream { stream }, m_pos { 0 } {}
+
+        size_t read(uint8_t *dst, size_t len)
+        {
+            len = std::min(len, m_stream.size()-m_pos);
+            memcpy(dst, m_stream.data()+m_pos, len);
+            m_pos += len;
+            return len;
+        }
+
+    private:
+        const Test::stream_type &m_stream;
+        size_t m_pos;
+};
+
+
+/**
+ * @brief The previous linear scratch buffer
+ */
+class ScratchBuffer {
+    public:
+        ScratchBuffer(Source &source) : m_source { source }, m_size { 0 } {}
+
+        bool recv(size_t bytes)
+        {
+            while (m_size<bytes) {
+                auto res = m_source.read(m_data+m_size, bytes-m_size);
+                if (res==0) return false;
+                m_size += res;
+            }
+            return true;
+        }
+        void pop(size_t bytes)
+        {
+            for (size_t i=bytes; i<m_size; ++i) {
+                m_data[i-bytes] = m_data[i];
+            }
+            m_size -= bytes;
+        }
+        uint8_t operator[](size_t n) const { return m_data[n]; }
+
+    private:
+        Source &m_source;
+        uint8_t m_data[WINDOW_SIZE];
+        size_t m_size;
+};
+
+
+/**
+ * @brief Ring window parsed in place
+ */
+class WindowBuffer {
+    public:
+        WindowBuffer(Source &source) : m_source { source }, m_view { m_window.view() } {}
+
+        bool recv(size_t bytes)
+        {
+            while (m_window.size()<bytes) {
+                uint8_t *ptr;
+                auto span = m_window.write_span(ptr);
+                auto res = m_source.read(ptr, span);
+                if (res==0) return false;
+                m_window.commit(res);
+            }
+            return true;
+        }
+        void pop(size_t bytes) { m_window.pop(bytes); m_view = m_window.view(); }
+        uint8_t operator[](size_t n) const { return m_view[n]; }
+
+    private:
+        using window_type = RingBuffer<uint8_t, WINDOW_SIZE>;
+        Source &m_source;
+        window_type m_window;
+        window_type::View m_view;
+};
+
+
+/**
+ * @brief The receiver frame walk on top of a buffer strategy
+ */
+template<typename BUFFER>
+class Walker {
+    public:
+        Walker(Source &source) : m_buffer { source }, m_state { SYNCING }, m_frames { 0 }, m_syncs { 0 } {}
+
+        void run()
+        {
+            bool more = true;
+            while (more) {
+                switch (m_state) {
+                    case SYNCING:       more = do_sync(); break;
+                    case READ_CONTROL:  more = do_read_control(); break;
+                    case READ_DOWNLINK: more = do_read_downlink(); break;
+                    case READ_UPLINK:   more = do_read_uplink(); break;
+                }
+            }
+        }
+
+        uint frames() const { return m_frames; }
+        uint syncs() const { return m_syncs; }
+        const Channels &channels() const { return m_channels; }
+
+    private:
+        enum State { SYNCING, READ_CONTROL, READ_DOWNLINK, READ_UPLINK };
+
+        BUFFER m_buffer;
+        State m_state;
+        uint m_frames;
+        uint m_syncs;
+        Channels m_channels;
+
+        void begin_sync() { m_state = SYNCING; m_syncs++; }
+
+        bool do_sync()
+        {
+            if (!m_buffer.recv(2)) return false;
+            if (m_buffer[1]!=FBUS_CONTROL_HDR) {
+                m_buffer.pop(1);
+                return true;
+            }
+            if (!fbus_control_size_valid(m_buffer[0])) {
+                m_buffer.pop(2);
+                return true;
+            }
+            if (!m_buffer.recv(fbus_control_size(m_buffer))) return false;
+            if (fbus_checksum(m_buffer, FBUS_CONTROL_HDR_SIZE, m_buffer[0])!=fbus_control_crc(m_buffer)) {
+                m_buffer.pop(2);
+                return true;
+            }
+            m_state = READ_CONTROL;
+            return true;
+        }
+
+        bool do_read_control()
+        {
+            if (!m_buffer.recv(FBUS_CONTROL_HDR_SIZE)) return false;
+            if (m_buffer[1]!=FBUS_CONTROL_HDR || !fbus_control_size_valid(m_buffer[0])) {
+                begin_sync();
+                return true;
+            }
+            size_t size = fbus_control_size(m_buffer);
+            if (!m_buffer.recv(size)) return false;
+            if (fbus_checksum(m_buffer, FBUS_CONTROL_HDR_SIZE, m_buffer[0])!=fbus_control_crc(m_buffer)) {
+                begin_sync();
+                return true;
+            }
+            size_t count = fbus_control_channel_count(m_buffer[0]);
+            m_channels.set_count(count);
+            fbus_control_channels<ChannelValue::raw_type>(m_buffer, m_channels);
+            m_buffer.pop(size);
+            m_frames++;
+            m_state = READ_DOWNLINK;
+            return true;
+        }
+
+        bool do_read_downlink()
+        {
+            if (!m_buffer.recv(FBUS_DOWNLINK_SIZE)) return false;
+            if (m_buffer[0]!=FBUS_DOWNLINK_HDR || fbus_checksum(m_buffer, FBUS_DOWNLINK_HDR_SIZE, m_buffer[0])!=fbus_downlink_crc(m_buffer)) {
+                begin_sync();
+                return true;
+            }
+            m_buffer.pop(FBUS_DOWNLINK_SIZE);
+            m_frames++;
+            m_state = READ_UPLINK;
+            return true;
+        }
+
+        bool do_read_uplink()
+        {
+            if (!m_buffer.recv(FBUS_UPLINK_HDR_SIZE)) return false;
+            if (m_buffer[0]!=FBUS_UPLINK_HDR) {
+                m_state = READ_CONTROL;
+                return true;
+            }
+            if (!m_buffer.recv(FBUS_UPLINK_SIZE)) return false;
+            if (fbus_checksum(m_buffer, FBUS_UPLINK_HDR_SIZE, m_buffer[0])!=fbus_uplink_crc(m_buffer)) {
+                begin_sync();
+                return true;
+            }
+            m_buffer.pop(FBUS_UPLINK_SIZE);
+            m_frames++;
+            m_state = READ_CONTROL;
+            return true;
+        }
+};
+
+
+template<typename BUFFER>
+static void run(const char *name, const Test::stream_type &stream, uint repeat)
+{
+    uint frames = 0;
+    uint syncs = 0;
+
+    Bench::Timer timer;
+    for (uint i=0; i<repeat; ++i) {
+        Source source { stream };
+        Walker<BUFFER> walker { source };
+        walker.run();
+        frames += walker.frames();
+        syncs += walker.syncs();
+        Bench::keep(walker.channels());
+    }
+    auto elapsed = timer.elapsed_s();
+
+    double bytes = static_cast<double>(stream.size())*repeat;
+    printf("%-10s %10.2f MB/s   %10.0f frames/s   resyncs=%u\n", name, bytes/elapsed/1.0e6, frames/elapsed, syncs/repeat);
+}
+
+
+int main()
+{
+    constexpr uint CYCLES { 20000 };
+    constexpr uint REPEAT { 20 };
+
+    auto clean = Test::make_stream(CYCLES, 16);
+    auto noisy = clean;
+    Test::corrupt(noisy, 0.10);
+
+    Bench::header("FBus2 parser - clean stream");
+    run<ScratchBuffer>("scratch", clean, REPEAT);
+    run<WindowBuffer>("window", clean, REPEAT);
+
+    Bench::header("FBus2 parser - 10% corrupted bytes");
+    run<ScratchBuffer>("scratch", noisy, REPEAT);
+    run<WindowBuffer>("window", noisy, REPEAT);
+
+    return 0;
+}
@@ -0,0 +1,416 @@
+/**
+ * @author Peter Christoffersen
+ * @brief FBus2 receiver benchmark
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Runs the real receiver state machine (through ReceiverHost) over synthetic
+ * streams, and measures the throughput, how long it takes to get back in
+ * sync after a burst of noise on the line, and how many uplinks go out past
+ * the window when the telemetry provider competes with a busy sensor. The SBUS
+ * and FPort engines are run for throughput too, and the callback CPU time
+ * with and without the change mask, at rest and in motion.
+ *
+ * Also replays a recorded log (see Recorder), given as the first argument,
+ * or a recording of a noisy synthetic stream.
+ */
+#include <random>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <math.h>
+#include <stdio.h>
+#include <fbus2/receiver_host.h>
+#include <fbus2/protocol_sbus.h>
+#include <fbus2/protocol_fport.h>
+#include <fbus2/telemetry_cache.h>
+#include <fbus2/recorder.h>
+
+#include "bench.h"
+#include "fbus2_stream.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+static constexpr uint BAUDRATE { 460800 };
+static constexpr double US_PER_BYTE { 10.0e6/BAUDRATE }; // 8N1
+
+
+template<typename receiver_type=ReceiverHost>
+static void throughput(const char *name, const Stream::stream_type &stream, uint repeat, const LineConfig &line=BAUDRATE)
+{
+    uint frames = 0;
+    uint steps = 0;
+
+    Bench::Timer timer;
+    for (uint i=0; i<repeat; ++i) {
+        receiver_type rx { line };
+        rx.init();
+        rx.feed(stream);
+        frames += rx.n_control_packets();
+        steps += rx.n_steps();
+        Bench::keep(rx.channels());
+    }
+    auto elapsed = timer.elapsed_s();
+
+    double bytes = static_cast<double>(stream.size())*repeat;
+    double line_bytes_s = static_cast<double>(line.baudrate)/line.bits_per_char();
+    printf("%-12s %10.2f MB/s   %10.0f control/s   steps/byte=%.2f   %6.0fx line rate\n", name, bytes/elapsed/1.0e6, frames/elapsed, steps/bytes, bytes/elapsed/line_bytes_s);
+}
+
+
+/**
+ * @brief Measure bytes from the end of a noise burst until the next control package is accepted
+ */
+static void resync(size_t burst, uint trials)
+{
+    std::mt19937 rng { 1234 };
+    std::uniform_int_distribution<int> value { 0, 0xFF };
+
+    size_t total_bytes = 0;
+    size_t max_bytes = 0;
+    uint failed = 0;
+    double total_ns = 0.0;
+    int64_t total_wakeups = 0;
+    int64_t max_wakeups = 0;
+
+    for (uint t=0; t<trials; ++t) {
+        ReceiverHost rx { BAUDRATE };
+        rx.init();
+        rx.feed(Stream::make_stream(10));
+        rx.reset_stats();
+
+        Stream::stream_type noise(burst);
+        for (auto &b : noise) {
+            b = value(rng);
+        }
+        rx.feed(noise);
+
+        // Clean data starting at a random offset into a cycle, like after a dropout
+        auto clean = Stream::make_stream(20);
+        size_t offset = value(rng) % 45;
+
+        auto control_packets = rx.n_control_packets();
+        size_t bytes = 0;
+        Bench::Timer timer;
+        for (size_t i=offset; i<clean.size() && rx.n_control_packets()==control_packets; ++i) {
+            rx.feed(&clean[i], 1);
+            bytes++;
+        }
+        total_ns += timer.elapsed_ns();
+
+        if (rx.n_control_packets()==control_packets) {
+            failed++;
+        }
+        total_bytes += bytes;
+        max_bytes = std::max(max_bytes, bytes);
+
+        // Receives from the stream buffer while syncing, each one a task wakeup on the target
+        int64_t wakeups = rx.stats().sync_wakeups().sum();
+        total_wakeups += wakeups;
+        max_wakeups = std::max(max_wakeups, wakeups);
+    }
+
+    double avg = static_cast<double>(total_bytes)/trials;
+    printf("burst=%-5zu  avg=%6.1f bytes (%7.1f us on the line)   max=%4zu bytes   cpu=%6.0f ns   wakeups avg=%5.1f max=%3lld   failed=%u\n",
+        burst, avg, avg*US_PER_BYTE, max_bytes, total_ns/trials, static_cast<double>(total_wakeups)/trials, max_wakeups, failed);
+}
+
+
+/**
+ * @brief Sensor task stand-in, that holds its lock during each (I2C) read
+ */
+class BusySensor {
+    public:
+        static constexpr auto PERIOD { std::chrono::microseconds(5000) };
+        static constexpr auto BUSY { std::chrono::microseconds(3000) };
+
+        std::mutex m_lock;
+        float m_heading { 0.0f };
+        TelemetryCache<1> m_cache;
+
+        BusySensor() : m_thread { [this]() { run(); } } {}
+        ~BusySensor() { m_stop = true; m_thread.join(); }
+
+    private:
+        std::atomic<bool> m_stop { false };
+        std::thread m_thread;
+
+        void run()
+        {
+            while (!m_stop) {
+                float heading;
+                {
+                    std::lock_guard<std::mutex> guard { m_lock };
+                    std::this_thread::sleep_for(BUSY);
+                    m_heading += 0.01f;
+                    heading = m_heading;
+                }
+                // Producer side of the cache, encoded outside the uplink path
+                m_cache.store(0, Telemetry::diy(0, heading*180.0f/static_cast<float>(M_PI)));
+                std::this_thread::sleep_for(PERIOD-BUSY);
+            }
+        }
+};
+
+
+/**
+ * @brief Receiver with a provider that either reads the sensor directly, or the cache
+ */
+class UplinkReceiver : public ReceiverHost {
+    public:
+        UplinkReceiver(BusySensor &sensor, bool cached) : m_sensor { sensor }, m_cached { cached } {}
+
+        uint n_late() const { return m_late; }
+        int64_t max_send_delay_us() const { return m_max_send_delay_us; }
+
+    protected:
+        virtual Telemetry get_next_telemetry(uint8_t sensor_id) override
+        {
+            auto start = get_absolute_time();
+            Telemetry value = fetch();
+            // Called once the window check has passed, so the provider time comes on top
+            int64_t delay = uplink_latency_us()+absolute_time_diff_us(start, get_absolute_time());
+            m_max_send_delay_us = std::max(m_max_send_delay_us, delay);
+            if (delay>FBUS_UPLINK_SEND_DELAY_MAX_US) {
+                m_late++;
+            }
+            return value;
+        }
+
+    private:
+        BusySensor &m_sensor;
+        const bool m_cached;
+        uint m_late { 0 };
+        int64_t m_max_send_delay_us { 0 };
+
+        Telemetry fetch()
+        {
+            if (m_cached) {
+                return m_sensor.m_cache.load(0);
+            }
+            std::lock_guard<std::mutex> guard { m_sensor.m_lock };
+            return Telemetry::diy(0, m_sensor.m_heading*180.0f/static_cast<float>(M_PI));
+        }
+};
+
+
+static void uplink_load(const char *name, bool cached, uint cycles)
+{
+    BusySensor sensor;
+    UplinkReceiver rx { sensor, cached };
+    rx.init();
+
+    std::array<uint16_t, 16> values;
+    values.fill(ChannelValue::CHANNEL_CENTER);
+    Stream::stream_type cycle;
+    Stream::append_control(cycle, values.size(), values.data());
+    Stream::append_downlink(cycle, Receiver::RECEIVER_ID);
+
+    for (uint i=0; i<cycles; ++i) {
+        rx.feed(cycle);
+        std::this_thread::sleep_for(std::chrono::microseconds(1000));
+    }
+
+    uint slots = rx.n_telemetry_sent()+rx.n_telemetry_skipped();
+    printf("%-8s slots=%5u   late=%5u (%5.1f%%)   max send delay=%6lld us\n",
+        name, slots, rx.n_late(), 100.0*rx.n_late()/slots, static_cast<long long>(rx.max_send_delay_us()));
+}
+
+
+/**
+ * @brief Receiver with a callback doing about what the drive callback does
+ *
+ * Either on every frame, or only on the frames where the change mask says
+ * something moved beyond the deadband.
+ */
+class CallbackReceiver : public ReceiverHost {
+    public:
+        CallbackReceiver(bool masked) : m_masked { masked } {}
+
+        double callback_s() const { return m_callback_s; }
+        uint n_callbacks() const { return m_callbacks; }
+
+    protected:
+        virtual void on_data(const channels_type &channels, ChangeMask changes) override
+        {
+            ReceiverHost::on_data(channels, changes);
+            if (m_masked && changes.none()) return;
+
+            Bench::Timer timer;
+            float x = channels[0].asFloat();
+            float y = channels[1].asFloat();
+            float speed = sqrtf(x*x+y*y);
+            float angle = atan2f(y, x);
+            for (uint wheel=0; wheel<6; ++wheel) {
+                std::lock_guard<std::mutex> guard { m_lock };
+                m_wheels[wheel] = speed*sinf(angle+wheel*static_cast<float>(M_PI)/3.0f);
+            }
+            Bench::keep(m_wheels);
+            m_callback_s += timer.elapsed_s();
+            m_callbacks++;
+        }
+
+    private:
+        const bool m_masked;
+        std::mutex m_lock;
+        float m_wheels[6] {};
+        double m_callback_s { 0.0 };
+        uint m_callbacks { 0 };
+};
+
+
+/**
+ * @brief Callback CPU time per second of radio traffic, at the FBus2 frame period
+ */
+static void callback_load(const char *name, bool moving, uint cycles)
+{
+    constexpr double FRAME_PERIOD_S { 0.009 };
+
+    std::mt19937 rng { 1234 };
+    std::uniform_int_distribution<int> jitter { -1, 1 };
+    std::array<uint16_t, 16> values;
+    Stream::stream_type stream;
+    for (uint i=0; i<cycles; ++i) {
+        values.fill(ChannelValue::CHANNEL_CENTER);
+        for (uint n=0; n<4; ++n) {
+            // Sticks sweep in motion, otherwise a bit of noise around center
+            int offset = moving ? static_cast<int>(600.0*sin(i*0.01+n)) : 0;
+            values[n] = static_cast<uint16_t>(ChannelValue::CHANNEL_CENTER+offset+jitter(rng));
+        }
+        Stream::append_control(stream, values.size(), values.data());
+    }
+
+    double simulated_s = cycles*FRAME_PERIOD_S;
+    for (bool masked : { false, true }) {
+        CallbackReceiver rx { masked };
+        rx.init();
+        rx.feed(stream);
+        printf("%-8s %-10s callbacks=%6u/%6u   %8.1f us/s\n",
+            name, masked ? "masked" : "always", rx.n_callbacks(), rx.n_data(), rx.callback_s()*1.0e6/simulated_s);
+    }
+}
+
+
+/**
+ * @brief Record a stream fed at the line rate in ISR sized chunks
+ */
+static std::vector<uint8_t> record(const Stream::stream_type &stream)
+{
+    constexpr size_t CHUNK { 16 }; // Half the UART FIFO
+    static StaticRecorder<2*1024*1024> recorder { BAUDRATE };
+    recorder.clear();
+
+    ReceiverHost rx { BAUDRATE };
+    rx.set_recorder(&recorder);
+    rx.init();
+
+    absolute_time_t time = from_us_since_boot(1000000);
+    for (size_t pos=0; pos<stream.size(); pos+=CHUNK) {
+        size_t len = std::min(CHUNK, stream.size()-pos);
+        time = delayed_by_us(time, static_cast<uint64_t>(len*US_PER_BYTE));
+        rx.feed(stream.data()+pos, len, time);
+    }
+
+    std::vector<uint8_t> log;
+    recorder.dump([&](const uint8_t *data, size_t len) { log.insert(log.end(), data, data+len); });
+    return log;
+}
+
+
+static void replay(const char *name, const std::vector<uint8_t> &log, uint repeat)
+{
+    RecordReader reader { log.data(), log.size() };
+    if (!reader.valid()) {
+        printf("%-12s not a recorder log\n", name);
+        return;
+    }
+
+    // Length of the recording
+    RecordReader::Entry entry;
+    absolute_time_t end = reader.start();
+    while (reader.next(entry)) {
+        end = entry.time;
+    }
+    double recorded_s = absolute_time_diff_us(reader.start(), end)/1.0e6;
+
+    size_t bytes = 0;
+    uint frames = 0;
+    uint syncs = 0;
+    uint crc_failures = 0;
+    Bench::Timer timer;
+    for (uint i=0; i<repeat; ++i) {
+        ReceiverHost rx { reader.baudrate() };
+        rx.init();
+        bytes += rx.replay(RecordReader { log.data(), log.size() });
+        frames = rx.n_control_packets();
+        syncs = rx.stats().sync().count();
+        crc_failures = rx.stats().crc_failures(FrameType::CONTROL);
+        Bench::keep(rx.channels());
+    }
+    auto elapsed = timer.elapsed_s()/repeat;
+
+    printf("%-12s %10.2f MB/s   %8.0fx real time   log=%zu bytes (%.1f s)   control=%u  syncs=%u  crc failures=%u\n",
+        name, bytes/repeat/elapsed/1.0e6, recorded_s/elapsed, log.size(), recorded_s, frames, syncs, crc_failures);
+}
+
+
+int main(int argc, char **argv)
+{
+    constexpr uint CYCLES { 20000 };
+    constexpr uint REPEAT { 10 };
+
+    auto clean = Stream::make_stream(CYCLES, 16);
+    auto noisy = clean;
+    Stream::corrupt(noisy, 0.01);
+    auto bad = clean;
+    Stream::corrupt(bad, 0.10);
+
+    Bench::header("FBus2 receiver - throughput");
+    throughput("clean", clean, REPEAT);
+    throughput("1% noise", noisy, REPEAT);
+    throughput("10% noise", bad, REPEAT);
+    throughput("24 channels", Stream::make_stream(CYCLES, 24), REPEAT);
+
+    Bench::header("Protocols - parse throughput");
+    auto sbus = Stream::make_sbus_stream(CYCLES);
+    auto sbus_noisy = sbus;
+    Stream::corrupt(sbus_noisy, 0.01);
+    auto fport = Stream::make_fport_stream(CYCLES);
+    auto fport_noisy = fport;
+    Stream::corrupt(fport_noisy, 0.01);
+    throughput("FBus2", clean, REPEAT, FBus2Protocol::LINE);
+    throughput<ProtocolReceiverHost<SBusProtocol>>("SBUS", sbus, REPEAT, SBusProtocol::LINE);
+    throughput<ProtocolReceiverHost<SBusProtocol>>("SBUS 1%", sbus_noisy, REPEAT, SBusProtocol::LINE);
+    throughput<ProtocolReceiverHost<FPortProtocol>>("FPort", fport, REPEAT, FPortProtocol::LINE);
+    throughput<ProtocolReceiverHost<FPortProtocol>>("FPort 1%", fport_noisy, REPEAT, FPortProtocol::LINE);
+
+    Bench::header("FBus2 receiver - resync after noise burst");
+    for (size_t burst : { 1u, 10u, 100u, 1000u }) {
+        resync(burst, 1000);
+    }
+
+    Bench::header("FBus2 receiver - uplink slots with a busy sensor");
+    uplink_load("locked", false, 1000);
+    uplink_load("cached", true, 1000);
+
+    Bench::header("FBus2 receiver - callback load with a change mask");
+    callback_load("at rest", false, CYCLES);
+    callback_load("moving", true, CYCLES);
+
+    Bench::header("FBus2 receiver - replay of a recorded log");
+    if (argc>1) {
+        std::ifstream file { argv[1], std::ios::binary };
+        std::vector<uint8_t> log { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        replay(argv[1], log, REPEAT);
+    }
+    else {
+        replay("1% noise", record(noisy), REPEAT);
+    }
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @author Peter Christoffersen
+ * @brief RingBuffer benchmark
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Moves bytes through the lock free RingBuffer, in chunks of different
+ * sizes, with per element push/pop, bulk push/pop, and the span API, and
+ * compares with a FreeRTOS stream buffer used the same way, with
+ * xStreamBufferSend()/xStreamBufferReceive() and no timeout. The stream
+ * buffer takes a critical section and checks for a task to notify on every
+ * call, so the difference is largest for small chunks.
+ */
+#include <array>
+#include <stdio.h>
+#include <FreeRTOS.h>
+#include <stream_buffer.h>
+#include <fbus2/ringbuffer.h>
+
+#include "bench.h"
+
+using namespace FBus2;
+
+static constexpr size_t BUFFER_SIZE { 256 };
+static constexpr size_t N_BYTES { 50000000 };
+
+using ring_type = RingBuffer<uint8_t, BUFFER_SIZE>;
+
+
+/**
+ * @brief Time moving N_BYTES through a buffer, transfer(len) moves one chunk in and out
+ */
+template<typename TRANSFER>
+static void run(const char *name, size_t chunk, TRANSFER &&transfer)
+{
+    size_t calls = N_BYTES/chunk;
+    auto cycles = Bench::cycles_per_call(calls, [&]() { transfer(chunk); });
+    auto ns = Bench::ns_per_call(calls, [&]() { transfer(chunk); });
+    printf("%-28s %8.1f cycles/byte  %8.2f ns/byte\n", name, cycles/chunk, ns/chunk);
+}
+
+
+int main()
+{
+    std::array<uint8_t, BUFFER_SIZE> in;
+    std::array<uint8_t, BUFFER_SIZE> out;
+    for (size_t n=0; n<in.size(); ++n) {
+        in[n] = n;
+    }
+
+    // One byte more, FreeRTOS keeps one free to tell full from empty
+    static uint8_t stream_data[BUFFER_SIZE+1];
+    static StaticStreamBuffer_t stream_buf;
+    StreamBufferHandle_t stream = xStreamBufferCreateStatic(BUFFER_SIZE, 1, stream_data, &stream_buf);
+    static ring_type ring;
+
+    for (size_t chunk : { 1, 8, 32 }) {
+        char title[64];
+        snprintf(title, sizeof(title), "%zu byte chunks", chunk);
+        Bench::header(title);
+
+        run("xStreamBufferSend/Receive", chunk, [&](size_t len) {
+            xStreamBufferSend(stream, in.data(), len, 0);
+            Bench::keep(xStreamBufferReceive(stream, out.data(), len, 0));
+        });
+
+        run("RingBuffer push/pop each", chunk, [&](size_t len) {
+            for (size_t n=0; n<len; ++n) {
+                ring.push(in[n]);
+            }
+            for (size_t n=0; n<len; ++n) {
+                out[n] = ring.pop();
+            }
+            Bench::keep(out);
+        });
+
+        run("RingBuffer bulk push/pop", chunk, [&](size_t len) {
+            ring.push(in.data(), len);
+            Bench::keep(ring.pop(out.data(), len));
+        });
+
+        run("RingBuffer spans", chunk, [&](size_t len) {
+            // Written and read in place, in up to two spans across the wrap
+            size_t done = 0;
+            while (done<len) {
+                uint8_t *wptr;
+                size_t n = std::min(ring.write_span(wptr), len-done);
+                std::copy(&in[done], &in[done]+n, wptr);
+                ring.commit(n);
+                done += n;
+            }
+            done = 0;
+            while (done<len) {
+                const uint8_t *rptr;
+                size_t n = std::min(ring.read_span(rptr), len-done);
+                std::copy(rptr, rptr+n, &out[done]);
+                ring.pop(n);
+                done += n;
+            }
+            Bench::keep(out);
+        });
+    }
+    return 0;
+}
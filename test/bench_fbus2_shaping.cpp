@@ -0,0 +1,98 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Stick shaping benchmark
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Cost per frame of the fixed point shaping chain on the sticks, against
+ * the same deadband, expo, rate limit and low-pass done in float the way
+ * a callback would do it, and the cost of each stage on its own.
+ */
+#include <array>
+#include <random>
+#include <math.h>
+#include <stdio.h>
+#include <fbus2/shaping.h>
+
+#include "bench.h"
+
+using namespace FBus2;
+using namespace FBus2::Shaping;
+
+static constexpr size_t N_FRAMES { 256 };
+static constexpr size_t N_CALLS { 2000000 };
+static constexpr ChangeMask::value_type STICKS { 0b1111 };
+
+
+/**
+ * @brief Float version of the chain, for comparison
+ */
+class FloatShaper {
+    public:
+        void shape(Channels &channels)
+        {
+            for (size_t n=0; n<4; ++n) {
+                float x = channels[n].asFloat();
+                float band = 10.0f/HALF_RANGE;
+                x = fabsf(x)<=band ? 0.0f : (x-copysignf(band, x))/(1.0f-band);
+                x = 0.7f*x+0.3f*x*x*x;
+                x = std::clamp(x, m_last[n]-0.1f, m_last[n]+0.1f);
+                m_last[n] = x;
+                m_filtered[n] += (x-m_filtered[n])*0.25f;
+                channels.set_channel(n, static_cast<ChannelValue::raw_type>(ChannelValue::CHANNEL_CENTER+lrintf(m_filtered[n]*HALF_RANGE)));
+            }
+        }
+
+    private:
+        float m_last[4] {};
+        float m_filtered[4] {};
+};
+
+
+template<typename SHAPER>
+static void run(const char *name, const std::array<Channels, N_FRAMES> &frames, SHAPER &&shaper)
+{
+    Channels channels;
+    size_t i = 0;
+
+    auto cycles = Bench::cycles_per_call(N_CALLS, [&]() {
+        channels = frames[i++ % N_FRAMES];
+        shaper.shape(channels);
+        Bench::keep(channels);
+    });
+    i = 0;
+    auto ns = Bench::ns_per_call(N_CALLS, [&]() {
+        channels = frames[i++ % N_FRAMES];
+        shaper.shape(channels);
+        Bench::keep(channels);
+    });
+    printf("%-28s %8.1f cycles/frame   %8.2f ns/frame\n", name, cycles, ns);
+}
+
+
+int main()
+{
+    std::mt19937 rng { 1 };
+    std::uniform_int_distribution<int> jitter { -3, 3 };
+
+    // Sticks sweeping, with a bit of noise
+    std::array<Channels, N_FRAMES> frames;
+    for (size_t i=0; i<N_FRAMES; ++i) {
+        frames[i].set_sync(true);
+        for (size_t n=0; n<frames[i].count(); ++n) {
+            int value = ChannelValue::CHANNEL_CENTER+static_cast<int>(900.0*sin(i*0.05+n))+jitter(rng);
+            frames[i].set_channel(n, static_cast<ChannelValue::raw_type>(value));
+        }
+    }
+
+    Bench::header("Stick shaping - 4 channels per frame");
+    run("deadband", frames, ChannelFilter<STICKS, Deadband<10>> {});
+    run("expo", frames, ChannelFilter<STICKS, Expo<30>> {});
+    run("rate limit", frames, ChannelFilter<STICKS, RateLimit<98>> {});
+    run("low-pass", frames, ChannelFilter<STICKS, LowPass<2>> {});
+    run("fixed point chain", frames, ChannelFilter<STICKS, Deadband<10>, Expo<30>, RateLimit<98>, LowPass<2>> {});
+    run("float chain", frames, FloatShaper {});
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @author Peter Christoffersen
+ * @brief FBus2 channel unpacker benchmark
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Compares the generic compile time channel unpacker with the original hand
+ * unrolled 8 channel decoder, from a linear buffer and from the ring window.
+ */
+#include <array>
+#include <vector>
+#include <random>
+#include <stdio.h>
+#include <fbus2/channels.h>
+#include <fbus2/ringbuffer.h>
+
+#include "bench.h"
+#include "fbus2_stream.h"
+#include "fbus2_reference.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+static constexpr size_t N_FRAMES { 256 };
+static constexpr size_t N_CALLS { 2000000 };
+
+
+template<typename FRAMES, typename DECODE>
+static void run(const char *name, const FRAMES &frames, DECODE &&decode)
+{
+    Channels channels;
+    channels.set_count(Channels::MAX_CHANNELS);
+    size_t i = 0;
+
+    auto cycles = Bench::cycles_per_call(N_CALLS, [&]() {
+        decode(frames[i++ % N_FRAMES], channels);
+        Bench::keep(channels);
+    });
+    i = 0;
+    auto ns = Bench::ns_per_call(N_CALLS, [&]() {
+        decode(frames[i++ % N_FRAMES], channels);
+        Bench::keep(channels);
+    });
+    printf("%-28s %8.1f cycles/frame   %8.2f ns/frame\n", name, cycles, ns);
+}
+
+
+int main()
+{
+    std::mt19937 rng { 1 };
+    std::uniform_int_distribution<uint16_t> value { 0, FBUS_CHANNEL_MASK };
+
+    for (size_t nchannels : { 8u, 16u, 24u }) {
+        // Linear frames
+        std::array<Stream::stream_type, N_FRAMES> frames;
+        for (auto &frame : frames) {
+            std::array<uint16_t, 24> values;
+            for (auto &v : values) v = value(rng);
+            Stream::append_control(frame, nchannels, values.data());
+        }
+
+        // Same frames in a ring window, at varying offsets so some wrap
+        using window_type = RingBuffer<uint8_t, 64>;
+        std::array<window_type, N_FRAMES> windows;
+        std::vector<window_type::View> views;
+        for (size_t i=0; i<N_FRAMES; ++i) {
+            Stream::stream_type pad(i % 64);
+            windows[i].push(pad.data(), pad.size());
+            windows[i].pop(pad.size());
+            windows[i].push(frames[i].data(), frames[i].size());
+            views.push_back(windows[i].view());
+        }
+
+        char title[64];
+        snprintf(title, sizeof(title), "FBus2 unpack - %zu channels", nchannels);
+        Bench::header(title);
+
+        run("reference (linear)", frames, [nchannels](const auto &frame, Channels &channels) {
+            Stream::reference_control_channels<ChannelValue::raw_type>(frame, nchannels, channels);
+        });
+        run("unpack (linear)", frames, [](const auto &frame, Channels &channels) {
+            fbus_control_channels<ChannelValue::raw_type>(frame, channels);
+        });
+        run("reference (ring window)", views, [nchannels](const auto &frame, Channels &channels) {
+            Stream::reference_control_channels<ChannelValue::raw_type>(frame, nchannels, channels);
+        });
+        run("unpack (ring window)", views, [](const auto &frame, Channels &channels) {
+            fbus_control_channels<ChannelValue::raw_type>(frame, channels);
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @author Peter Christoffersen
+ * @brief LED strip frame conversion benchmark
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Converts a frame of the rover's strip, from the RGBW color buffer to the
+ * pixels sent by DMA, with the original brightness and color correction
+ * multiplies and divides, and with the lookup tables. The host has a fast
+ * divider and an FPU, the RP2040 does the float brightness in software and
+ * has the divider as a peripheral, so the difference is larger there.
+ *
+ * Also times building the tables, which is only done when the brightness
+ * changes.
+ */
+#include <array>
+#include <random>
+#include <stdio.h>
+#include <led/color.h>
+#include <led/colorbuffer.h>
+#include <led/colortable.h>
+
+#include "bench.h"
+
+using namespace LED;
+
+static constexpr size_t N_PIXELS { 2*24 };
+static constexpr size_t N_FRAMES { 1000000 };
+
+using buffer_type = Color::Buffer<Color::RGBW, N_PIXELS>;
+using frame_type = std::array<uint32_t, N_PIXELS>;
+
+
+template<typename CONVERT>
+static void run(const char *name, size_t n, CONVERT &&convert)
+{
+    auto cycles = Bench::cycles_per_call(n, convert);
+    auto ns = Bench::ns_per_call(n, convert);
+    printf("%-28s %8.1f cycles/call   %8.2f ns/call\n", name, cycles, ns);
+}
+
+
+int main()
+{
+    std::mt19937 rng { 1 };
+    std::uniform_int_distribution<uint> channel { 0, 0xFF };
+    buffer_type buffer;
+    for (auto &color : buffer) {
+        color = Color::RGBW { channel(rng), channel(rng), channel(rng) };
+    }
+
+    const Color::Correction correction { Color::Correction::TypicalLEDStrip };
+    const float brightness { 0.7f };
+    Color::Table table;
+    table.set(brightness*brightness, correction);
+    frame_type frame;
+
+    Bench::header("Strip::show - 48 pixel frame");
+    run("multiply/divide (original)", N_FRAMES, [&]() {
+        uint idx = 0;
+        for (const auto &color : buffer) {
+            auto c = color;
+            c *= (brightness*brightness);
+            c *= correction;
+            frame[idx++] = c.rgb()<<8 | c.white();
+        }
+        Bench::keep(frame);
+    });
+    run("lookup table", N_FRAMES, [&]() {
+        uint idx = 0;
+        for (const auto &color : buffer) {
+            frame[idx++] = table.pixel(color);
+        }
+        Bench::keep(frame);
+    });
+
+    Bench::header("Table::set - on brightness change");
+    float b = 0.0f;
+    run("build tables", N_FRAMES/100, [&]() {
+        table.set(b, correction);
+        b = b<1.0f ? b+0.001f : 0.0f;
+        Bench::keep(table);
+    });
+    return 0;
+}
@@ -0,0 +1,318 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Virtual clock simulator of the half duplex FBus2 link, for host tests
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Runs a receiver against a simulated transmitter, on a virtual clock. Every
+ * byte goes on the line at the baud rate, the ISR stamps it and wakes the
+ * receiver task, which runs after a scheduling delay drawn from a LoadModel.
+ * Uplinks are put on the line from the time they are sent, checked against
+ * the uplink slot, and echoed back to the receiver like on the real wire.
+ *
+ * The task is woken by the byte that completes what it waits for, and bytes
+ * that arrive while it is still running are processed straight after.
+ *
+ * The line can also go silent for a while, to time the failsafe deadline of
+ * the lower task, which sleeps in ticks and is woken like the receiver task.
+ */
+#pragma once
+
+#include <queue>
+#include <vector>
+#include <random>
+#include <math.h>
+#include <fbus2/receiver_host.h>
+
+#include "fbus2_stream.h"
+
+namespace FBus2::Test {
+
+    /**
+     * @brief What the transmitter sends
+     *
+     * Every period_us a control frame, directly followed by a downlink poll for
+     * the next id of polls. Polls for ids the receiver doesn't answer are
+     * answered by another sensor, other_reply_us after the downlink.
+     */
+    struct TransmitterModel {
+        int64_t period_us { 8000 };
+        size_t nchannels { 16 };
+        std::vector<uint8_t> polls { Receiver::RECEIVER_ID, OTHER_SENSOR_ID };
+        int64_t other_reply_us { 200 };
+    };
+
+
+    /**
+     * @brief How long the receiver takes to react
+     *
+     *   isr_us       From the end of a byte to the ISR stamping it (UART rx FIFO timeout)
+     *   wake_us      From the ISR to the receiver task running
+     *   busy         Fraction of wakeups where a higher priority task holds the CPU...
+     *   burst_us     ...for up to this long, uniformly distributed
+     *   step_us      Cost of each protocol step that makes progress
+     *   provider_us  Cost of get_next_telemetry()
+     */
+    struct LoadModel {
+        int64_t isr_us { 70 };
+        int64_t wake_us { 20 };
+        double busy { 0.0 };
+        int64_t burst_us { 0 };
+        int64_t step_us { 5 };
+        int64_t provider_us { 10 };
+    };
+
+
+    struct LinkResults {
+        uint cycles { 0 };
+        uint control { 0 };          // Control frames received
+        uint polls { 0 };            // Polls for one of the receiver's ids
+        uint sent { 0 };
+        uint skipped { 0 };
+        uint late { 0 };             // Uplinks that didn't fit in the slot
+        int64_t max_delay_us { 0 };  // End of downlink to start of uplink, on the line
+
+        double skipped_ratio() const { return polls ? static_cast<double>(skipped)/polls : 0.0; }
+    };
+
+
+    /**
+     * @brief ReceiverHost on a virtual clock, with the task costs of a LoadModel
+     */
+    class SimulatedReceiver : public ReceiverHost {
+        public:
+            struct Uplink {
+                int64_t time_us;
+                stream_type data;
+            };
+
+            SimulatedReceiver(const LoadModel &load) : m_load { load } {}
+
+            int64_t clock() const { return m_clock_us; }
+            void set_clock(int64_t us) { m_clock_us = us; }
+            int64_t disarmed_us() const { return m_disarmed_us; }
+
+            std::vector<Uplink> &uplinks() { return m_uplinks; }
+
+        protected:
+            virtual absolute_time_t now() const override { return from_us_since_boot(m_clock_us); }
+
+            virtual void on_data(const channels_type &channels, ChangeMask changes) override
+            {
+                ReceiverHost::on_data(channels, changes);
+                // Where the application stops the motors
+                if (changes.link() && (!channels.sync() || channels.flags().frameLost())) {
+                    m_disarmed_us = m_clock_us;
+                }
+            }
+
+            virtual bool step() override
+            {
+                bool progress = ReceiverHost::step();
+                if (progress) {
+                    m_clock_us += m_load.step_us;
+                }
+                return progress;
+            }
+
+            virtual Telemetry get_next_telemetry(uint8_t sensor_id) override
+            {
+                m_clock_us += m_load.provider_us;
+                return ReceiverHost::get_next_telemetry(sensor_id);
+            }
+
+            virtual void tx_send(const uint8_t *buf, size_t sz) override
+            {
+                ReceiverHost::tx_send(buf, sz);
+                m_uplinks.push_back({ m_clock_us, stream_type(buf, buf+sz) });
+            }
+
+        private:
+            const LoadModel m_load;
+            int64_t m_clock_us { 0 };
+            int64_t m_disarmed_us { -1 };
+            std::vector<Uplink> m_uplinks;
+    };
+
+
+    class LinkSimulator {
+        public:
+            // Virtual time of the first cycle, clear of nil_time
+            static constexpr int64_t START_US { 1000 };
+            static constexpr int64_t TICK_US { 1000000/configTICK_RATE_HZ };
+
+            LinkSimulator(const TransmitterModel &tx, const LoadModel &load, uint seed=1) :
+                m_tx { tx },
+                m_load { load },
+                m_rx { load },
+                m_char_us { 1.0e6*FBus2Protocol::LINE.bits_per_char()/FBus2Protocol::LINE.baudrate },
+                m_rng { seed }
+            {
+            }
+
+            // Set sensor ids and telemetry before the first run()
+            SimulatedReceiver &receiver() { return m_rx; }
+
+            /**
+             * @brief Run cycles transmitter cycles, can be called again to carry on
+             */
+            LinkResults run(uint cycles)
+            {
+                if (!m_started) {
+                    m_rx.init();
+                    m_wake_latency_us = wake_latency();
+                    m_started = true;
+                }
+                LinkResults results;
+                uint control = m_rx.n_control_packets();
+                uint sent = m_rx.n_telemetry_sent();
+                uint skipped = m_rx.n_telemetry_skipped();
+
+                for (uint i=0; i<cycles; ++i) {
+                    int64_t begin = START_US+m_cycle*m_tx.period_us;
+                    int64_t end = begin+m_tx.period_us;
+                    uint8_t poll = m_tx.polls[m_cycle % m_tx.polls.size()];
+                    m_cycle++;
+
+                    stream_type control;
+                    append_control(control, m_tx.nchannels, cycle_values(m_cycle).data());
+                    m_control_end_us = transmit(control, begin);
+                    stream_type downlink;
+                    append_downlink(downlink, poll);
+                    int64_t downlink_end = transmit(downlink, m_control_end_us);
+
+                    if (m_rx.answers(poll)) {
+                        results.polls++;
+                        m_slot_begin_us = downlink_end;
+                        m_slot_end_us = std::min(downlink_end+FBUS_UPLINK_SEND_TIMEOUT_US, end);
+                    }
+                    else {
+                        stream_type reply;
+                        append_uplink(reply, poll);
+                        transmit(reply, downlink_end+m_tx.other_reply_us);
+                    }
+                    process(end, results);
+                }
+
+                results.cycles = cycles;
+                results.control = m_rx.n_control_packets()-control;
+                results.sent = m_rx.n_telemetry_sent()-sent;
+                results.skipped = m_rx.n_telemetry_skipped()-skipped;
+                return results;
+            }
+
+            /**
+             * @brief Let the line go silent for duration_us, rounded up to whole cycles
+             *
+             * @return int64_t From the end of the last control frame on the line
+             *         to the motors being stopped by the failsafe, -1 if they weren't
+             */
+            int64_t silence(int64_t duration_us)
+            {
+                // Carries on with the cycle after
+                m_cycle += (duration_us+m_tx.period_us-1)/m_tx.period_us;
+                int64_t end = START_US+m_cycle*m_tx.period_us;
+                uint failsafes = m_rx.n_failsafes();
+
+                // The lower task sleeps from the last delivery to the failsafe deadline, in ticks
+                m_rx.set_clock(m_busy_until_us);
+                while (m_rx.n_failsafes()==failsafes) {
+                    TickType_t ticks = m_rx.failsafe_wait();
+                    if (ticks==portMAX_DELAY) {
+                        break;
+                    }
+                    int64_t wake = (m_rx.clock()/TICK_US+ticks)*TICK_US+wake_latency();
+                    if (wake>=end) {
+                        break;
+                    }
+                    m_rx.set_clock(wake);
+                    m_rx.poll_failsafe();
+                }
+
+                m_busy_until_us = m_rx.clock();
+                return m_rx.n_failsafes()!=failsafes ? m_rx.disarmed_us()-m_control_end_us : -1;
+            }
+
+        private:
+            struct LineByte {
+                int64_t time_us; // End of the byte
+                uint8_t byte;
+
+                bool operator>(const LineByte &other) const { return time_us>other.time_us; }
+            };
+
+            const TransmitterModel m_tx;
+            const LoadModel m_load;
+            SimulatedReceiver m_rx;
+            const double m_char_us;
+
+            std::priority_queue<LineByte, std::vector<LineByte>, std::greater<LineByte>> m_line;
+            uint m_cycle { 0 };
+            bool m_started { false };
+            int64_t m_busy_until_us { 0 };
+            int64_t m_wake_latency_us { 0 };
+            int64_t m_slot_begin_us { 0 };
+            int64_t m_slot_end_us { 0 };
+            int64_t m_control_end_us { 0 };
+
+            std::mt19937 m_rng;
+            std::uniform_real_distribution<double> m_busy { 0.0, 1.0 };
+
+            int64_t char_end(int64_t begin, size_t n) const { return begin+llround((n+1)*m_char_us); }
+
+            /**
+             * @brief Put data on the line from begin
+             *
+             * @return int64_t Time the last byte has been sent
+             */
+            int64_t transmit(const stream_type &data, int64_t begin)
+            {
+                for (size_t n=0; n<data.size(); ++n) {
+                    m_line.push({ char_end(begin, n), data[n] });
+                }
+                return char_end(begin, data.size()-1);
+            }
+
+            int64_t wake_latency()
+            {
+                int64_t us = m_load.wake_us;
+                if (m_load.busy>0.0 && m_busy(m_rng)<m_load.busy) {
+                    us += std::uniform_int_distribution<int64_t> { 0, m_load.burst_us }(m_rng);
+                }
+                return us;
+            }
+
+            /**
+             * @brief Receive everything on the line before until
+             */
+            void process(int64_t until, LinkResults &results)
+            {
+                while (!m_line.empty() && m_line.top().time_us<until) {
+                    auto byte = m_line.top();
+                    m_line.pop();
+
+                    // The ISR stamps the byte, and wakes the task, unless it is still running
+                    int64_t isr = byte.time_us+m_load.isr_us;
+                    m_rx.push(&byte.byte, 1, from_us_since_boot(isr));
+                    m_rx.set_clock(m_busy_until_us>isr ? m_busy_until_us : isr+m_wake_latency_us);
+                    if (m_rx.poll()==0) {
+                        // Still blocked
+                        continue;
+                    }
+                    m_busy_until_us = m_rx.clock();
+                    m_wake_latency_us = wake_latency();
+
+                    for (auto &uplink : m_rx.uplinks()) {
+                        int64_t end = transmit(uplink.data, uplink.time_us);
+                        results.max_delay_us = std::max(results.max_delay_us, uplink.time_us-m_slot_begin_us);
+                        if (uplink.time_us<m_slot_begin_us || end>m_slot_end_us) {
+                            results.late++;
+                        }
+                    }
+                    m_rx.uplinks().clear();
+                }
+            }
+    };
+
+}
@@ -0,0 +1,110 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Reference FBus2 channel decoder for host tests and benchmarks
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The original hand unrolled decoder, kept to check the generic unpacker in
+ * protocol.h against, the original float and division ChannelValue
+ * conversions, to check the fixed point ones against, and the original hand
+ * written Taranis X9D Plus mapping, to check the mapping table against.
+ */
+#pragma once
+
+#include <pico/stdlib.h>
+
+#include <algorithm>
+#include <fbus2/channels.h>
+#include <fbus2/mapping.h>
+
+#include "protocol.h"
+
+namespace FBus2::Test {
+
+    /**
+     * @brief Extracts 8 channels (11 bit per channel) from fbus package
+     */
+    template <typename value_type, typename source_buffer_type, typename dest_buffer_type>
+    void reference_get_8channel(const source_buffer_type &src, size_t src_offset, dest_buffer_type &dst, size_t dst_offset)
+    {
+        dst[dst_offset  ] = (static_cast<value_type>(src[src_offset+0]))           + ((0x07 & src[src_offset+1])<<8);
+        dst[dst_offset+1] = (static_cast<value_type>(0xF8 & src[src_offset+1])>>3) + ((0x3F & src[src_offset+2])<<5);
+        dst[dst_offset+2] = (static_cast<value_type>(0xC0 & src[src_offset+2])>>6) + (src[src_offset+3]<<2) + ((0x01 & src[src_offset+4])<<10);
+        dst[dst_offset+3] = (static_cast<value_type>(0xFE & src[src_offset+4])>>1) + ((0x0F & src[src_offset+5])<<7);
+        dst[dst_offset+4] = (static_cast<value_type>(0xF0 & src[src_offset+5])>>4) + ((0x7F & src[src_offset+6])<<4);
+        dst[dst_offset+5] = (static_cast<value_type>(0x80 & src[src_offset+6])>>7) + (src[src_offset+7]<<1) + ((0x03 & src[src_offset+8])<<9);
+        dst[dst_offset+6] = (static_cast<value_type>(0xFC & src[src_offset+8])>>2) + ((0x1F & src[src_offset+9])<<6);
+        dst[dst_offset+7] = (static_cast<value_type>(0xF0 & src[src_offset+9])>>5) + ((src[src_offset+10])<<3);
+    }
+
+    template <typename value_type, typename source_buffer_type, typename dest_buffer_type>
+    void reference_control_channels(const source_buffer_type &src, size_t count, dest_buffer_type &dst)
+    {
+        for (size_t ch=0; ch<count; ch+=8) {
+            reference_get_8channel<value_type>(src, FBUS_CONTROL_HDR_SIZE+ch/8*FBUS_CONTROL_8_VALUE_SIZE, dst, ch);
+        }
+    }
+
+
+    static inline uint reference_servo_pulse(ChannelValue::raw_type value)
+    {
+        return ChannelValue::SERVO_MIN+static_cast<uint>(value-ChannelValue::CHANNEL_MIN)*(ChannelValue::SERVO_MAX-ChannelValue::SERVO_MIN)/(ChannelValue::CHANNEL_MAX-ChannelValue::CHANNEL_MIN);
+    }
+
+    static inline float reference_percent(ChannelValue::raw_type value)
+    {
+        return static_cast<float>(value-ChannelValue::CHANNEL_MIN)/ChannelValue::CHANNEL_RANGE;
+    }
+
+    static inline float reference_float(ChannelValue::raw_type value)
+    {
+        return static_cast<float>((2.0f*(static_cast<int32_t>(value)-ChannelValue::CHANNEL_CENTER)))/ChannelValue::CHANNEL_RANGE;
+    }
+
+
+    struct ReferenceTaranisX9DPlus {
+        ChannelValue left_x, left_y, right_x, right_y;
+        ChannelValue s1, s2, slider_l, slider_r;
+        Toggle sa { Toggle::P1 }, sb { Toggle::P0 }, sc { Toggle::P0 }, sd { Toggle::P0 }, se { Toggle::P0 };
+        bool sf { false };
+        Toggle sg { Toggle::P0 };
+        bool sh { false }, si { false };
+
+        void set(const Channels &channels)
+        {
+            sa = static_cast<Toggle>(channels[8].asButton(3));
+
+            left_x = channels[0];
+            left_y = channels[1];
+            right_x = channels[2];
+            right_y = channels[3];
+
+            s1 = channels[4];
+            s2 = channels[5];
+            slider_l = channels[6];
+            slider_r = channels[7];
+
+            constexpr uint BASE = 471;
+            constexpr uint DIVISOR = 98;
+            constexpr uint OFFSET = 16;
+            constexpr uint SCALE = 10;
+            uint value;
+
+            value = ((std::max(ChannelValue::CHANNEL_MIN, channels[8].raw())-BASE)*SCALE+OFFSET)/DIVISOR;
+            sa = static_cast<Toggle>(value & 0b11);
+            sb = static_cast<Toggle>((value>>2) & 0b11);
+            se = static_cast<Toggle>((value>>4) & 0b11);
+            sf =   static_cast<bool>((value>>6) & 0b1);
+
+            value = ((std::max(ChannelValue::CHANNEL_MIN, channels[9].raw())-BASE)*SCALE+OFFSET)/DIVISOR;
+            sc = static_cast<Toggle>(value & 0b11);
+            sd = static_cast<Toggle>((value>>2) & 0b11);
+            sg = static_cast<Toggle>((value>>4) & 0b11);
+            sh =   static_cast<bool>((value>>6) & 0b1);
+
+            si = channels[10].asToggle();
+        }
+    };
+
+}
@@ -0,0 +1,229 @@
+/**
+ * @author Peter Christoffersen
+ * @brief Synthetic FBus2, SBUS and FPort byte streams for host tests and benchmarks
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <array>
+#include <vector>
+#include <random>
+#include <pico/stdlib.h>
+
+#include "protocol.h"
+#include "sbus.h"
+#include "fport.h"
+
+namespace FBus2::Test {
+
+    using stream_type = std::vector<uint8_t>;
+
+    static constexpr uint8_t OTHER_SENSOR_ID { 0x1B };
+
+
+    static inline void append_checksum(stream_type &stream, size_t begin, size_t hdr_size)
+    {
+        stream.push_back(fbus_checksum(stream, begin+hdr_size, stream.size()-begin-hdr_size));
+    }
+
+
+    /**
+     * @brief Pack 11 bit values, LSB first
+     */
+    static inline void append_channels(stream_type &stream, size_t nchannels, const uint16_t *values)
+    {
+        uint32_t bits = 0;
+        uint nbits = 0;
+        for (size_t i=0; i<nchannels; ++i) {
+            bits |= static_cast<uint32_t>(values[i] & 0x7FF) << nbits;
+            nbits += 11;
+            while (nbits>=8) {
+                stream.push_back(bits & 0xFF);
+                bits >>= 8;
+                nbits -= 8;
+            }
+        }
+    }
+
+
+    /**
+     * @brief Channel values of cycle seq
+     */
+    static inline std::array<uint16_t, 24> cycle_values(uint seq)
+    {
+        std::array<uint16_t, 24> values;
+        for (size_t i=0; i<values.size(); ++i) {
+            values[i] = 172 + (seq*7 + i*61) % 1640;
+        }
+        return values;
+    }
+
+
+    /**
+     * @brief Append a control frame with nchannels channels (8, 16 or 24)
+     */
+    static inline void append_control(stream_type &stream, size_t nchannels, const uint16_t *values, uint8_t rssi=100, uint8_t flags=0x00)
+    {
+        size_t begin = stream.size();
+        size_t nbytes = nchannels*11/8;
+        stream.push_back(static_cast<uint8_t>(nbytes+2));
+        stream.push_back(FBUS_CONTROL_HDR);
+        append_channels(stream, nchannels, values);
+        stream.push_back(flags);
+        stream.push_back(rssi);
+        append_checksum(stream, begin, FBUS_CONTROL_HDR_SIZE);
+    }
+
+    static inline void append_downlink(stream_type &stream, uint8_t id)
+    {
+        size_t begin = stream.size();
+        stream.push_back(FBUS_DOWNLINK_HDR);
+        stream.push_back(id);
+        stream.push_back(0x00); // prim
+        for (uint i=0; i<6; ++i) stream.push_back(0x00);
+        append_checksum(stream, begin, FBUS_DOWNLINK_HDR_SIZE);
+    }
+
+    static inline void append_uplink(stream_type &stream, uint8_t id, uint16_t app_id=0x0000, uint32_t data=0x00000000)
+    {
+        size_t begin = stream.size();
+        stream.push_back(FBUS_UPLINK_HDR);
+        stream.push_back(id);
+        stream.push_back(FBUS_UPLINK_DATA_FRAME);
+        stream.push_back(app_id & 0xFF);
+        stream.push_back(app_id >> 8);
+        for (uint i=0; i<4; ++i) stream.push_back((data >> (8*i)) & 0xFF);
+        append_checksum(stream, begin, FBUS_UPLINK_HDR_SIZE);
+    }
+
+
+    /**
+     * @brief Append one transmitter cycle, control + downlink + uplink from some other sensor
+     */
+    static inline void append_cycle(stream_type &stream, size_t nchannels, uint seq, uint8_t rssi=100, uint8_t flags=0x00)
+    {
+        auto values = cycle_values(seq);
+        append_control(stream, nchannels, values.data(), rssi, flags);
+        append_downlink(stream, OTHER_SENSOR_ID);
+        append_uplink(stream, OTHER_SENSOR_ID);
+    }
+
+    static inline stream_type make_stream(size_t cycles, size_t nchannels=16)
+    {
+        stream_type stream;
+        for (uint i=0; i<cycles; ++i) {
+            append_cycle(stream, nchannels, i);
+        }
+        return stream;
+    }
+
+
+    /**
+     * @brief Append an SBUS frame, of 16 channels
+     */
+    static inline void append_sbus(stream_type &stream, const uint16_t *values, uint8_t flags=0x00, uint8_t footer=SBUS_FOOTER)
+    {
+        stream.push_back(SBUS_HDR);
+        append_channels(stream, SBUS_CHANNEL_COUNT, values);
+        stream.push_back(flags);
+        stream.push_back(footer);
+    }
+
+    static inline stream_type make_sbus_stream(size_t frames)
+    {
+        stream_type stream;
+        for (uint i=0; i<frames; ++i) {
+            append_sbus(stream, cycle_values(i).data());
+        }
+        return stream;
+    }
+
+
+    /**
+     * @brief Append LEN..payload of an FPort frame, with checksum, byte stuffed
+     * 
+     * @param delimiters Between delimiters, the uplink from the flight controller goes without
+     */
+    static inline void append_fport(stream_type &stream, stream_type frame, bool delimiters=true)
+    {
+        frame.push_back(fbus_checksum(frame, 0, frame.size()));
+        if (delimiters) {
+            stream.push_back(FPORT_DELIMITER);
+        }
+        for (auto b : frame) {
+            if (fport_needs_escape(b)) {
+                stream.push_back(FPORT_ESCAPE);
+                b ^= FPORT_ESCAPE_XOR;
+            }
+            stream.push_back(b);
+        }
+        if (delimiters) {
+            stream.push_back(FPORT_DELIMITER);
+        }
+    }
+
+    static inline void append_fport_control(stream_type &stream, const uint16_t *values, uint8_t rssi=100, uint8_t flags=0x00)
+    {
+        stream_type frame { FPORT_CONTROL_LEN, FPORT_TYPE_CONTROL };
+        append_channels(frame, FPORT_CONTROL_CHANNEL_COUNT, values);
+        frame.push_back(flags);
+        frame.push_back(rssi);
+        append_fport(stream, frame);
+    }
+
+    static inline void append_fport_downlink(stream_type &stream, uint8_t prim=FPORT_PRIM_DATA)
+    {
+        append_fport(stream, { FPORT_DOWNLINK_LEN, FPORT_TYPE_DOWNLINK, prim, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+    }
+
+    static inline void append_fport_uplink(stream_type &stream, uint16_t app_id=0x0000, uint32_t data=0x00000000)
+    {
+        stream_type frame { FPORT_UPLINK_LEN, FPORT_TYPE_UPLINK, FPORT_PRIM_DATA, static_cast<uint8_t>(app_id & 0xFF), static_cast<uint8_t>(app_id >> 8) };
+        for (uint i=0; i<4; ++i) frame.push_back((data >> (8*i)) & 0xFF);
+        append_fport(stream, frame, false);
+    }
+
+    /**
+     * @brief Append one FPort cycle, control + downlink + uplink from the flight controller
+     */
+    static inline void append_fport_cycle(stream_type &stream, uint seq, uint8_t rssi=100, uint8_t flags=0x00)
+    {
+        append_fport_control(stream, cycle_values(seq).data(), rssi, flags);
+        append_fport_downlink(stream);
+        append_fport_uplink(stream, 0x5100, seq);
+    }
+
+    static inline stream_type make_fport_stream(size_t cycles)
+    {
+        stream_type stream;
+        for (uint i=0; i<cycles; ++i) {
+            append_fport_cycle(stream, i);
+        }
+        return stream;
+    }
+
+
+    /**
+     * @brief Replace a fraction of the bytes in the stream with random values
+     *
+     * @return size_t Number of corrupted bytes
+     */
+    static inline size_t corrupt(stream_type &stream, double fraction, uint seed=1234)
+    {
+        std::mt19937 rng { seed };
+        std::uniform_real_distribution<double> pick { 0.0, 1.0 };
+        std::uniform_int_distribution<int> value { 1, 0xFF };
+        size_t count = 0;
+        for (auto &b : stream) {
+            if (pick(rng)<fraction) {
+                b ^= value(rng);
+                count++;
+            }
+        }
+        return count;
+    }
+
+}
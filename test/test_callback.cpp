@@ -0,0 +1,71 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <util/callback.h>
+
+
+static int g_sum = 0;
+static void add_to_sum(int v) { g_sum += v; }
+
+
+TEST(Callback, order_and_captures)
+{
+    std::vector<int> calls;
+    std::vector<int> *log = &calls;
+    int scale = 10;
+
+    Callback<int> callbacks;
+    EXPECT_TRUE(callbacks.empty());
+    EXPECT_TRUE(callbacks.add([log](int v) { log->push_back(v); }));
+    EXPECT_TRUE(callbacks.add([log, scale](int v) { log->push_back(scale*v); }));
+    EXPECT_TRUE(callbacks.add(add_to_sum));
+    EXPECT_EQ(callbacks.size(), 3u);
+
+    callbacks(1);
+    callbacks(2);
+    EXPECT_EQ(calls, (std::vector<int> { 1, 10, 2, 20 }));
+    EXPECT_EQ(g_sum, 3);
+
+    callbacks.clear();
+    callbacks(3);
+    EXPECT_EQ(calls.size(), 4u);
+}
+
+
+TEST(Callback, reference_arguments)
+{
+    struct Sensor {
+        int value;
+    };
+    Sensor sensor { 42 };
+    const Sensor *seen = nullptr;
+    float sum = 0.0f;
+
+    Callback<const Sensor&, float, float> callbacks;
+    callbacks.add([&seen, &sum](const Sensor &s, float a, float b) {
+        seen = &s;
+        sum = a+b;
+    });
+    callbacks(sensor, 1.5f, 2.0f);
+
+    // Passed on by reference, not copied
+    EXPECT_EQ(seen, &sensor);
+    EXPECT_EQ(sum, 3.5f);
+}
+
+
+TEST(Callback, capacity)
+{
+    int count = 0;
+    CallbackList<2, int> callbacks;
+    EXPECT_EQ(callbacks.capacity(), 2u);
+    EXPECT_TRUE(callbacks.add([&count](int v) { count += v; }));
+    EXPECT_TRUE(callbacks.add([&count](int v) { count += 2*v; }));
+    #ifdef NDEBUG
+    EXPECT_FALSE(callbacks.add([&count](int v) { count += 4*v; }));
+    #else
+    EXPECT_DEATH(callbacks.add([&count](int v) { count += 4*v; }), "");
+    #endif
+    callbacks(1);
+    EXPECT_EQ(count, 3);
+}
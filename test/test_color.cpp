@@ -1,6 +1,7 @@
 
 #include <gtest/gtest.h>
 #include <led/color.h>
+#include <led/colortable.h>
 
 
 TEST(Color, RGB) {
@@ -194,3 +195,33 @@ TEST(Color, Blend) {
     EXPECT_EQ(dst.white(), 0x00) << "White2(white) " << dst;
 }
 
+
+TEST(Color, Table) {
+    using namespace LED::Color;
+
+    // The original per pixel conversion in Strip::show()
+    auto reference = [](auto c, float brightness, Correction correction) {
+        c *= brightness;
+        c *= correction;
+        return c.rgb()<<8 | c.white();
+    };
+
+    Table table;
+    for (auto correction : { Correction::TypicalLEDStrip, Correction::Typical8mmPixel, Correction::UncorrectedRGBW }) {
+        for (float brightness : { 0.0f, 0.01f, 0.1f, 0.25f, 0.5f, 0.7f, 0.99f, 1.0f }) {
+            table.set(brightness, correction);
+            for (uint v=0; v<=0xFF; ++v) {
+                for (RGB c : { RGB(v, 0u, 0u), RGB(0u, v, 0u), RGB(0u, 0u, v), RGB(v, v^0x5A, 0xFF-v) }) {
+                    ASSERT_EQ(table.pixel(c), reference(c, brightness, correction)) << c << " " << brightness;
+                    RGBW w { c };
+                    ASSERT_EQ(table.pixel(w), reference(w, brightness, correction)) << w << " " << brightness;
+                }
+
+                // White is scaled, but not corrected
+                RGBW w { 0u, 0u, 0u, v };
+                uint scale = brightness*0xFF+0.5f;
+                EXPECT_EQ(table.pixel(w), v*scale/0xFF) << w << " " << brightness;
+            }
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#include <array>
+#include <gtest/gtest.h>
+
+#include <fbus2/arbiter.h>
+#include <fbus2/receiver_host.h>
+
+#include "fbus2_stream.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+static constexpr int64_t FRAME_PERIOD_US { 9000 };
+static constexpr absolute_time_t START { 1000000 };
+
+static absolute_time_t at(int64_t us)
+{
+    return delayed_by_us(START, us);
+}
+
+static Channels make_link(bool sync, uint8_t rssi, absolute_time_t time, uint8_t flags=0x00)
+{
+    Channels channels;
+    channels.set_sync(sync);
+    channels.set_rssi(rssi);
+    channels.set_time(time);
+    channels.set_flags(flags);
+    return channels;
+}
+
+
+TEST(FBus2LinkArbiter, prefers_healthy_link)
+{
+    LinkArbiter<2> arbiter;
+    auto now = at(0);
+
+    EXPECT_EQ(arbiter.select({ make_link(false, 0, nil_time), make_link(true, 50, now) }, now), 1u);
+    EXPECT_EQ(arbiter.switches(), 1u);
+
+    // Failsafe and frame lost links are not healthy, whatever their signal
+    EXPECT_EQ(arbiter.select({ make_link(true, 100, now), make_link(true, 50, now, 1<<3) }, now), 0u);
+    EXPECT_EQ(arbiter.select({ make_link(true, 100, now, 1<<2), make_link(true, 50, now) }, now), 1u);
+}
+
+
+TEST(FBus2LinkArbiter, rssi_hysteresis)
+{
+    LinkArbiter<2> arbiter { LinkArbiter<2>::DEFAULT_MAX_AGE_US, 10 };
+    auto now = at(0);
+
+    EXPECT_EQ(arbiter.select({ make_link(true, 60, now), make_link(true, 65, now) }, now), 0u);
+    EXPECT_EQ(arbiter.select({ make_link(true, 60, now), make_link(true, 70, now) }, now), 0u);
+    EXPECT_EQ(arbiter.select({ make_link(true, 60, now), make_link(true, 71, now) }, now), 1u);
+    // And not straight back
+    EXPECT_EQ(arbiter.select({ make_link(true, 75, now), make_link(true, 71, now) }, now), 1u);
+    EXPECT_EQ(arbiter.switches(), 1u);
+}
+
+
+TEST(FBus2LinkArbiter, stale_link)
+{
+    LinkArbiter<3> arbiter { 50000 };
+    auto last = at(0);
+
+    EXPECT_EQ(arbiter.select({ make_link(true, 90, last), make_link(true, 40, last), make_link(true, 50, last) }, last), 0u);
+
+    // Link 0 has stopped, the others keep going
+    EXPECT_EQ(arbiter.select({ make_link(true, 90, last), make_link(true, 40, at(50000)), make_link(true, 50, at(50000)) }, at(50000)), 0u);
+    EXPECT_EQ(arbiter.select({ make_link(true, 90, last), make_link(true, 40, at(50001)), make_link(true, 50, at(50001)) }, at(50001)), 2u);
+}
+
+
+/**
+ * @brief Two receivers on the same transmitter, on a simulated clock
+ */
+class FBus2ArbiterLinks : public ::testing::Test {
+    protected:
+        ReceiverHost m_rx[2];
+        LinkArbiter<2> m_arbiter;
+        uint m_seq { 0 };
+
+        void SetUp() override
+        {
+            for (auto &rx : m_rx) {
+                rx.init();
+            }
+        }
+
+        absolute_time_t now() const { return at(m_seq*FRAME_PERIOD_US); }
+
+        /**
+         * @brief Feed one cycle to the links that are up, and select
+         */
+        size_t cycle(bool up0, bool up1, uint8_t rssi0=100, uint8_t rssi1=100, uint8_t flags0=0x00)
+        {
+            Stream::stream_type stream0, stream1;
+            Stream::append_cycle(stream0, 16, m_seq, rssi0, flags0);
+            Stream::append_cycle(stream1, 16, m_seq, rssi1);
+            if (up0) {
+                m_rx[0].feed(stream0.data(), stream0.size(), now());
+            }
+            if (up1) {
+                m_rx[1].feed(stream1.data(), stream1.size(), now());
+            }
+            auto link = m_arbiter.select({ &m_rx[0], &m_rx[1] }, now());
+            m_seq++;
+            return link;
+        }
+};
+
+
+TEST_F(FBus2ArbiterLinks, switch_over_on_dropout)
+{
+    for (uint i=0; i<20; ++i) {
+        ASSERT_EQ(cycle(true, true), 0u);
+    }
+    auto last_frame = m_rx[0].channels().time();
+
+    // Link 0 drops out
+    uint cycles = 0;
+    while (cycle(false, true)!=1u) {
+        ASSERT_LT(++cycles, 100u);
+    }
+    int64_t latency = absolute_time_diff_us(last_frame, m_arbiter.switch_time());
+    RecordProperty("switch_over_us", latency);
+    EXPECT_GT(latency, LinkArbiter<2>::DEFAULT_MAX_AGE_US);
+    EXPECT_LE(latency, LinkArbiter<2>::DEFAULT_MAX_AGE_US+FRAME_PERIOD_US);
+    EXPECT_EQ(m_arbiter.channels().seq(), m_rx[1].channels().seq());
+
+    // Link 0 comes back, no reason to switch back
+    for (uint i=0; i<20; ++i) {
+        EXPECT_EQ(cycle(true, true), 1u);
+    }
+    EXPECT_EQ(m_arbiter.switches(), 1u);
+}
+
+
+TEST_F(FBus2ArbiterLinks, switch_over_on_failsafe)
+{
+    for (uint i=0; i<5; ++i) {
+        ASSERT_EQ(cycle(true, true), 0u);
+    }
+    // Failsafe is reported in the frame itself, so the very next frame switches
+    EXPECT_EQ(cycle(true, true, 100, 100, 1<<3), 1u);
+    EXPECT_EQ(absolute_time_diff_us(m_rx[0].channels().time(), m_arbiter.switch_time()), 0);
+}
+
+
+TEST_F(FBus2ArbiterLinks, switch_over_on_signal)
+{
+    for (uint i=0; i<5; ++i) {
+        ASSERT_EQ(cycle(true, true, 80, 80), 0u);
+    }
+    // Link 0 fades, link 1 takes over once it is better by the hysteresis
+    uint8_t rssi = 80;
+    while (cycle(true, true, rssi, 80)==0u) {
+        ASSERT_GT(rssi--, 0u);
+    }
+    EXPECT_EQ(rssi+LinkArbiter<2>::DEFAULT_RSSI_HYSTERESIS, 79);
+    EXPECT_EQ(m_arbiter.switches(), 1u);
+}
@@ -0,0 +1,234 @@
+#include <array>
+#include <random>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include <fbus2/receiver_host.h>
+#include <fbus2/protocol_fport.h>
+
+#include "fbus2_stream.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+using FPortReceiver = ProtocolReceiverHost<FPortProtocol>;
+
+/**
+ * @brief FPortReceiver on a stopped clock, so a slow host can't miss the uplink window
+ */
+class StoppedClockReceiver : public FPortReceiver {
+    public:
+        static constexpr uint64_t CLOCK_US { 1000000 };
+
+        using FPortReceiver::FPortReceiver;
+
+    protected:
+        virtual absolute_time_t now() const override { return from_us_since_boot(CLOCK_US); }
+};
+
+// Largest frame the receiver waits for, fully stuffed
+static constexpr size_t MAX_PENDING { FPortProtocol::MAX_STUFFED_SIZE };
+
+
+static void expect_cycle_channels(const FPortReceiver &rx, uint seq)
+{
+    auto channels = rx.channels();
+    auto values = Stream::cycle_values(seq);
+    ASSERT_EQ(channels.count(), FPORT_CONTROL_CHANNEL_COUNT);
+    for (size_t ch=0; ch<FPORT_CONTROL_CHANNEL_COUNT; ++ch) {
+        EXPECT_EQ(channels[ch].raw(), values[ch]) << "seq=" << seq << " ch=" << ch;
+    }
+}
+
+static Stream::stream_type unstuff(const Stream::stream_type &stuffed)
+{
+    Stream::stream_type frame;
+    for (size_t i=0; i<stuffed.size(); ++i) {
+        frame.push_back(stuffed[i]==FPORT_ESCAPE ? stuffed[++i]^FPORT_ESCAPE_XOR : stuffed[i]);
+    }
+    return frame;
+}
+
+
+TEST(FPortReceiver, clean_stream)
+{
+    constexpr uint CYCLES { 1000 };
+    FPortReceiver rx { FPortProtocol::LINE };
+    rx.init();
+
+    auto stream = Stream::make_fport_stream(CYCLES);
+    rx.feed(stream);
+
+    // The last uplink waits for the delimiter of the next frame
+    EXPECT_EQ(rx.n_control_packets(), CYCLES);
+    EXPECT_EQ(rx.n_data(), CYCLES);
+    // Every uplink slot is answered, or skipped when the host stalled past the send window
+    EXPECT_EQ(rx.n_telemetry_sent()+rx.n_telemetry_skipped(), CYCLES);
+    EXPECT_GT(rx.n_telemetry_sent(), 0u);
+    EXPECT_TRUE(rx.sync());
+    EXPECT_TRUE(rx.connected());
+    EXPECT_EQ(rx.rssi(), 100);
+    EXPECT_EQ(rx.state(), FPortReceiver::State::READ_FRAME);
+    EXPECT_EQ(rx.stats().crc_failures(FrameType::CONTROL), 0u);
+    EXPECT_EQ(rx.stats().crc_failures(FrameType::UPLINK), 0u);
+    expect_cycle_channels(rx, CYCLES-1);
+}
+
+
+TEST(FPortReceiver, byte_stuffing)
+{
+    FPortReceiver rx { FPortProtocol::LINE };
+    rx.init();
+
+    // Channel 0 packs to 0x7E in the first byte, like the RSSI
+    std::array<uint16_t, 16> values;
+    values.fill(ChannelValue::CHANNEL_CENTER);
+    values[0] = 0x57E;
+    Stream::stream_type stream;
+    Stream::append_fport_control(stream, values.data(), FPORT_DELIMITER, Flags::CH18_MASK);
+    ASSERT_GE(std::count(stream.begin(), stream.end(), FPORT_ESCAPE), 2);
+    rx.feed(stream);
+
+    EXPECT_EQ(rx.n_control_packets(), 1u);
+    EXPECT_EQ(rx.rssi(), FPORT_DELIMITER);
+    EXPECT_TRUE(rx.flags().ch18());
+    EXPECT_EQ(rx.channels()[0].raw(), 0x57E);
+    EXPECT_EQ(rx.channels()[1].raw(), ChannelValue::CHANNEL_CENTER);
+}
+
+
+TEST(FPortReceiver, escaped_escape)
+{
+    FPortReceiver rx { FPortProtocol::LINE };
+    rx.init();
+
+    // RSSI 0x5D sent as 7D 7D, the escaped byte is data even though it is an escape
+    Stream::stream_type frame { FPORT_CONTROL_LEN, FPORT_TYPE_CONTROL };
+    Stream::append_channels(frame, FPORT_CONTROL_CHANNEL_COUNT, Stream::cycle_values(0).data());
+    frame.push_back(0x00);
+    frame.push_back(FPORT_ESCAPE^FPORT_ESCAPE_XOR);
+    frame.push_back(fbus_checksum(frame, 0, frame.size()));
+    Stream::stream_type stream { FPORT_DELIMITER };
+    for (auto b : frame) {
+        if (fport_needs_escape(b) || b==(FPORT_ESCAPE^FPORT_ESCAPE_XOR)) {
+            stream.push_back(FPORT_ESCAPE);
+            b = b==(FPORT_ESCAPE^FPORT_ESCAPE_XOR) ? FPORT_ESCAPE : b^FPORT_ESCAPE_XOR;
+        }
+        stream.push_back(b);
+    }
+    stream.push_back(FPORT_DELIMITER);
+    rx.feed(stream);
+
+    EXPECT_EQ(rx.n_control_packets(), 1u);
+    EXPECT_EQ(rx.rssi(), FPORT_ESCAPE^FPORT_ESCAPE_XOR);
+    expect_cycle_channels(rx, 0);
+}
+
+
+TEST(FPortReceiver, escape_overflow)
+{
+    FPortReceiver rx { FPortProtocol::LINE };
+    rx.init();
+
+    // Closing delimiter where it would be if each escape in 7D 7D was counted,
+    // which would unstuff to more than a frame
+    constexpr size_t PAIRS { 8 };
+    Stream::stream_type stream;
+    Stream::append_fport_control(stream, Stream::cycle_values(0).data());
+    stream.push_back(FPORT_DELIMITER);
+    stream.push_back(FPORT_CONTROL_LEN);
+    for (size_t i=0; i<PAIRS; ++i) {
+        stream.push_back(FPORT_ESCAPE);
+        stream.push_back(FPORT_ESCAPE);
+    }
+    stream.insert(stream.end(), fport_frame_size(FPORT_CONTROL_LEN)-1, 0x00);
+    stream.push_back(FPORT_DELIMITER);
+
+    // A run of escapes longer than any frame
+    stream.push_back(FPORT_DELIMITER);
+    stream.push_back(FPORT_CONTROL_LEN);
+    stream.insert(stream.end(), 4*FPortProtocol::MAX_STUFFED_SIZE, FPORT_ESCAPE);
+    stream.push_back(FPORT_DELIMITER);
+
+    Stream::append_fport_control(stream, Stream::cycle_values(1).data());
+    for (size_t pos=0; pos<stream.size(); pos+=16) {
+        rx.feed(stream.data()+pos, std::min<size_t>(16, stream.size()-pos));
+        ASSERT_LE(rx.rx_pending(), MAX_PENDING) << "pos=" << pos;
+    }
+
+    EXPECT_EQ(rx.n_control_packets(), 2u);
+    EXPECT_GE(rx.stats().crc_failures(FrameType::CONTROL), 2u);
+    EXPECT_TRUE(rx.sync());
+    expect_cycle_channels(rx, 1);
+}
+
+
+TEST(FPortReceiver, uplink_reply)
+{
+    StoppedClockReceiver rx { FPortProtocol::LINE };
+    rx.init();
+    rx.set_telemetry({ .app_id = FRDID_RPM_FIRST_ID, .data = 0x127E7D78 });
+
+    Stream::stream_type stream;
+    Stream::append_fport_control(stream, Stream::cycle_values(0).data());
+    Stream::append_fport_downlink(stream, FPORT_PRIM_NULL);
+    rx.feed(stream);
+
+    EXPECT_EQ(rx.n_telemetry_sent(), 1u);
+    EXPECT_EQ(rx.n_telemetry_skipped(), 0u);
+    EXPECT_EQ(rx.uplink_latency_us(), 0);
+
+    auto tx = unstuff(rx.tx_data());
+    ASSERT_EQ(tx.size(), fport_frame_size(FPORT_UPLINK_LEN));
+    EXPECT_EQ(rx.tx_data().size(), tx.size()+2);
+    EXPECT_EQ(tx[FPORT_LEN_OFFSET], FPORT_UPLINK_LEN);
+    EXPECT_EQ(tx[FPORT_TYPE_OFFSET], FPORT_TYPE_UPLINK);
+    EXPECT_EQ(tx[FPORT_PRIM_OFFSET], FPORT_PRIM_DATA);
+    EXPECT_EQ(tx[3] | tx[4]<<8, FRDID_RPM_FIRST_ID);
+    EXPECT_EQ(tx[5] | tx[6]<<8 | tx[7]<<16 | tx[8]<<24, 0x127E7D78);
+    EXPECT_EQ(fbus_checksum(tx, FPORT_LEN_OFFSET, tx.size()-1), fport_crc(tx));
+
+    // Our own uplink is echoed back on the half duplex line, and should be skipped
+    Stream::stream_type next { rx.tx_data() };
+    Stream::append_fport_control(next, Stream::cycle_values(1).data());
+    rx.feed(next);
+    EXPECT_EQ(rx.n_control_packets(), 2u);
+    EXPECT_EQ(rx.stats().crc_failures(FrameType::UPLINK), 0u);
+    expect_cycle_channels(rx, 1);
+
+    // Other polls are not answered
+    rx.clear_tx_data();
+    stream.clear();
+    Stream::append_fport_downlink(stream, 0x32);
+    rx.feed(stream);
+    EXPECT_TRUE(rx.tx_data().empty());
+}
+
+
+TEST(FPortReceiver, fuzz_corrupted)
+{
+    constexpr uint CYCLES { 2000 };
+    FPortReceiver rx { FPortProtocol::LINE };
+    rx.init();
+
+    auto stream = Stream::make_fport_stream(CYCLES);
+    Stream::corrupt(stream, 0.002);
+
+    for (uint i=CYCLES; i<CYCLES+10; ++i) {
+        Stream::append_fport_cycle(stream, i);
+    }
+
+    std::mt19937 rng { 42 };
+    std::uniform_int_distribution<size_t> chunk { 1, 100 };
+    for (size_t pos=0; pos<stream.size();) {
+        size_t len = std::min(chunk(rng), stream.size()-pos);
+        rx.feed(stream.data()+pos, len);
+        pos += len;
+        ASSERT_LE(rx.rx_pending(), MAX_PENDING) << "pos=" << pos;
+    }
+    EXPECT_LE(rx.n_steps(), 3*stream.size()) << "Receiver made too many steps without consuming data";
+
+    EXPECT_GT(rx.n_control_packets(), CYCLES*9/10);
+    EXPECT_GT(rx.stats().crc_failures(FrameType::CONTROL), 0u);
+    expect_cycle_channels(rx, CYCLES+9);
+}
@@ -0,0 +1,178 @@
+#include <array>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include <fbus2/receiver_host.h>
+
+#include "fbus2_stream.h"
+#include "fbus2_link.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+static constexpr uint CYCLES { 2000 };
+
+// Time frames take on the line
+static constexpr double CHAR_US { 1.0e6*FBus2Protocol::LINE.bits_per_char()/FBus2Protocol::LINE.baudrate };
+static constexpr int64_t UPLINK_US { static_cast<int64_t>(FBUS_UPLINK_SIZE*CHAR_US) };
+static constexpr double DOWNLINK_US { FBUS_DOWNLINK_SIZE*CHAR_US };
+
+
+static void expect_in_sync(const Stream::LinkResults &results)
+{
+    EXPECT_EQ(results.control, results.cycles);
+    EXPECT_EQ(results.sent+results.skipped, results.polls);
+    EXPECT_EQ(results.late, 0u);
+}
+
+
+TEST(FBus2Link, idle)
+{
+    Stream::LinkSimulator sim { {}, {} };
+    sim.receiver().set_telemetry(Telemetry::rpm(0, 1000.0f));
+    auto results = sim.run(CYCLES);
+
+    expect_in_sync(results);
+    EXPECT_EQ(results.polls, CYCLES/2);
+    EXPECT_EQ(results.skipped, 0u);
+    EXPECT_LT(results.max_delay_us, FBUS_UPLINK_SEND_DELAY_MAX_US);
+    RecordProperty("max_delay_us", results.max_delay_us);
+}
+
+
+TEST(FBus2Link, sensor_ids)
+{
+    Stream::TransmitterModel tx;
+    tx.polls = { Receiver::RECEIVER_ID, Stream::OTHER_SENSOR_ID, Receiver::physical_id(10), Receiver::physical_id(3) };
+    Stream::LinkSimulator sim { tx, {} };
+    sim.receiver().set_sensor_ids({ Receiver::RECEIVER_ID, Receiver::physical_id(10) });
+    auto results = sim.run(CYCLES);
+
+    expect_in_sync(results);
+    EXPECT_EQ(results.polls, CYCLES/2);
+    EXPECT_EQ(results.sent, CYCLES/2);
+}
+
+
+TEST(FBus2Link, cpu_load)
+{
+    // Higher priority work holding the CPU for up to 4ms on some wakeups
+    std::array<double, 5> busy { 0.0, 0.25, 0.5, 0.75, 1.0 };
+    std::array<double, 5> skipped;
+    for (size_t i=0; i<busy.size(); ++i) {
+        Stream::LoadModel load;
+        load.busy = busy[i];
+        load.burst_us = 4000;
+        Stream::LinkSimulator sim { {}, load };
+        auto results = sim.run(CYCLES);
+
+        SCOPED_TRACE(busy[i]);
+        expect_in_sync(results);
+        EXPECT_LE(results.max_delay_us, FBUS_UPLINK_SEND_DELAY_MAX_US+load.isr_us+load.provider_us);
+        skipped[i] = results.skipped_ratio();
+        RecordProperty("skipped_percent_busy_" + std::to_string(static_cast<int>(100*busy[i])), static_cast<int>(100*skipped[i]));
+
+        // Skipped when the burst at the downlink runs past the window, or the
+        // one at the control frame before it runs past the downlink and the window
+        auto burst_past = [&](double us) { return busy[i]*std::max(0.0, 1.0-us/load.burst_us); };
+        double window = FBUS_UPLINK_SEND_DELAY_MAX_US;
+        double expected = (1.0-burst_past(DOWNLINK_US))*burst_past(window)+burst_past(DOWNLINK_US+window);
+        EXPECT_NEAR(skipped[i], expected, 0.03);
+    }
+    EXPECT_EQ(skipped.front(), 0.0);
+    EXPECT_TRUE(std::is_sorted(skipped.begin(), skipped.end()));
+}
+
+
+TEST(FBus2Link, slow_provider)
+{
+    // The value is only fetched once the window check has passed, so a
+    // provider that takes as long as the slot sends every uplink too late
+    Stream::LoadModel load;
+    load.provider_us = FBUS_UPLINK_SEND_TIMEOUT_US;
+    Stream::LinkSimulator sim { {}, load };
+    auto results = sim.run(CYCLES);
+
+    EXPECT_EQ(results.control, results.cycles);
+    EXPECT_EQ(results.sent, CYCLES/2);
+    EXPECT_EQ(results.skipped, 0u);
+    EXPECT_EQ(results.late, results.sent);
+}
+
+
+TEST(FBus2Link, rx_stamp_lag)
+{
+    // The window is measured from the ISR stamp, so the lag from the end of
+    // the byte to the stamp comes on top. There is room for a bit of it...
+    int64_t margin = FBUS_UPLINK_SEND_TIMEOUT_US-FBUS_UPLINK_SEND_DELAY_MAX_US-UPLINK_US;
+    ASSERT_GT(margin, 0);
+
+    Stream::LoadModel load;
+    load.busy = 1.0;
+    load.burst_us = 3000;
+    load.isr_us = margin-10;
+    {
+        Stream::LinkSimulator sim { {}, load };
+        auto results = sim.run(CYCLES);
+        expect_in_sync(results);
+        EXPECT_GT(results.sent, 0u);
+        EXPECT_GT(results.skipped, 0u);
+    }
+
+    // ...but not much more, uplinks sent late in the window miss the slot
+    load.isr_us = margin+200;
+    {
+        Stream::LinkSimulator sim { {}, load };
+        auto results = sim.run(CYCLES);
+        EXPECT_GT(results.late, 0u);
+        EXPECT_LT(results.late, results.sent);
+    }
+}
+
+
+TEST(FBus2Link, failsafe_on_silence)
+{
+    constexpr int64_t FAILSAFE_US { 50000 };
+    constexpr uint SILENCES { 200 };
+
+    // Not a multiple of the tick, so the line goes silent at every phase of it
+    Stream::TransmitterModel tx;
+    tx.period_us = 8250;
+    Stream::LoadModel load;
+    load.busy = 0.5;
+    load.burst_us = 2000;
+    Stream::LinkSimulator sim { tx, load };
+    sim.receiver().set_failsafe_timeout(FAILSAFE_US);
+
+    int64_t worst = 0;
+    for (uint n=0; n<SILENCES; ++n) {
+        expect_in_sync(sim.run(3+n%7));
+        ASSERT_TRUE(sim.receiver().connected());
+
+        int64_t stopped = sim.silence(2*FAILSAFE_US);
+        ASSERT_GE(stopped, FAILSAFE_US);
+        EXPECT_FALSE(sim.receiver().connected());
+        EXPECT_TRUE(sim.receiver().delivered().flags().frameLost());
+        worst = std::max(worst, stopped);
+    }
+    EXPECT_EQ(sim.receiver().n_failsafes(), SILENCES);
+
+    // The deadline, from the ISR stamp, then at most a tick and a wakeup late
+    EXPECT_LE(worst, FAILSAFE_US+load.isr_us+Stream::LinkSimulator::TICK_US+load.wake_us+load.burst_us);
+    RecordProperty("worst_failsafe_us", worst);
+}
+
+
+TEST(FBus2Link, failsafe_short_gap)
+{
+    constexpr int64_t FAILSAFE_US { 50000 };
+    Stream::TransmitterModel tx;
+    Stream::LinkSimulator sim { tx, {} };
+    sim.receiver().set_failsafe_timeout(FAILSAFE_US);
+
+    expect_in_sync(sim.run(10));
+    EXPECT_EQ(sim.silence(FAILSAFE_US-2*tx.period_us), -1);
+    expect_in_sync(sim.run(10));
+    EXPECT_TRUE(sim.receiver().connected());
+    EXPECT_EQ(sim.receiver().n_failsafes(), 0u);
+}
@@ -0,0 +1,115 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <fbus2/mapping.h>
+#include <fbus2/receiver_host.h>
+#include <fbus2/recorder.h>
+
+#include "fbus2_stream.h"
+#include "fbus2_reference.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+
+static void expect_same(const TaranisX9DPlus &mapping, const Stream::ReferenceTaranisX9DPlus &reference)
+{
+    EXPECT_EQ(mapping.left_x(), reference.left_x);
+    EXPECT_EQ(mapping.left_y(), reference.left_y);
+    EXPECT_EQ(mapping.right_x(), reference.right_x);
+    EXPECT_EQ(mapping.right_y(), reference.right_y);
+    EXPECT_EQ(mapping.s1(), reference.s1);
+    EXPECT_EQ(mapping.s2(), reference.s2);
+    EXPECT_EQ(mapping.slider_l(), reference.slider_l);
+    EXPECT_EQ(mapping.slider_r(), reference.slider_r);
+    EXPECT_EQ(mapping.sa(), reference.sa);
+    EXPECT_EQ(mapping.sb(), reference.sb);
+    EXPECT_EQ(mapping.sc(), reference.sc);
+    EXPECT_EQ(mapping.sd(), reference.sd);
+    EXPECT_EQ(mapping.se(), reference.se);
+    EXPECT_EQ(mapping.sf(), reference.sf);
+    EXPECT_EQ(mapping.sg(), reference.sg);
+    EXPECT_EQ(mapping.sh(), reference.sh);
+    EXPECT_EQ(mapping.si(), reference.si);
+}
+
+
+TEST(FBus2Mapping, initial_values)
+{
+    TaranisX9DPlus mapping;
+    Stream::ReferenceTaranisX9DPlus reference;
+    expect_same(mapping, reference);
+}
+
+
+TEST(FBus2Mapping, control_groups)
+{
+    EXPECT_EQ(TaranisX9DPlus::STICKS,   0b1111u << 0);
+    EXPECT_EQ(TaranisX9DPlus::DIALS,    0b11u << 4);
+    EXPECT_EQ(TaranisX9DPlus::SLIDERS,  0b11u << 6);
+    EXPECT_EQ(TaranisX9DPlus::SWITCHES, 0b111u << 8);
+}
+
+
+TEST(FBus2Mapping, every_switch_value)
+{
+    // Every value the wire can carry on the switch channels
+    TaranisX9DPlus mapping;
+    Stream::ReferenceTaranisX9DPlus reference;
+    Channels channels;
+    for (uint value=0; value<=FBUS_CHANNEL_MASK; ++value) {
+        for (size_t n=0; n<channels.count(); ++n) {
+            channels.set_channel(n, static_cast<ChannelValue::raw_type>((value+n*131) & FBUS_CHANNEL_MASK));
+        }
+        mapping.set(channels);
+        reference.set(channels);
+        SCOPED_TRACE(value);
+        expect_same(mapping, reference);
+        if (HasFailure()) break;
+    }
+}
+
+
+/**
+ * @brief Maps every delivered frame both ways
+ */
+class MappingReceiver : public ReceiverHost {
+    public:
+        using ReceiverHost::ReceiverHost;
+
+        TaranisX9DPlus m_mapping;
+        Stream::ReferenceTaranisX9DPlus m_reference;
+        uint m_mismatches { 0 };
+
+    protected:
+        virtual void on_data(const channels_type &channels, ChangeMask changes) override
+        {
+            ReceiverHost::on_data(channels, changes);
+            m_mapping.set(channels);
+            m_reference.set(channels);
+            expect_same(m_mapping, m_reference);
+        }
+};
+
+
+TEST(FBus2Mapping, recorded_frames)
+{
+    constexpr uint CYCLES { 500 };
+    static StaticRecorder<256*1024> recorder { FBus2Protocol::LINE.baudrate };
+
+    auto stream = Stream::make_stream(CYCLES, 16);
+    Stream::corrupt(stream, 0.01);
+    {
+        ReceiverHost rx;
+        rx.set_recorder(&recorder, false);
+        rx.init();
+        rx.feed(stream);
+    }
+    std::vector<uint8_t> log;
+    recorder.dump([&](const uint8_t *data, size_t len) { log.insert(log.end(), data, data+len); });
+
+    MappingReceiver rx;
+    rx.init();
+    rx.replay(RecordReader { log.data(), log.size() });
+    EXPECT_GT(rx.n_data(), CYCLES/2);
+}
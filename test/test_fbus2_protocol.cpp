@@ -0,0 +1,217 @@
+#include <array>
+#include <random>
+#include <algorithm>
+#include <math.h>
+#include <gtest/gtest.h>
+
+#include <fbus2/channels.h>
+#include <fbus2/ringbuffer.h>
+#include <fbus2/checksum.h>
+
+#include "fbus2_stream.h"
+#include "fbus2_reference.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+using values_type = std::array<uint16_t, Channels::MAX_CHANNELS>;
+
+
+static Stream::stream_type make_control(size_t nchannels, std::mt19937 &rng, values_type &values)
+{
+    std::uniform_int_distribution<uint16_t> value { 0, FBUS_CHANNEL_MASK };
+    for (auto &v : values) {
+        v = value(rng);
+    }
+    Stream::stream_type frame;
+    Stream::append_control(frame, nchannels, values.data());
+    return frame;
+}
+
+
+TEST(FBus2Protocol, channel_positions)
+{
+    static_assert(fbus_channel_pos<0>::BYTE==0 && fbus_channel_pos<0>::SHIFT==0 && !fbus_channel_pos<0>::WIDE);
+    static_assert(fbus_channel_pos<2>::BYTE==2 && fbus_channel_pos<2>::SHIFT==6 && fbus_channel_pos<2>::WIDE);
+    static_assert(fbus_channel_pos<7>::BYTE==9 && fbus_channel_pos<7>::SHIFT==5 && !fbus_channel_pos<7>::WIDE);
+    static_assert(fbus_channel_pos<8>::BYTE==FBUS_CONTROL_8_VALUE_SIZE && fbus_channel_pos<8>::SHIFT==0);
+    static_assert(fbus_channel_pos<23>::BYTE+1==3*FBUS_CONTROL_8_VALUE_SIZE-1);
+    SUCCEED();
+}
+
+
+TEST(FBus2Protocol, unpack_matches_reference)
+{
+    std::mt19937 rng { 1 };
+
+    for (size_t nchannels : { 8u, 16u, 24u }) {
+        for (uint i=0; i<1000; ++i) {
+            values_type values;
+            auto frame = make_control(nchannels, rng, values);
+
+            values_type expected {};
+            values_type actual {};
+            Stream::reference_control_channels<uint16_t>(frame, nchannels, expected);
+            auto count = fbus_control_channels<uint16_t>(frame, actual);
+
+            ASSERT_EQ(count, nchannels);
+            for (size_t ch=0; ch<nchannels; ++ch) {
+                ASSERT_EQ(actual[ch], expected[ch]) << "nchannels=" << nchannels << " ch=" << ch;
+                ASSERT_EQ(actual[ch], values[ch]) << "nchannels=" << nchannels << " ch=" << ch;
+            }
+        }
+    }
+}
+
+
+TEST(FBus2Protocol, unpack_extremes)
+{
+    for (uint16_t v : { 0x000, 0x001, 0x400, 0x7FE, 0x7FF }) {
+        values_type values;
+        values.fill(v);
+        Stream::stream_type frame;
+        Stream::append_control(frame, 24, values.data());
+
+        values_type actual {};
+        fbus_control_channels<uint16_t>(frame, actual);
+        for (size_t ch=0; ch<24; ++ch) {
+            EXPECT_EQ(actual[ch], v) << "ch=" << ch;
+        }
+    }
+}
+
+
+TEST(FBus2Protocol, unpack_into_channels_from_ring_window)
+{
+    std::mt19937 rng { 2 };
+    RingBuffer<uint8_t, 64> window;
+
+    // Walk the frames around the ring, so they wrap at every possible offset
+    for (uint i=0; i<200; ++i) {
+        values_type values;
+        auto frame = make_control(24, rng, values);
+        window.push(frame.data(), frame.size());
+
+        Channels channels;
+        channels.set_count(fbus_control_channel_count(frame[0]));
+        auto count = fbus_control_channels<ChannelValue::raw_type>(window.view(), channels);
+        ASSERT_EQ(count, 24u);
+        for (size_t ch=0; ch<count; ++ch) {
+            ASSERT_EQ(channels[ch].raw(), values[ch]) << "i=" << i << " ch=" << ch;
+        }
+        window.pop(frame.size());
+    }
+}
+
+
+TEST(FBus2Protocol, invalid_size)
+{
+    Stream::stream_type frame(40, 0x00);
+    frame[0] = 0x10;
+    values_type actual {};
+    EXPECT_EQ(fbus_control_channels<uint16_t>(frame, actual), 0u);
+}
+
+
+TEST(FBus2Protocol, checksum_tracker_matches_checksum)
+{
+    std::mt19937 rng { 3 };
+    std::uniform_int_distribution<int> value { 0, 0xFF };
+    std::uniform_int_distribution<size_t> length { 0, 40 };
+
+    ChecksumTracker<256> tracker;
+    Stream::stream_type stream;
+
+    // Run well past the tracker size and the 16 bit sums, so both wrap
+    for (uint i=0; i<100000; ++i) {
+        uint8_t b = (i % 7)==0 ? 0xFF : value(rng);
+        stream.push_back(b);
+        tracker.push(b);
+
+        auto len = std::min(length(rng), stream.size());
+        auto begin = stream.size()-len;
+        ASSERT_EQ(tracker.checksum(begin, len), fbus_checksum(stream, begin, len)) << "i=" << i << " len=" << len;
+    }
+}
+
+
+TEST(FBus2Protocol, checksum_tracker_dropped_byte)
+{
+    ChecksumTracker<256> tracker;
+    Stream::stream_type stream { 0x10, 0x20 };
+    tracker.push(0x10);
+    tracker.prepare(0x99); // Never committed, like a byte dropped by the ISR
+    tracker.push(0x20);
+
+    EXPECT_EQ(tracker.pos(), 2u);
+    EXPECT_EQ(tracker.checksum(0, 2), fbus_checksum(stream, 0, 2));
+}
+
+
+TEST(FBus2Protocol, checksum_fold)
+{
+    Stream::stream_type zero(10, 0x00);
+    Stream::stream_type ones(255, 0xFF);
+    EXPECT_EQ(ChecksumTracker<256>::fold(0), fbus_checksum(zero, 0, zero.size()));
+    EXPECT_EQ(ChecksumTracker<256>::fold(255*0xFF), fbus_checksum(ones, 0, ones.size()));
+}
+
+
+TEST(FBus2Protocol, checksum_tracker_chunks)
+{
+    std::mt19937 rng { 4 };
+    std::uniform_int_distribution<int> value { 0, 0xFF };
+    std::uniform_int_distribution<size_t> length { 1, 16 };
+
+    ChecksumTracker<256> bytewise;
+    ChecksumTracker<256> chunked;
+    Stream::stream_type stream;
+
+    // Chunks as handed over by the DMA rx, with a dropped tail now and then
+    for (uint i=0; i<10000; ++i) {
+        Stream::stream_type chunk(length(rng));
+        for (auto &b : chunk) {
+            b = value(rng);
+        }
+        size_t sent = (i % 5)==0 ? chunk.size()/2 : chunk.size();
+        chunked.prepare(chunk.data(), chunk.size());
+        chunked.commit(sent);
+        for (size_t n=0; n<sent; ++n) {
+            bytewise.push(chunk[n]);
+            stream.push_back(chunk[n]);
+        }
+
+        ASSERT_EQ(chunked.pos(), bytewise.pos());
+        auto len = std::min<size_t>(40, stream.size());
+        auto begin = stream.size()-len;
+        ASSERT_EQ(chunked.checksum(begin, len), fbus_checksum(stream, begin, len)) << "i=" << i;
+    }
+}
+
+
+TEST(FBus2Protocol, servo_pulse_table)
+{
+    static_assert(ChannelValue::SERVO_PULSE_TABLE.front()==ChannelValue::SERVO_MIN);
+    static_assert(ChannelValue::SERVO_PULSE_TABLE.back()==ChannelValue::SERVO_MAX);
+    for (uint v=ChannelValue::CHANNEL_MIN; v<=ChannelValue::CHANNEL_MAX; ++v) {
+        ASSERT_EQ(ChannelValue(v).asServoPulse(), Stream::reference_servo_pulse(v)) << "value " << v;
+    }
+    // Out of range values are clamped, and not wrapped
+    EXPECT_EQ(ChannelValue(0).asServoPulse(), ChannelValue::SERVO_MIN);
+    EXPECT_EQ(ChannelValue(FBUS_CHANNEL_MASK).asServoPulse(), ChannelValue::SERVO_MAX);
+}
+
+
+TEST(FBus2Protocol, fixed_point_channel_value)
+{
+    for (uint v=ChannelValue::CHANNEL_MIN; v<=ChannelValue::CHANNEL_MAX; ++v) {
+        ChannelValue value(v);
+        float q15 = std::clamp(Stream::reference_float(v)*32768.0f, -32768.0f, 32767.0f);
+        ASSERT_LE(fabsf(value.asQ15()-q15), 1.0f) << "value " << v;
+        ASSERT_LE(fabsf(value.asUQ16()-Stream::reference_percent(v)*65535.0f), 1.0f) << "value " << v;
+    }
+    EXPECT_EQ(ChannelValue::CENTER.asQ15(), 0);
+    EXPECT_EQ(ChannelValue::MIN.asUQ16(), 0u);
+    EXPECT_EQ(ChannelValue::MAX.asUQ16(), 65535u);
+    EXPECT_EQ(ChannelValue(FBUS_CHANNEL_MASK).asQ15(), INT16_MAX);
+}
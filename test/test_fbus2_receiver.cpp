@@ -0,0 +1,469 @@
+#include <array>
+#include <random>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include <fbus2/receiver_host.h>
+
+#include "fbus2_stream.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+// Largest frame the receiver waits for, anything less may be left pending
+static constexpr size_t MAX_PENDING { FBUS_CONTROL_HDR_SIZE+FBUS_CONTROL_24CH_SIZE+1 };
+
+/**
+ * @brief ReceiverHost on a clock the test moves
+ */
+class ManualClockReceiver : public ReceiverHost {
+    public:
+        static constexpr int64_t SYNC_TIMEOUT_US { SYNC_TIMEOUT };
+
+        void advance(int64_t us) { m_clock_us += us; }
+
+    protected:
+        virtual absolute_time_t now() const override { return from_us_since_boot(m_clock_us); }
+
+    private:
+        uint64_t m_clock_us { 1000000 };
+};
+
+
+static uint16_t cycle_value(uint seq, size_t ch)
+{
+    return 172 + (seq*7 + ch*61) % 1640;
+}
+
+static void expect_cycle_channels(const ReceiverHost &rx, uint seq, size_t nchannels)
+{
+    auto channels = rx.channels();
+    ASSERT_EQ(channels.count(), nchannels);
+    for (size_t ch=0; ch<nchannels; ++ch) {
+        EXPECT_EQ(channels[ch].raw(), cycle_value(seq, ch)) << "seq=" << seq << " ch=" << ch;
+    }
+}
+
+/**
+ * @brief Feed stream in random sized chunks, and check that the receiver never stalls
+ *
+ * Each step either consumes data or moves to a state that will, so the number
+ * of steps is bounded by the size of the stream.
+ */
+static void feed_chunked(ReceiverHost &rx, const Stream::stream_type &stream, uint seed)
+{
+    std::mt19937 rng { seed };
+    std::uniform_int_distribution<size_t> chunk { 1, 200 };
+
+    size_t pos = 0;
+    while (pos<stream.size()) {
+        size_t len = std::min(chunk(rng), stream.size()-pos);
+        rx.feed(stream.data()+pos, len);
+        pos += len;
+        ASSERT_LT(rx.rx_pending(), MAX_PENDING) << "pos=" << pos;
+    }
+    EXPECT_LE(rx.n_steps(), 3*stream.size()) << "Receiver made too many steps without consuming data";
+}
+
+
+TEST(FBus2Receiver, clean_stream)
+{
+    constexpr uint CYCLES { 1000 };
+    ReceiverHost rx;
+    rx.init();
+
+    auto stream = Stream::make_stream(CYCLES, 16);
+    rx.feed(stream);
+
+    EXPECT_EQ(rx.n_control_packets(), CYCLES);
+    EXPECT_EQ(rx.n_data(), CYCLES);
+    EXPECT_TRUE(rx.sync());
+    EXPECT_TRUE(rx.connected());
+    EXPECT_EQ(rx.rssi(), 100);
+    EXPECT_EQ(rx.state(), ReceiverHost::State::READ_CONTROL);
+    EXPECT_EQ(rx.rx_pending(), 0u);
+    EXPECT_TRUE(rx.tx_data().empty());
+    expect_cycle_channels(rx, CYCLES-1, 16);
+}
+
+
+TEST(FBus2Receiver, channel_counts)
+{
+    for (size_t nchannels : { 8u, 16u, 24u }) {
+        ReceiverHost rx;
+        rx.init();
+
+        auto stream = Stream::make_stream(10, nchannels);
+        rx.feed(stream);
+
+        EXPECT_EQ(rx.n_control_packets(), 10u) << "channels=" << nchannels;
+        expect_cycle_channels(rx, 9, nchannels);
+    }
+}
+
+
+TEST(FBus2Receiver, chunked_stream)
+{
+    constexpr uint CYCLES { 1000 };
+    ReceiverHost rx;
+    rx.init();
+
+    auto stream = Stream::make_stream(CYCLES, 24);
+    feed_chunked(rx, stream, 42);
+
+    EXPECT_EQ(rx.n_control_packets(), CYCLES);
+    expect_cycle_channels(rx, CYCLES-1, 24);
+}
+
+
+TEST(FBus2Receiver, lost_sync)
+{
+    ManualClockReceiver rx;
+    rx.init();
+
+    auto stream = Stream::make_stream(10, 16);
+    rx.feed(stream);
+    ASSERT_EQ(rx.n_data(), 10u);
+    ASSERT_TRUE(rx.delivered().sync());
+
+    // Noise until sync has been lost for SYNC_TIMEOUT
+    Stream::stream_type noise(2*MAX_PENDING, 0x00);
+    rx.feed(noise);
+    EXPECT_EQ(rx.n_data(), 10u);
+    rx.advance(ManualClockReceiver::SYNC_TIMEOUT_US+1);
+    rx.feed(noise);
+
+    // Delivered as the link going down, without a control frame
+    EXPECT_EQ(rx.n_control_packets(), 10u);
+    EXPECT_EQ(rx.n_data(), 11u);
+    EXPECT_TRUE(rx.last_changes().link());
+    EXPECT_FALSE(rx.delivered().sync());
+    EXPECT_TRUE(rx.delivered().flags().frameLost());
+    EXPECT_FALSE(rx.connected());
+
+    // Only once
+    rx.advance(ManualClockReceiver::SYNC_TIMEOUT_US+1);
+    rx.feed(noise);
+    EXPECT_EQ(rx.n_data(), 11u);
+
+    // And back up with the next frames
+    rx.feed(Stream::make_stream(2, 16));
+    EXPECT_EQ(rx.n_data(), 13u);
+    EXPECT_TRUE(rx.delivered().sync());
+    EXPECT_TRUE(rx.connected());
+}
+
+
+TEST(FBus2Receiver, uplink_reply)
+{
+    ReceiverHost rx;
+    rx.init();
+    rx.set_telemetry({ .app_id = FRDID_RPM_FIRST_ID, .data = 0x12345678 });
+
+    Stream::stream_type stream;
+    std::array<uint16_t, 16> values;
+    values.fill(ChannelValue::CHANNEL_CENTER);
+    Stream::append_control(stream, values.size(), values.data());
+    Stream::append_downlink(stream, Receiver::RECEIVER_ID);
+    rx.feed(stream);
+
+    EXPECT_EQ(rx.n_telemetry_sent(), 1u);
+    EXPECT_EQ(rx.n_telemetry_skipped(), 0u);
+    EXPECT_EQ(rx.state(), ReceiverHost::State::READ_UPLINK);
+    EXPECT_GE(rx.uplink_latency_us(), 0);
+    EXPECT_LT(rx.uplink_latency_us(), FBUS_UPLINK_SEND_DELAY_MAX_US);
+    EXPECT_EQ(rx.max_uplink_latency_us(), rx.uplink_latency_us());
+
+    auto &tx = rx.tx_data();
+    ASSERT_EQ(tx.size(), FBUS_UPLINK_SIZE);
+    EXPECT_EQ(tx[0], FBUS_UPLINK_HDR);
+    EXPECT_EQ(tx[1], Receiver::RECEIVER_ID);
+    EXPECT_EQ(tx[2], FBUS_UPLINK_DATA_FRAME);
+    EXPECT_EQ(tx[3] | tx[4]<<8, FRDID_RPM_FIRST_ID);
+    EXPECT_EQ(fbus_checksum(tx, FBUS_UPLINK_HDR_SIZE, tx[0]), fbus_uplink_crc(tx));
+
+    // Our own uplink is echoed back on the half duplex line, and should be skipped
+    Stream::stream_type next { tx };
+    Stream::append_control(next, values.size(), values.data());
+    rx.feed(next);
+    EXPECT_EQ(rx.n_control_packets(), 2u);
+    EXPECT_EQ(rx.state(), ReceiverHost::State::READ_DOWNLINK);
+}
+
+
+/**
+ * @brief Receiver with a telemetry provider that takes delay_us to answer for one sensor id
+ */
+class SlowIdReceiver : public ReceiverHost {
+    public:
+        SlowIdReceiver(uint8_t slow_id, int64_t delay_us) : m_slow_id { slow_id }, m_delay_us { delay_us } {}
+
+    protected:
+        virtual Telemetry get_next_telemetry(uint8_t sensor_id) override
+        {
+            if (sensor_id==m_slow_id) {
+                busy_wait_us(m_delay_us);
+            }
+            return ReceiverHost::get_next_telemetry(sensor_id);
+        }
+
+    private:
+        const uint8_t m_slow_id;
+        const int64_t m_delay_us;
+};
+
+
+TEST(FBus2Receiver, sensor_ids)
+{
+    static_assert(Receiver::physical_id(0)==0x00);
+    static_assert(Receiver::physical_id(2)==0x22);
+    static_assert(Receiver::physical_id(0x1B)==0x1B);
+
+    const std::array<uint8_t, 3> ids { Receiver::physical_id(10), Receiver::physical_id(11), Receiver::RECEIVER_ID };
+    SlowIdReceiver rx { ids[1], FBUS_UPLINK_SEND_DELAY_MAX_US+500 };
+    rx.set_sensor_ids(ids.data(), ids.size());
+    rx.init();
+    rx.set_telemetry(Telemetry::rpm(0, 1000.0f));
+
+    std::array<uint16_t, 16> values;
+    values.fill(ChannelValue::CHANNEL_CENTER);
+    std::array<uint, 3> sent {};
+    std::array<uint, 3> skipped {};
+    std::array<int64_t, 3> max_latency {};
+
+    // The poll cycle goes through every physical id
+    for (uint cycle=0; cycle<2*0x1C; ++cycle) {
+        uint8_t poll = Receiver::physical_id(cycle % 0x1C);
+        Stream::stream_type stream;
+        Stream::append_control(stream, values.size(), values.data());
+        Stream::append_downlink(stream, poll);
+
+        rx.clear_tx_data();
+        uint n_sent = rx.n_telemetry_sent();
+        uint n_skipped = rx.n_telemetry_skipped();
+        rx.feed(stream);
+
+        auto it = std::find(ids.begin(), ids.end(), poll);
+        if (it==ids.end()) {
+            ASSERT_TRUE(rx.tx_data().empty()) << "answered id " << int(poll);
+            ASSERT_EQ(rx.n_telemetry_sent()+rx.n_telemetry_skipped(), n_sent+n_skipped);
+            continue;
+        }
+        size_t n = it-ids.begin();
+        EXPECT_EQ(rx.last_telemetry_id(), poll);
+        max_latency[n] = std::max(max_latency[n], rx.uplink_latency_us());
+        if (rx.n_telemetry_sent()>n_sent) {
+            sent[n]++;
+            auto &tx = rx.tx_data();
+            ASSERT_EQ(tx.size(), FBUS_UPLINK_SIZE);
+            EXPECT_EQ(tx[1], poll);
+            EXPECT_EQ(fbus_checksum(tx, FBUS_UPLINK_HDR_SIZE, tx[0]), fbus_uplink_crc(tx));
+        }
+        else {
+            ASSERT_EQ(rx.n_telemetry_skipped(), n_skipped+1);
+            EXPECT_TRUE(rx.tx_data().empty());
+            skipped[n]++;
+        }
+
+        // The uplink is echoed back
+        Stream::stream_type echo { rx.tx_data() };
+        rx.feed(echo);
+    }
+
+    // Each id answered in its own slot, within the window. The provider is
+    // only called once the window check has passed, so the slow one is
+    // answered too, just late on the line
+    for (size_t n=0; n<ids.size(); ++n) {
+        EXPECT_EQ(sent[n], 2u) << "id " << int(ids[n]);
+        EXPECT_EQ(skipped[n], 0u);
+        EXPECT_LT(max_latency[n], FBUS_UPLINK_SEND_DELAY_MAX_US);
+        RecordProperty("max_latency_us_" + std::to_string(ids[n]), max_latency[n]);
+    }
+    EXPECT_EQ(rx.n_control_packets(), 2u*0x1C);
+}
+
+
+TEST(FBus2Receiver, fuzz_corrupted)
+{
+    constexpr uint CYCLES { 2000 };
+    constexpr uint TAIL_CYCLES { 20 };
+
+    for (uint seed=0; seed<20; ++seed) {
+        for (double fraction : { 0.001, 0.01, 0.1, 0.5 }) {
+            ReceiverHost rx;
+            rx.init();
+
+            auto stream = Stream::make_stream(CYCLES, 16);
+            Stream::corrupt(stream, fraction, seed);
+            feed_chunked(rx, stream, seed);
+
+            // Recover once the stream is clean again
+            auto control_packets = rx.n_control_packets();
+            Stream::stream_type tail;
+            for (uint i=0; i<TAIL_CYCLES; ++i) {
+                Stream::append_cycle(tail, 16, i);
+            }
+            rx.feed(tail);
+            EXPECT_GE(rx.n_control_packets()-control_packets, TAIL_CYCLES-2) << "seed=" << seed << " fraction=" << fraction;
+            expect_cycle_channels(rx, TAIL_CYCLES-1, 16);
+        }
+    }
+}
+
+
+TEST(FBus2Receiver, fuzz_random)
+{
+    for (uint seed=0; seed<20; ++seed) {
+        ReceiverHost rx;
+        rx.init();
+
+        std::mt19937 rng { seed };
+        std::uniform_int_distribution<int> value { 0, 0xFF };
+        Stream::stream_type stream(100000);
+        for (auto &b : stream) {
+            // Bias towards header bytes, to get deeper into the state machine
+            b = (value(rng) & 0x03) ? value(rng) : FBUS_CONTROL_HDR;
+        }
+        feed_chunked(rx, stream, seed);
+    }
+}
+
+
+TEST(FBus2Receiver, stats)
+{
+    if (!ReceiverStats::ENABLED) {
+        GTEST_SKIP() << "Compiled without FBUS2_STATS";
+    }
+
+    constexpr uint CYCLES { 200 };
+    ReceiverHost rx;
+    rx.init();
+
+    auto stream = Stream::make_stream(CYCLES, 16);
+    rx.feed(stream);
+
+    auto &stats = rx.stats();
+    EXPECT_EQ(stats.sync().count(), 1u);
+    EXPECT_EQ(stats.parse_latency().count(), CYCLES);
+    EXPECT_EQ(stats.interval().count(), CYCLES-1);
+    EXPECT_EQ(stats.jitter().total(), CYCLES-2);
+    EXPECT_EQ(stats.crc_failures(FrameType::CONTROL), 0u);
+    EXPECT_EQ(stats.crc_failures(FrameType::DOWNLINK), 0u);
+    EXPECT_EQ(stats.crc_failures(FrameType::UPLINK), 0u);
+    EXPECT_GT(stats.rx_high_water(), 0u);
+
+    // A broken downlink, and the receiver has to sync again
+    Stream::stream_type bad;
+    std::array<uint16_t, 16> values;
+    values.fill(ChannelValue::CHANNEL_CENTER);
+    Stream::append_control(bad, values.size(), values.data());
+    Stream::append_downlink(bad, Receiver::RECEIVER_ID);
+    bad.back() ^= 0xFF;
+    rx.feed(bad);
+    rx.feed(Stream::make_stream(10, 16));
+
+    EXPECT_EQ(stats.crc_failures(FrameType::DOWNLINK), 1u);
+    EXPECT_EQ(stats.sync().count(), 2u);
+    EXPECT_EQ(stats.uplink_latency().count(), 0u);
+
+    rx.reset_stats();
+    EXPECT_EQ(stats.parse_latency().count(), 0u);
+}
+
+
+TEST(FBus2Receiver, frame_rx_time)
+{
+    if (!ReceiverStats::ENABLED) {
+        GTEST_SKIP() << "Compiled without FBUS2_STATS";
+    }
+
+    ManualClockReceiver rx;
+    rx.init();
+    rx.feed(Stream::make_stream(3, 16));
+    rx.reset_stats();
+
+    // Two frames queued before the receiver gets to them, each keeps its own time
+    auto start = to_us_since_boot(rx.channels().time());
+    Stream::stream_type first;
+    Stream::stream_type second;
+    Stream::append_cycle(first, 16, 3);
+    Stream::append_cycle(second, 16, 4);
+    ASSERT_EQ(rx.push(first.data(), first.size(), from_us_since_boot(start+1000)), first.size());
+    ASSERT_EQ(rx.push(second.data(), second.size(), from_us_since_boot(start+10000)), second.size());
+    rx.advance(12000);
+    rx.poll();
+
+    auto &stats = rx.stats();
+    EXPECT_EQ(rx.n_control_packets(), 5u);
+    EXPECT_EQ(to_us_since_boot(rx.channels().time()), start+10000);
+    EXPECT_EQ(stats.interval().count(), 2u);
+    EXPECT_EQ(stats.interval().min(), 1000);
+    EXPECT_EQ(stats.interval().max(), 9000);
+    EXPECT_EQ(stats.parse_latency().min(), 2000);
+    EXPECT_EQ(stats.parse_latency().max(), 11000);
+}
+
+
+TEST(FBus2ChangeTracker, deadband)
+{
+    ChangeTracker tracker;
+    tracker.set_deadband(1, 10);
+
+    Channels channels;
+    channels.set_sync(true);
+    channels.set_flags(0x00);
+    EXPECT_EQ(tracker.update(channels).value(), ChangeMask::ALL);
+    EXPECT_TRUE(tracker.update(channels).none());
+
+    // Jitter within the deadband
+    channels[0] = ChannelValue::CHANNEL_CENTER+ChangeTracker::DEFAULT_DEADBAND;
+    channels[1] = ChannelValue::CHANNEL_CENTER-10;
+    EXPECT_TRUE(tracker.update(channels).none());
+
+    channels[1] = ChannelValue::CHANNEL_CENTER+11;
+    EXPECT_EQ(tracker.update(channels).value(), ChangeMask::channel_bit(1));
+
+    // A slow drift is reported once it adds up
+    uint changes = 0;
+    for (uint i=1; i<=30; ++i) {
+        channels[2] = ChannelValue::CHANNEL_CENTER+i;
+        changes += tracker.update(channels).channel(2);
+    }
+    EXPECT_EQ(changes, 30/(ChangeTracker::DEFAULT_DEADBAND+1));
+
+    channels.set_flags(Flags::FAILSAFE_MASK);
+    auto mask = tracker.update(channels);
+    EXPECT_TRUE(mask.link());
+    EXPECT_FALSE(mask.any(~ChangeMask::LINK));
+
+    // A different channel count starts over
+    channels.set_count(8);
+    EXPECT_EQ(tracker.update(channels).value(), ChangeMask::ALL);
+}
+
+
+TEST(FBus2Receiver, change_mask)
+{
+    constexpr uint FRAMES { 100 };
+    ReceiverHost rx;
+    rx.init();
+
+    std::array<uint16_t, 16> values;
+    values.fill(ChannelValue::CHANNEL_CENTER);
+    Stream::stream_type stream;
+    for (uint i=0; i<FRAMES; ++i) {
+        // Sticks at rest, with a bit of jitter
+        values[0] = ChannelValue::CHANNEL_CENTER+(i%2);
+        Stream::append_control(stream, values.size(), values.data());
+    }
+    rx.feed(stream);
+    EXPECT_EQ(rx.n_data(), FRAMES);
+    EXPECT_EQ(rx.n_changed(), 1u);
+
+    stream.clear();
+    values[3] = ChannelValue::CHANNEL_MAX;
+    Stream::append_control(stream, values.size(), values.data());
+    rx.feed(stream);
+    EXPECT_EQ(rx.n_changed(), 2u);
+    EXPECT_EQ(rx.last_changes().value(), ChangeMask::channel_bit(3));
+}
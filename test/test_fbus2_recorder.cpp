@@ -0,0 +1,164 @@
+#include <vector>
+#include <random>
+#include <gtest/gtest.h>
+
+#include <fbus2/recorder.h>
+#include <fbus2/receiver_host.h>
+
+#include "fbus2_stream.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+using log_type = std::vector<uint8_t>;
+
+static constexpr absolute_time_t START { 1000000 };
+
+
+static log_type dump(Recorder &recorder)
+{
+    log_type log;
+    size_t size = recorder.dump([&](const uint8_t *data, size_t len) {
+        log.insert(log.end(), data, data+len);
+    });
+    EXPECT_EQ(size, log.size());
+    return log;
+}
+
+
+TEST(FBus2Recorder, round_trip)
+{
+    StaticRecorder<4096> recorder { 460800, 50 };
+    const uint8_t a[] { 1, 2, 3 };
+    const uint8_t b[] { 4, 5 };
+    const uint8_t c[] { 6 };
+
+    recorder.record(a, sizeof(a), START);
+    recorder.record(b, sizeof(b), delayed_by_us(START, 20));     // Merged with a
+    recorder.record(c, sizeof(c), delayed_by_us(START, 300));
+    recorder.record(a, sizeof(a), delayed_by_us(START, 70000));  // Needs a 3 byte dt
+    EXPECT_EQ(recorder.entries(), 3u);
+    EXPECT_EQ(recorder.recorded(), 9u);
+
+    auto log = dump(recorder);
+    RecordReader reader { log.data(), log.size() };
+    ASSERT_TRUE(reader.valid());
+    EXPECT_EQ(reader.baudrate(), 460800u);
+
+    RecordReader::Entry entry;
+    ASSERT_TRUE(reader.next(entry));
+    EXPECT_EQ(entry.time, START);
+    EXPECT_EQ(log_type(entry.data, entry.data+entry.len), (log_type { 1, 2, 3, 4, 5 }));
+    ASSERT_TRUE(reader.next(entry));
+    EXPECT_EQ(entry.time, delayed_by_us(START, 300));
+    EXPECT_EQ(log_type(entry.data, entry.data+entry.len), (log_type { 6 }));
+    ASSERT_TRUE(reader.next(entry));
+    EXPECT_EQ(entry.time, delayed_by_us(START, 70000));
+    EXPECT_EQ(entry.len, sizeof(a));
+    EXPECT_FALSE(reader.next(entry));
+
+    // Truncated logs end early, and never read past the end
+    log.resize(log.size()-1);
+    RecordReader truncated { log.data(), log.size() };
+    uint n = 0;
+    while (truncated.next(entry)) {
+        n++;
+    }
+    EXPECT_EQ(n, 2u);
+}
+
+
+TEST(FBus2Recorder, overwrites_oldest)
+{
+    constexpr size_t CHUNK { 10 };
+    constexpr uint CHUNKS { 1000 };
+    StaticRecorder<2*RecordFormat::MAX_ENTRY> recorder { 460800 };
+
+    uint8_t data[CHUNK];
+    for (uint i=0; i<CHUNKS; ++i) {
+        std::fill(std::begin(data), std::end(data), static_cast<uint8_t>(i));
+        recorder.record(data, CHUNK, delayed_by_us(START, i*1000));
+    }
+    EXPECT_EQ(recorder.recorded(), CHUNKS*CHUNK);
+    EXPECT_LE(recorder.size()-RecordFormat::HEADER_SIZE, recorder.capacity());
+
+    // The newest entries are kept, with their original times
+    auto log = dump(recorder);
+    RecordReader reader { log.data(), log.size() };
+    RecordReader::Entry entry;
+    uint first = CHUNKS-recorder.entries();
+    uint n = 0;
+    size_t kept = 0;
+    while (reader.next(entry)) {
+        EXPECT_EQ(entry.time, delayed_by_us(START, (first+n)*1000)) << n;
+        EXPECT_EQ(entry.data[0], static_cast<uint8_t>(first+n)) << n;
+        kept += entry.len;
+        n++;
+    }
+    EXPECT_EQ(n, recorder.entries());
+    EXPECT_EQ(kept+recorder.overwritten(), recorder.recorded());
+}
+
+
+TEST(FBus2Recorder, frozen)
+{
+    StaticRecorder<1024> recorder { 460800 };
+    const uint8_t data[] { 1, 2, 3 };
+
+    recorder.record(data, sizeof(data), START);
+    recorder.freeze();
+    recorder.record(data, sizeof(data), delayed_by_us(START, 1000));
+    EXPECT_EQ(recorder.recorded(), 3u);
+    EXPECT_EQ(recorder.missed(), 3u);
+
+    // Dumping keeps it frozen, so the incident can be dumped again
+    dump(recorder);
+    EXPECT_TRUE(recorder.frozen());
+    recorder.resume();
+    recorder.record(data, sizeof(data), delayed_by_us(START, 2000));
+    EXPECT_EQ(recorder.recorded(), 6u);
+}
+
+
+/**
+ * @brief Record a noisy stream through one receiver, and replay it through another
+ */
+TEST(FBus2Recorder, replay)
+{
+    static StaticRecorder<64*1024> recorder { 460800 };
+    ReceiverHost live;
+    live.set_recorder(&recorder);
+    live.init();
+
+    auto stream = Stream::make_stream(500);
+    Stream::corrupt(stream, 0.002);
+
+    // Fed in ISR sized chunks, on a simulated clock at the line rate
+    std::mt19937 rng { 1234 };
+    std::uniform_int_distribution<size_t> chunk { 1, 16 };
+    absolute_time_t time = START;
+    for (size_t pos=0; pos<stream.size();) {
+        size_t len = std::min(chunk(rng), stream.size()-pos);
+        time = delayed_by_us(time, len*22);
+        live.feed(stream.data()+pos, len, time);
+        pos += len;
+    }
+    ASSERT_EQ(recorder.overwritten(), 0u);
+
+    auto log = dump(recorder);
+    RecordProperty("log_bytes", log.size());
+    RecordProperty("stream_bytes", stream.size());
+    // 2-3 bytes per entry, on 8 bytes of data on average
+    EXPECT_LT(log.size(), stream.size()*3/2);
+
+    ReceiverHost replayed;
+    replayed.init();
+    EXPECT_EQ(replayed.replay(RecordReader { log.data(), log.size() }), stream.size());
+
+    EXPECT_GT(live.n_control_packets(), 400u);
+    EXPECT_EQ(replayed.n_control_packets(), live.n_control_packets());
+    EXPECT_EQ(replayed.stats().crc_failures(FrameType::CONTROL), live.stats().crc_failures(FrameType::CONTROL));
+    EXPECT_EQ(replayed.stats().sync().count(), live.stats().sync().count());
+    EXPECT_EQ(replayed.channels().time(), live.channels().time());
+    EXPECT_EQ(replayed.channels().seq(), live.channels().seq());
+}
@@ -0,0 +1,164 @@
+#include <array>
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <fbus2/ringbuffer.h>
+
+using namespace FBus2;
+
+
+TEST(FBus2RingBuffer, single)
+{
+    RingBuffer<uint8_t, 8> ring;
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.capacity(), 8u);
+
+    // Every slot can be used
+    for (uint8_t i=0; i<8; ++i) {
+        EXPECT_TRUE(ring.push(i));
+    }
+    EXPECT_FALSE(ring.push(8));
+    EXPECT_EQ(ring.size(), 8u);
+    EXPECT_EQ(ring.space(), 0u);
+
+    for (uint8_t i=0; i<8; ++i) {
+        EXPECT_EQ(ring[0], i);
+        EXPECT_EQ(ring.pop(), i);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+
+TEST(FBus2RingBuffer, bulk_matches_deque)
+{
+    std::mt19937 rng { 1 };
+    std::uniform_int_distribution<size_t> length { 0, 40 };
+    RingBuffer<uint8_t, 32> ring;
+    std::deque<uint8_t> reference;
+    uint8_t next = 0;
+
+    for (uint i=0; i<10000; ++i) {
+        std::array<uint8_t, 40> data;
+        size_t len = length(rng);
+        for (size_t n=0; n<len; ++n) {
+            data[n] = next+n;
+        }
+        size_t pushed = ring.push(data.data(), len);
+        ASSERT_EQ(pushed, std::min(len, 32-reference.size()));
+        reference.insert(reference.end(), data.begin(), data.begin()+pushed);
+        next += pushed;
+
+        // Peek at an offset, across the wrap
+        if (reference.size()>=2) {
+            std::array<uint8_t, 32> peek;
+            size_t off = reference.size()/3;
+            ring.copy(peek.data(), reference.size()-off, off);
+            ASSERT_TRUE(std::equal(reference.begin()+off, reference.end(), peek.begin()));
+        }
+
+        std::array<uint8_t, 40> out;
+        size_t popped = ring.pop(out.data(), length(rng));
+        ASSERT_LE(popped, reference.size());
+        ASSERT_TRUE(std::equal(out.begin(), out.begin()+popped, reference.begin())) << "i=" << i;
+        reference.erase(reference.begin(), reference.begin()+popped);
+        ASSERT_EQ(ring.size(), reference.size());
+    }
+}
+
+
+TEST(FBus2RingBuffer, spans)
+{
+    RingBuffer<uint8_t, 16> ring;
+    std::array<uint8_t, 12> data;
+    for (size_t n=0; n<data.size(); ++n) {
+        data[n] = n;
+    }
+    ring.push(data.data(), 12);
+    ring.pop(12);
+
+    // The free space wraps, so it comes in two spans
+    uint8_t *wptr;
+    EXPECT_EQ(ring.write_span(wptr), 4u);
+    std::copy(data.begin(), data.begin()+4, wptr);
+    ring.commit(4);
+    EXPECT_EQ(ring.write_span(wptr), 12u);
+    std::copy(data.begin()+4, data.end(), wptr);
+    ring.commit(8);
+    EXPECT_EQ(ring.size(), 12u);
+
+    const uint8_t *rptr;
+    EXPECT_EQ(ring.read_span(rptr), 4u);
+    EXPECT_TRUE(std::equal(rptr, rptr+4, data.begin()));
+    ring.pop(4);
+    EXPECT_EQ(ring.read_span(rptr), 8u);
+    EXPECT_TRUE(std::equal(rptr, rptr+8, data.begin()+4));
+
+    ring.clear();
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.read_span(rptr), 0u);
+}
+
+
+TEST(FBus2RingBuffer, producer_consumer_threads)
+{
+    // A producer and a consumer on their own threads, with random chunks, see the sequence in order
+    constexpr uint32_t COUNT { 200000 };
+    static RingBuffer<uint32_t, 64> ring;
+
+    std::thread producer([]() {
+        std::mt19937 rng { 2 };
+        std::uniform_int_distribution<size_t> length { 1, 48 };
+        std::array<uint32_t, 48> data;
+        uint32_t next = 0;
+        while (next<COUNT) {
+            size_t len = std::min<size_t>(length(rng), COUNT-next);
+            for (size_t n=0; n<len; ++n) {
+                data[n] = next+n;
+            }
+            size_t pushed = ring.push(data.data(), len);
+            if (pushed==0) {
+                std::this_thread::yield();
+            }
+            next += pushed;
+        }
+    });
+
+    std::mt19937 rng { 3 };
+    std::uniform_int_distribution<int> mode { 0, 2 };
+    uint32_t expected = 0;
+    uint mismatches = 0;
+    while (expected<COUNT) {
+        if (ring.empty()) {
+            std::this_thread::yield();
+            continue;
+        }
+        switch (mode(rng)) {
+            case 0:
+                mismatches += ring.pop()!=expected++;
+                break;
+            case 1: {
+                std::array<uint32_t, 40> out;
+                size_t popped = ring.pop(out.data(), out.size());
+                for (size_t n=0; n<popped; ++n) {
+                    mismatches += out[n]!=expected++;
+                }
+                break;
+            }
+            default: {
+                const uint32_t *ptr;
+                size_t len = ring.read_span(ptr);
+                for (size_t n=0; n<len; ++n) {
+                    mismatches += ptr[n]!=expected++;
+                }
+                ring.pop(len);
+                break;
+            }
+        }
+    }
+    producer.join();
+    EXPECT_EQ(mismatches, 0u);
+    EXPECT_TRUE(ring.empty());
+}
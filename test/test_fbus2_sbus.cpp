@@ -0,0 +1,119 @@
+#include <array>
+#include <random>
+#include <gtest/gtest.h>
+
+#include <fbus2/receiver_host.h>
+#include <fbus2/protocol_sbus.h>
+
+#include "fbus2_stream.h"
+
+using namespace FBus2;
+namespace Stream = FBus2::Test;
+
+using SBusReceiver = ProtocolReceiverHost<SBusProtocol>;
+
+
+static void expect_cycle_channels(const SBusReceiver &rx, uint seq)
+{
+    auto channels = rx.channels();
+    auto values = Stream::cycle_values(seq);
+    ASSERT_EQ(channels.count(), SBUS_CHANNEL_COUNT);
+    for (size_t ch=0; ch<SBUS_CHANNEL_COUNT; ++ch) {
+        EXPECT_EQ(channels[ch].raw(), values[ch]) << "seq=" << seq << " ch=" << ch;
+    }
+}
+
+
+TEST(SBusReceiver, clean_stream)
+{
+    constexpr uint FRAMES { 1000 };
+    SBusReceiver rx { SBusProtocol::LINE };
+    rx.init();
+
+    auto stream = Stream::make_sbus_stream(FRAMES);
+    rx.feed(stream);
+
+    EXPECT_EQ(rx.n_control_packets(), FRAMES);
+    EXPECT_EQ(rx.n_data(), FRAMES);
+    EXPECT_TRUE(rx.sync());
+    EXPECT_TRUE(rx.connected());
+    EXPECT_EQ(rx.rssi(), 0);
+    EXPECT_EQ(rx.state(), SBusReceiver::State::READ_FRAME);
+    EXPECT_EQ(rx.rx_pending(), 0u);
+    EXPECT_TRUE(rx.tx_data().empty());
+    expect_cycle_channels(rx, FRAMES-1);
+}
+
+
+TEST(SBusReceiver, sync_needs_next_header)
+{
+    SBusReceiver rx { SBusProtocol::LINE };
+    rx.init();
+
+    // The tail of a frame, and a frame without the next header to confirm it
+    Stream::stream_type stream;
+    Stream::append_sbus(stream, Stream::cycle_values(0).data());
+    stream.erase(stream.begin(), stream.begin()+10);
+    Stream::append_sbus(stream, Stream::cycle_values(1).data());
+    rx.feed(stream);
+    EXPECT_EQ(rx.n_control_packets(), 0u);
+    EXPECT_EQ(rx.state(), SBusReceiver::State::SYNCING);
+
+    stream.clear();
+    Stream::append_sbus(stream, Stream::cycle_values(2).data());
+    rx.feed(stream);
+    EXPECT_EQ(rx.n_control_packets(), 2u);
+    expect_cycle_channels(rx, 2);
+    EXPECT_EQ(rx.stats().sync().count(), 1u);
+}
+
+
+TEST(SBusReceiver, flags)
+{
+    SBusReceiver rx { SBusProtocol::LINE };
+    rx.init();
+
+    auto values = Stream::cycle_values(0);
+    Stream::stream_type stream;
+    Stream::append_sbus(stream, values.data());
+    Stream::append_sbus(stream, values.data(), Flags::CH17_MASK, 0x14); // SBUS2 footer
+    Stream::append_sbus(stream, values.data(), Flags::FRAME_LOST_MASK|Flags::FAILSAFE_MASK|0xF0);
+    rx.feed(stream);
+
+    EXPECT_EQ(rx.n_control_packets(), 3u);
+    EXPECT_TRUE(rx.flags().frameLost());
+    EXPECT_TRUE(rx.flags().failsafe());
+    EXPECT_FALSE(rx.flags().ch17());
+    EXPECT_FALSE(rx.connected());
+}
+
+
+TEST(SBusReceiver, fuzz_corrupted)
+{
+    constexpr uint FRAMES { 2000 };
+    SBusReceiver rx { SBusProtocol::LINE };
+    rx.init();
+
+    auto stream = Stream::make_sbus_stream(FRAMES);
+    auto corrupted = Stream::corrupt(stream, 0.002);
+
+    // And a clean tail to end on
+    for (uint i=FRAMES; i<FRAMES+10; ++i) {
+        Stream::append_sbus(stream, Stream::cycle_values(i).data());
+    }
+
+    std::mt19937 rng { 42 };
+    std::uniform_int_distribution<size_t> chunk { 1, 100 };
+    for (size_t pos=0; pos<stream.size();) {
+        size_t len = std::min(chunk(rng), stream.size()-pos);
+        rx.feed(stream.data()+pos, len);
+        pos += len;
+        ASSERT_LE(rx.rx_pending(), SBUS_FRAME_SIZE+1) << "pos=" << pos;
+    }
+    EXPECT_LE(rx.n_steps(), 3*stream.size()) << "Receiver made too many steps without consuming data";
+
+    // Corrupted channel data can't be detected, but the frame is only lost when the header or footer is hit
+    EXPECT_GT(rx.n_control_packets(), FRAMES-2*corrupted);
+    EXPECT_GT(rx.stats().crc_failures(FrameType::CONTROL), 0u);
+    expect_cycle_channels(rx, FRAMES+9);
+}
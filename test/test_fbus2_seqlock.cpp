@@ -0,0 +1,165 @@
+#include <atomic>
+#include <gtest/gtest.h>
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <fbus2/channels.h>
+#include <fbus2/seqlock.h>
+
+using namespace FBus2;
+
+
+static ChannelValue::raw_type pattern_value(uint seq, size_t ch)
+{
+    return (seq*13 + ch*97) & 0x7FF;
+}
+
+static Channels make_channels(uint seq)
+{
+    Channels channels;
+    channels.set_seq(seq);
+    channels.set_count(Channels::MAX_CHANNELS);
+    channels.set_rssi(seq & 0xFF);
+    for (size_t ch=0; ch<channels.count(); ++ch) {
+        channels[ch] = pattern_value(seq, ch);
+    }
+    return channels;
+}
+
+/**
+ * @brief Check that a snapshot is not a mix of two published values
+ */
+static bool consistent(const Channels &channels)
+{
+    if (channels.count()!=Channels::MAX_CHANNELS || channels.rssi()!=(channels.seq() & 0xFF)) {
+        return false;
+    }
+    for (size_t ch=0; ch<channels.count(); ++ch) {
+        if (channels[ch].raw()!=pattern_value(channels.seq(), ch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+TEST(FBus2SeqLock, store_load)
+{
+    SeqLock<Channels> published;
+    EXPECT_EQ(published.seq(), 0u);
+    EXPECT_FALSE(published.load().sync());
+
+    for (uint seq=1; seq<10; ++seq) {
+        published.store(make_channels(seq));
+        EXPECT_EQ(published.seq(), seq);
+
+        Channels channels;
+        ASSERT_TRUE(published.try_load(channels));
+        EXPECT_EQ(channels.seq(), seq);
+        EXPECT_TRUE(consistent(channels));
+    }
+}
+
+
+/**
+ * @brief One writer and a few readers hammering the same SeqLock, as FreeRTOS tasks
+ *
+ * The writer runs at the highest priority, like the parser task, and is never
+ * held up by the readers. The readers are time sliced against each other and
+ * preempted by the writer in the middle of their copies, and must never see
+ * a torn snapshot, or one older than what they saw before.
+ */
+class SeqLockStress {
+    public:
+        static constexpr uint READERS { 3 };
+        static constexpr TickType_t DURATION { pdMS_TO_TICKS(2000) };
+
+        SeqLock<Channels> m_published;
+        std::atomic<bool> m_stop { false };
+
+        std::atomic<uint> m_writes { 0 };
+        std::atomic<uint> m_reads { 0 };
+        std::atomic<uint> m_retries { 0 };
+        std::atomic<uint> m_torn { 0 };
+        std::atomic<uint> m_backwards { 0 };
+
+        void run()
+        {
+            xTaskCreateStatic(+[](void *self) { static_cast<SeqLockStress*>(self)->control(); },
+                "control", configMINIMAL_STACK_SIZE, this, 4, m_control_stack, &m_control_buf);
+            xTaskCreateStatic(+[](void *self) { static_cast<SeqLockStress*>(self)->writer(); },
+                "writer", configMINIMAL_STACK_SIZE, this, 3, m_writer_stack, &m_writer_buf);
+            for (uint i=0; i<READERS; ++i) {
+                xTaskCreateStatic(+[](void *self) { static_cast<SeqLockStress*>(self)->reader(); },
+                    "reader", configMINIMAL_STACK_SIZE, this, 2, m_reader_stack[i], &m_reader_buf[i]);
+            }
+            vTaskStartScheduler();
+        }
+
+    private:
+        StaticTask_t m_control_buf;
+        StackType_t m_control_stack[configMINIMAL_STACK_SIZE];
+        StaticTask_t m_writer_buf;
+        StackType_t m_writer_stack[configMINIMAL_STACK_SIZE];
+        StaticTask_t m_reader_buf[READERS];
+        StackType_t m_reader_stack[READERS][configMINIMAL_STACK_SIZE];
+
+        void control()
+        {
+            vTaskDelay(DURATION);
+            m_stop = true;
+            vTaskDelay(pdMS_TO_TICKS(10));
+            vTaskEndScheduler();
+        }
+
+        void writer()
+        {
+            uint seq = 0;
+            while (!m_stop) {
+                // Bursts of stores, then sleep for a tick, so the readers get to run
+                for (uint i=0; i<100; ++i) {
+                    m_published.store(make_channels(++seq));
+                }
+                m_writes += 100;
+                vTaskDelay(1);
+            }
+            vTaskSuspend(nullptr);
+        }
+
+        void reader()
+        {
+            uint last = 0;
+            while (!m_stop) {
+                Channels channels;
+                if (!m_published.try_load(channels)) {
+                    m_retries++;
+                    continue;
+                }
+                if (!consistent(channels)) {
+                    m_torn++;
+                }
+                if (channels.seq()<last) {
+                    m_backwards++;
+                }
+                last = channels.seq();
+                m_reads++;
+            }
+            vTaskSuspend(nullptr);
+        }
+};
+
+
+TEST(FBus2SeqLock, stress_freertos_tasks)
+{
+    static SeqLockStress stress;
+    stress.run();
+
+    RecordProperty("writes", stress.m_writes);
+    RecordProperty("reads", stress.m_reads);
+    RecordProperty("retries", stress.m_retries);
+
+    EXPECT_GT(stress.m_writes, 0u);
+    EXPECT_GT(stress.m_reads, 0u);
+    EXPECT_EQ(stress.m_torn, 0u);
+    EXPECT_EQ(stress.m_backwards, 0u);
+}
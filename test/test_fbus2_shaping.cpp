@@ -0,0 +1,128 @@
+#include <array>
+#include <math.h>
+#include <gtest/gtest.h>
+
+#include <fbus2/shaping.h>
+#include <fbus2/receiver_host.h>
+
+#include "fbus2_stream.h"
+
+using namespace FBus2;
+using namespace FBus2::Shaping;
+namespace Stream = FBus2::Test;
+
+
+static double expo_reference(double x, double e)
+{
+    return (1.0-e)*x+e*x*x*x;
+}
+
+
+TEST(FBus2Shaping, deadband)
+{
+    Deadband<20> deadband;
+    EXPECT_EQ(deadband(0), 0);
+    EXPECT_EQ(deadband(20), 0);
+    EXPECT_EQ(deadband(-20), 0);
+    EXPECT_GT(deadband(21), 0);
+    EXPECT_LT(deadband(-21), 0);
+    // Full deflection is kept
+    EXPECT_EQ(deadband(HALF_RANGE), HALF_RANGE);
+    EXPECT_EQ(deadband(-HALF_RANGE), -HALF_RANGE);
+    // Monotonic
+    for (value_type x=-HALF_RANGE; x<HALF_RANGE; ++x) {
+        ASSERT_LE(deadband(x), deadband(x+1));
+    }
+}
+
+
+TEST(FBus2Shaping, expo_accuracy)
+{
+    constexpr uint PERCENT { 40 };
+    Expo<PERCENT> expo;
+    static_assert(Expo<PERCENT>::TABLE.front()==0);
+    static_assert(Expo<PERCENT>::TABLE.back()==HALF_RANGE);
+
+    // Table interpolation against the exact curve, to within a unit
+    double max_error = 0.0;
+    for (value_type x=-HALF_RANGE; x<=HALF_RANGE; ++x) {
+        double exact = HALF_RANGE*expo_reference(static_cast<double>(x)/HALF_RANGE, PERCENT/100.0);
+        double error = fabs(expo(x)-exact);
+        max_error = std::max(max_error, error);
+        ASSERT_LE(error, 1.0) << "x=" << x;
+        ASSERT_EQ(expo(-x), -expo(x));
+    }
+    RecordProperty("expo_max_error", std::to_string(max_error));
+
+    // No expo is linear, and the ends are clamped
+    Expo<0> linear;
+    for (value_type x=-HALF_RANGE; x<=HALF_RANGE; ++x) {
+        ASSERT_EQ(linear(x), x);
+    }
+    EXPECT_EQ(expo(HALF_RANGE+50), HALF_RANGE);
+    EXPECT_EQ(expo(-HALF_RANGE-50), -HALF_RANGE);
+}
+
+
+TEST(FBus2Shaping, rate_limit_and_low_pass)
+{
+    RateLimit<10> rate;
+    rate.reset(0);
+    EXPECT_EQ(rate(100), 10);
+    EXPECT_EQ(rate(100), 20);
+    EXPECT_EQ(rate(-100), 10);
+    EXPECT_EQ(rate(12), 12);
+
+    // Step response of a one-pole filter, alpha 1/4, and it settles exactly
+    LowPass<2> low_pass;
+    low_pass.reset(0);
+    double y = 0.0;
+    value_type out = 0;
+    for (uint i=0; i<40; ++i) {
+        y += (800.0-y)/4.0;
+        out = low_pass(800);
+        ASSERT_LE(fabs(out-y), 1.0) << "frame " << i;
+    }
+    EXPECT_EQ(out, 800);
+    for (uint i=0; i<40; ++i) {
+        out = low_pass(-300);
+    }
+    EXPECT_EQ(out, -300);
+}
+
+
+TEST(FBus2Shaping, chain_reset)
+{
+    Chain<Deadband<10>, Expo<30>, LowPass<3>> chain;
+    Chain<Deadband<10>, Expo<30>> stateless;
+    // A reset chain starts at the steady state of its input
+    chain.reset(500);
+    EXPECT_EQ(chain(500), stateless(500));
+}
+
+
+TEST(FBus2Shaping, receiver_filter)
+{
+    using filter_type = ChannelFilter<0b0011, Deadband<10>, Expo<50>, RateLimit<100>>;
+    filter_type filter;
+    ReceiverHost rx;
+    rx.set_shaper(&filter);
+    rx.init();
+
+    std::array<uint16_t, 16> values;
+    values.fill(ChannelValue::CHANNEL_CENTER+5);
+    Stream::stream_type stream;
+    Stream::append_control(stream, values.size(), values.data());
+    rx.feed(stream);
+    EXPECT_EQ(rx.delivered()[0].raw(), ChannelValue::CHANNEL_CENTER);
+    EXPECT_EQ(rx.delivered()[2].raw(), ChannelValue::CHANNEL_CENTER+5);  // Not filtered
+    // The published channels are as received
+    EXPECT_EQ(rx.channels()[0].raw(), ChannelValue::CHANNEL_CENTER+5);
+
+    // Full deflection is rate limited
+    stream.clear();
+    values[1] = ChannelValue::CHANNEL_MAX;
+    Stream::append_control(stream, values.size(), values.data());
+    rx.feed(stream);
+    EXPECT_EQ(rx.delivered()[1].raw(), ChannelValue::CHANNEL_CENTER+100);
+}
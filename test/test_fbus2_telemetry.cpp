@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <fbus2/telemetry.h>
+
+using namespace FBus2;
+
+
+/**
+ * @brief Checks an integer encoding against the float one and the exact value
+ *
+ * The integer encoding must always give the exact value. The float encoding
+ * must give the same bits, except at an exact rounding tie, where the float
+ * representation of the input decides which way it goes, and it may be one
+ * off. step is one in the encoding, for fields packed higher up.
+ */
+class EncodingCheck {
+    public:
+        EncodingCheck(const char *name) : m_name { name } {}
+
+        void check(int64_t input, Telemetry integer, Telemetry floating, int64_t exact, bool tie, int64_t step=1)
+        {
+            ASSERT_EQ(integer.app_id, floating.app_id) << m_name << " " << input;
+            ASSERT_EQ(static_cast<uint32_t>(integer.data), static_cast<uint32_t>(exact)) << m_name << " " << input;
+            if (integer.data!=floating.data) {
+                ASSERT_TRUE(tie) << m_name << " " << input;
+                // One step either way, wrapping for the top field
+                uint32_t diff = integer.data-floating.data;
+                ASSERT_TRUE(diff==static_cast<uint32_t>(step) || diff==static_cast<uint32_t>(-step)) << m_name << " " << input;
+                m_ties++;
+            }
+            m_count++;
+        }
+
+        void report()
+        {
+            // Nearly all inputs are bit identical
+            EXPECT_LT(m_ties*100, m_count) << m_name;
+            ::testing::Test::RecordProperty(std::string(m_name)+"_ties", m_ties);
+        }
+
+    private:
+        const char *m_name;
+        uint m_count { 0 };
+        uint m_ties { 0 };
+};
+
+
+TEST(FBus2Telemetry, cells)
+{
+    EncodingCheck check { "cells" };
+    for (uint32_t mv=0; mv<2*4096; ++mv) {
+        auto integer = Telemetry::cells_mv(1, 0, 2, mv, 4200);
+        auto floating = Telemetry::cells(1, 0, 2, mv/1000.0f, 4.2f);
+        int64_t exact = (mv/2 & 0x0fff) << 20 | 2100 << 8 | 2 << 4 | 1;
+        // Off by one in the first cell only
+        check.check(mv, integer, floating, exact, mv%2==0, 1 << 20);
+    }
+    check.report();
+}
+
+
+TEST(FBus2Telemetry, voltage)
+{
+    EncodingCheck a3 { "a3" };
+    EncodingCheck a4 { "a4" };
+    for (uint32_t mv=0; mv<60000; ++mv) {
+        int64_t exact = (mv+5)/10;
+        a3.check(mv, Telemetry::a3_mv(2, mv), Telemetry::a3(2, mv/1000.0f), exact, mv%10==5);
+        a4.check(mv, Telemetry::a4_mv(2, mv), Telemetry::a4(2, mv/1000.0f), exact, mv%10==5);
+    }
+    a3.report();
+    a4.report();
+}
+
+
+TEST(FBus2Telemetry, current)
+{
+    EncodingCheck check { "current" };
+    for (uint32_t ma=0; ma<200000; ++ma) {
+        check.check(ma, Telemetry::current_ma(1, ma), Telemetry::current(1, static_cast<float>(ma)), ma*10, false);
+    }
+    check.report();
+}
+
+
+TEST(FBus2Telemetry, rpm)
+{
+    constexpr uint32_t COUNTS_PER_REV { 1440 };
+    EncodingCheck check { "rpm" };
+    for (uint32_t period_us : { 1000u, 5000u, 10000u, 20000u }) {
+        for (int32_t counts=-2000; counts<=2000; ++counts) {
+            // 10*rpm+0.5 truncated, with rpm = counts*60e6/(COUNTS_PER_REV*period_us)
+            int64_t num = 2ll*counts*600000000ll+static_cast<int64_t>(COUNTS_PER_REV)*period_us;
+            int64_t den = 2ll*COUNTS_PER_REV*period_us;
+            float rpm = counts*60.0e6f/(static_cast<float>(COUNTS_PER_REV)*period_us);
+            check.check(counts, Telemetry::rpm_counts(3, counts, COUNTS_PER_REV, period_us), Telemetry::rpm(3, rpm), num/den, num%den==0);
+        }
+    }
+    check.report();
+}
+
+
+TEST(FBus2Telemetry, rpm_zero_period)
+{
+    #ifdef NDEBUG
+    EXPECT_EQ(Telemetry::rpm_counts(3, 100, 0, 10000).data, Telemetry::rpm(3, 0.0f).data);
+    EXPECT_EQ(Telemetry::rpm_counts(3, 100, 1440, 0).data, Telemetry::rpm(3, 0.0f).data);
+    EXPECT_EQ(Telemetry::rpm_counts(3, 100, 1440, 0).app_id, Telemetry::rpm(3, 0.0f).app_id);
+    #else
+    EXPECT_DEATH(Telemetry::rpm_counts(3, 100, 0, 10000), "");
+    EXPECT_DEATH(Telemetry::rpm_counts(3, 100, 1440, 0), "");
+    #endif
+}
+
+
+TEST(FBus2Telemetry, diy)
+{
+    EncodingCheck check { "diy" };
+    for (int32_t centi=-36000; centi<=36000; ++centi) {
+        check.check(centi, Telemetry::diy_centi(4, centi), Telemetry::diy(4, centi/100.0f), (centi+5)/10, centi%10==5 || centi%10==-5);
+    }
+    check.report();
+}
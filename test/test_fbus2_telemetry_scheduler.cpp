@@ -0,0 +1,121 @@
+#include <array>
+#include <gtest/gtest.h>
+
+#include <fbus2/telemetry_scheduler.h>
+
+using namespace FBus2;
+
+using Rate = TelemetryRate;
+
+
+/**
+ * @brief Run the scheduler for a number of uplink slots at a fixed slot rate
+ *
+ * @return Largest gap between two sends of each value, in us
+ */
+template<size_t N>
+static std::array<int64_t, N> run_slots(TelemetryScheduler<N> &scheduler, float slot_hz, uint slots)
+{
+    std::array<int64_t, N> last;
+    std::array<int64_t, N> max_gap {};
+    last.fill(0);
+
+    const int64_t period = static_cast<int64_t>(1.0e6f/slot_hz);
+    for (uint slot=0; slot<slots; ++slot) {
+        int64_t now = slot*period;
+        auto n = scheduler.next(now);
+        EXPECT_LT(n, N);
+        max_gap[n] = std::max(max_gap[n], now-last[n]);
+        last[n] = now;
+    }
+    return max_gap;
+}
+
+
+TEST(FBus2TelemetryScheduler, meets_target_rates)
+{
+    TelemetryScheduler<3> scheduler {{{
+        { "a", Rate::hz(10.0f), 1 },
+        { "b", Rate::hz(5.0f),  1 },
+        { "c", Rate::hz(1.0f),  1 },
+    }}};
+
+    // 100s at 50 slots/s, 16 updates/s wanted
+    auto gaps = run_slots(scheduler, 50.0f, 5000);
+    int64_t now = 5000*20000ll;
+
+    for (size_t i=0; i<scheduler.size(); ++i) {
+        EXPECT_GE(scheduler.achieved_mhz(i, now), scheduler.config(i).rate_mhz*95/100) << scheduler.config(i).name;
+    }
+    // Spare slots go to whatever is closest to due, so rates are kept in proportion
+    EXPECT_NEAR(static_cast<float>(scheduler.count(0))/scheduler.count(2), 10.0f, 1.0f);
+    EXPECT_LE(gaps[2], 1000000);
+}
+
+
+TEST(FBus2TelemetryScheduler, priority_when_oversubscribed)
+{
+    TelemetryScheduler<3> scheduler {{{
+        { "high",  Rate::hz(10.0f), 2 },
+        { "high2", Rate::hz(10.0f), 2 },
+        { "low",   Rate::hz(10.0f), 0 },
+    }}};
+
+    // 25 slots/s for 30 updates/s wanted, low gets what is left
+    run_slots(scheduler, 25.0f, 2500);
+    int64_t now = 2500*40000ll;
+
+    EXPECT_GE(scheduler.achieved_mhz(0, now), Rate::hz(9.5f));
+    EXPECT_GE(scheduler.achieved_mhz(1, now), Rate::hz(9.5f));
+    EXPECT_NEAR(scheduler.achieved_mhz(2, now), Rate::hz(5.0f), Rate::hz(0.5f));
+}
+
+
+TEST(FBus2TelemetryScheduler, urgent_value_is_not_starved)
+{
+    // Like the rover: four fast rpm values, and a slow but urgent battery value
+    TelemetryScheduler<5> scheduler {{{
+        { "rpm0",  Rate::hz(10.0f), 2 },
+        { "rpm1",  Rate::hz(10.0f), 2 },
+        { "rpm2",  Rate::hz(10.0f), 2 },
+        { "rpm3",  Rate::hz(10.0f), 2 },
+        { "cells", Rate::hz(2.0f),  3 },
+    }}};
+
+    // Fewer slots than the rpm values alone want
+    auto gaps = run_slots(scheduler, 30.0f, 3000);
+    int64_t now = 3000*33333ll;
+
+    EXPECT_GE(scheduler.achieved_mhz(4, now), Rate::hz(1.9f));
+    EXPECT_LE(gaps[4], 500000+33334);
+}
+
+
+TEST(FBus2TelemetryScheduler, round_robin_between_equals)
+{
+    TelemetryScheduler<4> scheduler {{{
+        { "a", Rate::hz(10.0f), 1 },
+        { "b", Rate::hz(10.0f), 1 },
+        { "c", Rate::hz(10.0f), 1 },
+        { "d", Rate::hz(10.0f), 1 },
+    }}};
+
+    run_slots(scheduler, 20.0f, 2001);
+    for (size_t i=0; i<scheduler.size(); ++i) {
+        EXPECT_NEAR(scheduler.count(i), 500u, 1u) << scheduler.config(i).name;
+    }
+}
+
+
+TEST(FBus2TelemetryScheduler, reset_stats)
+{
+    TelemetryScheduler<2> scheduler {{{
+        { "a", Rate::hz(10.0f), 1 },
+        { "b", Rate::hz(10.0f), 1 },
+    }}};
+
+    run_slots(scheduler, 20.0f, 100);
+    scheduler.reset_stats(100*50000ll);
+    EXPECT_EQ(scheduler.count(0), 0u);
+    EXPECT_EQ(scheduler.achieved_mhz(0, 100*50000ll), 0u);
+}
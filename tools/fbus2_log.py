@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+
+# Extract FBus2 recorder logs from captured console output.
+#
+# The receiver dumps its log as "fbus2-log: <hex>" lines, ending with 
+# "fbus2-log: end". Each dump in the capture is written to a binary log, 
+# that can be replayed on the host with: bench_fbus2_receiver <log>
+
+from argparse import ArgumentParser
+from pathlib import Path
+
+
+LOG_PREFIX = 'fbus2-log: '
+LOG_END = 'end'
+
+
+def extract_logs(lines) -> list[bytearray]:
+    logs = []
+    current = None
+    for line in lines:
+        pos = line.find(LOG_PREFIX)
+        if pos<0:
+            continue
+        data = line[pos+len(LOG_PREFIX):].strip()
+        if data==LOG_END:
+            if current:
+                logs.append(current)
+            current = None
+            continue
+        if current is None:
+            current = bytearray()
+        current += bytes.fromhex(data)
+    return logs
+
+
+
+if __name__ == '__main__':
+    parser = ArgumentParser(description='Extract FBus2 recorder logs from console output')
+    parser.add_argument('console_path', type=Path)
+    parser.add_argument('out_prefix', type=str)
+
+    args = parser.parse_args()
+
+    with open(args.console_path, 'r', errors='replace') as file:
+        logs = extract_logs(file)
+
+    for i, log in enumerate(logs):
+        path = Path(f'{args.out_prefix}_{i}.bin')
+        path.write_bytes(log)
+        print(f'{path}: {len(log)} bytes')